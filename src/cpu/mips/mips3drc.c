@@ -27,6 +27,10 @@
 #include "mips3.h"
 #include "x86drc.h"
 
+#if defined(X86DRC_X64) && defined(_WIN64)
+#error "The x86-64 MIPS3 DRC only supports the System V calling convention"
+#endif
+
 /*
 
 	Future optimizations:
@@ -861,21 +865,25 @@ do { 												\
 **	CORE RECOMPILATION
 **#################################################################################################*/
 
-static void ddiv(INT64 *rs, INT64 *rt)
+static void ddiv(UINT32 rsreg, UINT32 rtreg)
 {
-	if (*rt)
+	INT64 rs = mips3.r[rsreg];
+	INT64 rt = mips3.r[rtreg];
+	if (rt)
 	{
-		mips3.lo = *rs / *rt;
-		mips3.hi = *rs % *rt;
+		mips3.lo = rs / rt;
+		mips3.hi = rs % rt;
 	}
 }
 
-static void ddivu(UINT64 *rs, UINT64 *rt)
+static void ddivu(UINT32 rsreg, UINT32 rtreg)
 {
-	if (*rt)
+	UINT64 rs = mips3.r[rsreg];
+	UINT64 rt = mips3.r[rtreg];
+	if (rt)
 	{
-		mips3.lo = *rs / *rt;
-		mips3.hi = *rs % *rt;
+		mips3.lo = rs / rt;
+		mips3.hi = rs % rt;
 	}
 }
 
@@ -947,7 +955,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -967,7 +975,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -984,7 +992,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1004,7 +1012,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1024,7 +1032,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1041,7 +1049,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1058,7 +1066,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1073,7 +1081,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1088,7 +1096,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1103,7 +1111,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1118,7 +1126,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1137,7 +1145,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_write_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1160,7 +1168,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_write_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1180,7 +1188,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1200,7 +1208,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1215,7 +1223,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1230,7 +1238,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1245,7 +1253,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1260,7 +1268,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_can_address(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -3185,15 +3193,15 @@ static UINT32 recompile_special(struct drccore *drc, UINT32 pc, UINT32 op)
 			return RECOMPILE_SUCCESSFUL_CP(8,4);
 					
 		case 0x1e:	/* DDIV */
-			_push_imm(&mips3.r[RTREG]);												/* push	[rtreg]*/
-			_push_imm(&mips3.r[RSREG]);												/* push	[rsreg]*/
+			_push_imm(RTREG);														/* push	rtreg*/
+			_push_imm(RSREG);														/* push	rsreg*/
 			_call((void *)ddiv);													/* call ddiv*/
 			_add_r32_imm(REG_ESP, 8);												/* add	esp,8*/
 			return RECOMPILE_SUCCESSFUL_CP(68,4);
 
 		case 0x1f:	/* DDIVU */
-			_push_imm(&mips3.r[RTREG]);												/* push	[rtreg]*/
-			_push_imm(&mips3.r[RSREG]);												/* push	[rsreg]*/
+			_push_imm(RTREG);														/* push	rtreg*/
+			_push_imm(RSREG);														/* push	rsreg*/
 			_call((void *)ddivu);													/* call ddivu*/
 			_add_r32_imm(REG_ESP, 8);												/* add	esp,8*/
 			return RECOMPILE_SUCCESSFUL_CP(68,4);
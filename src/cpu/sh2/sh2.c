@@ -104,6 +104,19 @@
 /* speed up delay loops, bail out of tight loops */
 #define BUSY_LOOP_HACKS 	1
 
+/* Build with SH2_BLOCK_CACHE=1 to run code from cached blocks, see
+ * sh2_execute_blocks().  The debugger hooks every opcode fetch, so the
+ * interpreter is always used in MAME_DEBUG builds.
+ */
+#if !defined(SH2_BLOCK_CACHE) || defined(MAME_DEBUG)
+#undef SH2_BLOCK_CACHE
+#define SH2_BLOCK_CACHE 	0
+#endif
+
+#if SH2_BLOCK_CACHE
+#include <string.h>
+#endif
+
 typedef struct
 {
 	int irq_vector;
@@ -172,6 +185,26 @@ static void sh2_timer_callback(int data);
 
 #define AM	0x07ffffff
 
+#if SH2_BLOCK_CACHE
+#define SH2_CODE_PAGE_SHIFT 	9
+
+static UINT8 sh2_code_pages[(AM >> SH2_CODE_PAGE_SHIFT) / 8 + 1];	/* pages holding cached blocks */
+static UINT32 sh2_block_stamp;		/* moves whenever cached code may have changed */
+
+/* Writes into cached code, and writes whose handler wrote memory in turn,
+   make the blocks compare their bytes again */
+#define SH2_BLOCK_WRITE(A, write)												\
+do {																			\
+	UINT32 writes = memory_writes;												\
+	UINT32 page = ((A) & AM) >> SH2_CODE_PAGE_SHIFT;							\
+	write;																		\
+	if (memory_writes != writes + 1 || (sh2_code_pages[page >> 3] & (1 << (page & 7))))	\
+		sh2_block_stamp++;														\
+} while (0)
+#else
+#define SH2_BLOCK_WRITE(A, write)	write
+#endif
+
 #define FLAGS	(M|Q|I|S|T)
 
 #define Rn	((opcode>>8)&15)
@@ -230,14 +263,14 @@ static INLINE void WB(offs_t A, data8_t V)
 
 	if (A >= 0xc0000000)
 	{
-		cpu_writemem32bedw(A,V);
+		SH2_BLOCK_WRITE(A, cpu_writemem32bedw(A,V));
 		return;
 	}
 
 	if (A >= 0x40000000)
 		return;
 
-	cpu_writemem32bedw(A & AM,V);
+	SH2_BLOCK_WRITE(A, cpu_writemem32bedw(A & AM,V));
 }
 
 static INLINE void WW(offs_t A, data16_t V)
@@ -250,14 +283,14 @@ static INLINE void WW(offs_t A, data16_t V)
 
 	if (A >= 0xc0000000)
 	{
-		cpu_writemem32bedw_word(A,V);
+		SH2_BLOCK_WRITE(A, cpu_writemem32bedw_word(A,V));
 		return;
 	}
 
 	if (A >= 0x40000000)
 		return;
 
-	cpu_writemem32bedw_word(A & AM,V);
+	SH2_BLOCK_WRITE(A, cpu_writemem32bedw_word(A & AM,V));
 }
 
 static INLINE void WL(offs_t A, data32_t V)
@@ -270,14 +303,14 @@ static INLINE void WL(offs_t A, data32_t V)
 
 	if (A >= 0xc0000000)
 	{
-		cpu_writemem32bedw_dword(A,V);
+		SH2_BLOCK_WRITE(A, cpu_writemem32bedw_dword(A,V));
 		return;
 	}
 
 	if (A >= 0x40000000)
 		return;
 
-	cpu_writemem32bedw_dword(A & AM,V);
+	SH2_BLOCK_WRITE(A, cpu_writemem32bedw_dword(A & AM,V));
 }
 
 static INLINE void sh2_exception(const char *message, int irqline)
@@ -2284,6 +2317,477 @@ static INLINE void op1111(UINT16 opcode)
 	NOP();
 }
 
+/* One pass of the interpreter's main loop */
+static INLINE void sh2_execute_one(void)
+{
+	UINT32 opcode;
+
+	if (sh2.delay)
+	{
+		opcode = RW(sh2.delay & AM);
+		change_pc32bedw(sh2.pc & AM);
+		sh2.pc -= 2;
+	}
+	else
+		opcode = RW(sh2.pc & AM);
+
+	CALL_MAME_DEBUG;
+
+	sh2.delay = 0;
+	sh2.pc += 2;
+	sh2.ppc = sh2.pc;
+
+	switch ((opcode >> 12) & 15)
+	{
+	case  0: op0000(opcode); break;
+	case  1: op0001(opcode); break;
+	case  2: op0010(opcode); break;
+	case  3: op0011(opcode); break;
+	case  4: op0100(opcode); break;
+	case  5: op0101(opcode); break;
+	case  6: op0110(opcode); break;
+	case  7: op0111(opcode); break;
+	case  8: op1000(opcode); break;
+	case  9: op1001(opcode); break;
+	case 10: op1010(opcode); break;
+	case 11: op1011(opcode); break;
+	case 12: op1100(opcode); break;
+	case 13: op1101(opcode); break;
+	case 14: op1110(opcode); break;
+	default: op1111(opcode); break;
+	}
+
+	if(sh2.test_irq && !sh2.delay)
+	{
+		CHECK_PENDING_IRQ("mame_sh2_execute");
+		sh2.test_irq = 0;
+	}
+	sh2_icount--;
+}
+
+#if SH2_BLOCK_CACHE
+
+/*****************************************************************************
+ *	BLOCK CACHE
+ *****************************************************************************/
+
+/* Straight runs of code are recorded the second time they are reached: the
+ * address and opcode word of every instruction, up to and including the
+ * delay slot of a branch, together with the handler for that one
+ * instruction.  Running a block again replays the records instead of
+ * fetching each opcode through the memory system and decoding it.  The
+ * handlers are the interpreter's, so the T bit, delay slots, cycle counts
+ * and interrupt checks behave exactly as they do without the cache.
+ *
+ * Only code the memory system can hand out a pointer for (RAM, ROM and
+ * banks) is cached.  A block keeps a copy of the bytes it covers.  They are
+ * compared again whenever sh2_block_stamp has moved since the block was
+ * last checked, which happens at the start of every timeslice, on writes to
+ * a page holding cached code and on writes whose handler wrote memory
+ * itself; so code that is overwritten, loaded by DMA or banked out is
+ * recorded again.  A block is left as soon as the next fetch is not the
+ * next record.
+ */
+
+#define SH2_BLOCK_COUNT 	4096	/* direct mapped on the start address */
+#define SH2_BLOCK_OPS		32		/* most instructions in a block */
+#define SH2_BLOCK_BYTES 	128 	/* most bytes covered by a block, from its start address on */
+
+typedef struct
+{
+	UINT32	addr;			/* address the opcode is fetched from */
+	UINT16	opcode;
+	void	(*handler)(UINT16 opcode);
+} sh2_block_op;
+
+typedef struct
+{
+	UINT32	pc; 			/* sh2.pc at the start of the block */
+	UINT8	*base;			/* memory holding the bytes */
+	UINT32	start;			/* bytes covered, longword aligned */
+	UINT32	size;
+	UINT32	stamp;			/* sh2_block_stamp when the bytes were last compared */
+	UINT32	count;			/* 0 if this code can't be cached */
+	UINT32	pending;		/* seen once, record it when it comes back */
+	sh2_block_op op[SH2_BLOCK_OPS];
+	UINT8	bytes[SH2_BLOCK_BYTES];
+} sh2_block;
+
+static sh2_block sh2_blocks[SH2_BLOCK_COUNT];
+
+static void (*const sh2_op_group[16])(UINT16 opcode) =
+{
+	op0000, op0001, op0010, op0011, op0100, op0101, op0110, op0111,
+	op1000, op1001, op1010, op1011, op1100, op1101, op1110, op1111
+};
+
+/* Handlers for single instructions, so that the common ones skip the
+   second level of decoding in op0000() etc. */
+#define SH2_BLOCK_HANDLER(name, call) static void sh2_block_##name(UINT16 opcode) { call; }
+
+SH2_BLOCK_HANDLER(NOP,		NOP())
+SH2_BLOCK_HANDLER(CLRT, 	CLRT())
+SH2_BLOCK_HANDLER(SETT, 	SETT())
+SH2_BLOCK_HANDLER(RTS,		RTS())
+SH2_BLOCK_HANDLER(MOVT, 	MOVT(Rn))
+SH2_BLOCK_HANDLER(STSMACL,	STSMACL(Rn))
+SH2_BLOCK_HANDLER(STSPR,	STSPR(Rn))
+SH2_BLOCK_HANDLER(MOVBS0,	MOVBS0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWS0,	MOVWS0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLS0,	MOVLS0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVBL0,	MOVBL0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWL0,	MOVWL0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLL0,	MOVLL0(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVBS,	MOVBS(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWS,	MOVWS(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLS,	MOVLS(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVBM,	MOVBM(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWM,	MOVWM(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLM,	MOVLM(Rm, Rn))
+SH2_BLOCK_HANDLER(TST,		TST(Rm, Rn))
+SH2_BLOCK_HANDLER(AND,		AND(Rm, Rn))
+SH2_BLOCK_HANDLER(XOR,		XOR(Rm, Rn))
+SH2_BLOCK_HANDLER(OR,		OR(Rm, Rn))
+SH2_BLOCK_HANDLER(CMPEQ,	CMPEQ(Rm, Rn))
+SH2_BLOCK_HANDLER(CMPHS,	CMPHS(Rm, Rn))
+SH2_BLOCK_HANDLER(CMPGE,	CMPGE(Rm, Rn))
+SH2_BLOCK_HANDLER(CMPHI,	CMPHI(Rm, Rn))
+SH2_BLOCK_HANDLER(CMPGT,	CMPGT(Rm, Rn))
+SH2_BLOCK_HANDLER(SUB,		SUB(Rm, Rn))
+SH2_BLOCK_HANDLER(ADD,		ADD(Rm, Rn))
+SH2_BLOCK_HANDLER(SHLL, 	SHLL(Rn))
+SH2_BLOCK_HANDLER(SHLR, 	SHLR(Rn))
+SH2_BLOCK_HANDLER(ROTL, 	ROTL(Rn))
+SH2_BLOCK_HANDLER(ROTR, 	ROTR(Rn))
+SH2_BLOCK_HANDLER(SHLL2,	SHLL2(Rn))
+SH2_BLOCK_HANDLER(SHLR2,	SHLR2(Rn))
+SH2_BLOCK_HANDLER(JSR,		JSR(Rn))
+SH2_BLOCK_HANDLER(DT,		DT(Rn))
+SH2_BLOCK_HANDLER(CMPPZ,	CMPPZ(Rn))
+SH2_BLOCK_HANDLER(CMPPL,	CMPPL(Rn))
+SH2_BLOCK_HANDLER(SHLL8,	SHLL8(Rn))
+SH2_BLOCK_HANDLER(SHLR8,	SHLR8(Rn))
+SH2_BLOCK_HANDLER(SHAL, 	SHAL(Rn))
+SH2_BLOCK_HANDLER(SHAR, 	SHAR(Rn))
+SH2_BLOCK_HANDLER(STSMPR,	STSMPR(Rn))
+SH2_BLOCK_HANDLER(ROTCL,	ROTCL(Rn))
+SH2_BLOCK_HANDLER(ROTCR,	ROTCR(Rn))
+SH2_BLOCK_HANDLER(LDSMPR,	LDSMPR(Rn))
+SH2_BLOCK_HANDLER(SHLL16,	SHLL16(Rn))
+SH2_BLOCK_HANDLER(SHLR16,	SHLR16(Rn))
+SH2_BLOCK_HANDLER(JMP,		JMP(Rn))
+SH2_BLOCK_HANDLER(MOVBL,	MOVBL(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWL,	MOVWL(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLL,	MOVLL(Rm, Rn))
+SH2_BLOCK_HANDLER(MOV,		MOV(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVBP,	MOVBP(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVWP,	MOVWP(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVLP,	MOVLP(Rm, Rn))
+SH2_BLOCK_HANDLER(NOT,		NOT(Rm, Rn))
+SH2_BLOCK_HANDLER(SWAPB,	SWAPB(Rm, Rn))
+SH2_BLOCK_HANDLER(SWAPW,	SWAPW(Rm, Rn))
+SH2_BLOCK_HANDLER(NEG,		NEG(Rm, Rn))
+SH2_BLOCK_HANDLER(EXTUB,	EXTUB(Rm, Rn))
+SH2_BLOCK_HANDLER(EXTUW,	EXTUW(Rm, Rn))
+SH2_BLOCK_HANDLER(EXTSB,	EXTSB(Rm, Rn))
+SH2_BLOCK_HANDLER(EXTSW,	EXTSW(Rm, Rn))
+SH2_BLOCK_HANDLER(MOVBS4,	MOVBS4(opcode & 0x0f, Rm))
+SH2_BLOCK_HANDLER(MOVWS4,	MOVWS4(opcode & 0x0f, Rm))
+SH2_BLOCK_HANDLER(MOVBL4,	MOVBL4(Rm, opcode & 0x0f))
+SH2_BLOCK_HANDLER(MOVWL4,	MOVWL4(Rm, opcode & 0x0f))
+SH2_BLOCK_HANDLER(CMPIM,	CMPIM(opcode & 0xff))
+SH2_BLOCK_HANDLER(BT,		BT(opcode & 0xff))
+SH2_BLOCK_HANDLER(BF,		BF(opcode & 0xff))
+SH2_BLOCK_HANDLER(BTS,		BTS(opcode & 0xff))
+SH2_BLOCK_HANDLER(BFS,		BFS(opcode & 0xff))
+SH2_BLOCK_HANDLER(MOVLSG,	MOVLSG(opcode & 0xff))
+SH2_BLOCK_HANDLER(MOVLLG,	MOVLLG(opcode & 0xff))
+SH2_BLOCK_HANDLER(MOVA, 	MOVA(opcode & 0xff))
+SH2_BLOCK_HANDLER(TSTI, 	TSTI(opcode & 0xff))
+SH2_BLOCK_HANDLER(ANDI, 	ANDI(opcode & 0xff))
+SH2_BLOCK_HANDLER(XORI, 	XORI(opcode & 0xff))
+SH2_BLOCK_HANDLER(ORI,		ORI(opcode & 0xff))
+
+static const struct
+{
+	UINT16	mask, match;
+	void	(*handler)(UINT16 opcode);
+} sh2_block_decode[] =
+{
+	{ 0xf03f, 0x0009, sh2_block_NOP },
+	{ 0xf03f, 0x0008, sh2_block_CLRT },
+	{ 0xf03f, 0x0018, sh2_block_SETT },
+	{ 0xf03f, 0x000b, sh2_block_RTS },
+	{ 0xf03f, 0x0029, sh2_block_MOVT },
+	{ 0xf03f, 0x001a, sh2_block_STSMACL },
+	{ 0xf03f, 0x002a, sh2_block_STSPR },
+	{ 0xf00f, 0x0004, sh2_block_MOVBS0 },
+	{ 0xf00f, 0x0005, sh2_block_MOVWS0 },
+	{ 0xf00f, 0x0006, sh2_block_MOVLS0 },
+	{ 0xf00f, 0x000c, sh2_block_MOVBL0 },
+	{ 0xf00f, 0x000d, sh2_block_MOVWL0 },
+	{ 0xf00f, 0x000e, sh2_block_MOVLL0 },
+	{ 0xf00f, 0x2000, sh2_block_MOVBS },
+	{ 0xf00f, 0x2001, sh2_block_MOVWS },
+	{ 0xf00f, 0x2002, sh2_block_MOVLS },
+	{ 0xf00f, 0x2004, sh2_block_MOVBM },
+	{ 0xf00f, 0x2005, sh2_block_MOVWM },
+	{ 0xf00f, 0x2006, sh2_block_MOVLM },
+	{ 0xf00f, 0x2008, sh2_block_TST },
+	{ 0xf00f, 0x2009, sh2_block_AND },
+	{ 0xf00f, 0x200a, sh2_block_XOR },
+	{ 0xf00f, 0x200b, sh2_block_OR },
+	{ 0xf00f, 0x3000, sh2_block_CMPEQ },
+	{ 0xf00f, 0x3002, sh2_block_CMPHS },
+	{ 0xf00f, 0x3003, sh2_block_CMPGE },
+	{ 0xf00f, 0x3006, sh2_block_CMPHI },
+	{ 0xf00f, 0x3007, sh2_block_CMPGT },
+	{ 0xf00f, 0x3008, sh2_block_SUB },
+	{ 0xf00f, 0x300c, sh2_block_ADD },
+	{ 0xf03f, 0x4000, sh2_block_SHLL },
+	{ 0xf03f, 0x4001, sh2_block_SHLR },
+	{ 0xf03f, 0x4004, sh2_block_ROTL },
+	{ 0xf03f, 0x4005, sh2_block_ROTR },
+	{ 0xf03f, 0x4008, sh2_block_SHLL2 },
+	{ 0xf03f, 0x4009, sh2_block_SHLR2 },
+	{ 0xf03f, 0x400b, sh2_block_JSR },
+	{ 0xf03f, 0x4010, sh2_block_DT },
+	{ 0xf03f, 0x4011, sh2_block_CMPPZ },
+	{ 0xf03f, 0x4015, sh2_block_CMPPL },
+	{ 0xf03f, 0x4018, sh2_block_SHLL8 },
+	{ 0xf03f, 0x4019, sh2_block_SHLR8 },
+	{ 0xf03f, 0x4020, sh2_block_SHAL },
+	{ 0xf03f, 0x4021, sh2_block_SHAR },
+	{ 0xf03f, 0x4022, sh2_block_STSMPR },
+	{ 0xf03f, 0x4024, sh2_block_ROTCL },
+	{ 0xf03f, 0x4025, sh2_block_ROTCR },
+	{ 0xf03f, 0x4026, sh2_block_LDSMPR },
+	{ 0xf03f, 0x4028, sh2_block_SHLL16 },
+	{ 0xf03f, 0x4029, sh2_block_SHLR16 },
+	{ 0xf03f, 0x402b, sh2_block_JMP },
+	{ 0xf00f, 0x6000, sh2_block_MOVBL },
+	{ 0xf00f, 0x6001, sh2_block_MOVWL },
+	{ 0xf00f, 0x6002, sh2_block_MOVLL },
+	{ 0xf00f, 0x6003, sh2_block_MOV },
+	{ 0xf00f, 0x6004, sh2_block_MOVBP },
+	{ 0xf00f, 0x6005, sh2_block_MOVWP },
+	{ 0xf00f, 0x6006, sh2_block_MOVLP },
+	{ 0xf00f, 0x6007, sh2_block_NOT },
+	{ 0xf00f, 0x6008, sh2_block_SWAPB },
+	{ 0xf00f, 0x6009, sh2_block_SWAPW },
+	{ 0xf00f, 0x600b, sh2_block_NEG },
+	{ 0xf00f, 0x600c, sh2_block_EXTUB },
+	{ 0xf00f, 0x600d, sh2_block_EXTUW },
+	{ 0xf00f, 0x600e, sh2_block_EXTSB },
+	{ 0xf00f, 0x600f, sh2_block_EXTSW },
+	{ 0xff00, 0x8000, sh2_block_MOVBS4 },
+	{ 0xff00, 0x8100, sh2_block_MOVWS4 },
+	{ 0xff00, 0x8400, sh2_block_MOVBL4 },
+	{ 0xff00, 0x8500, sh2_block_MOVWL4 },
+	{ 0xff00, 0x8800, sh2_block_CMPIM },
+	{ 0xff00, 0x8900, sh2_block_BT },
+	{ 0xff00, 0x8b00, sh2_block_BF },
+	{ 0xff00, 0x8d00, sh2_block_BTS },
+	{ 0xff00, 0x8f00, sh2_block_BFS },
+	{ 0xff00, 0xc200, sh2_block_MOVLSG },
+	{ 0xff00, 0xc600, sh2_block_MOVLLG },
+	{ 0xff00, 0xc700, sh2_block_MOVA },
+	{ 0xff00, 0xc800, sh2_block_TSTI },
+	{ 0xff00, 0xc900, sh2_block_ANDI },
+	{ 0xff00, 0xca00, sh2_block_XORI },
+	{ 0xff00, 0xcb00, sh2_block_ORI }
+};
+
+/* The handler that runs this opcode, the group handler for the rarer ones */
+static void (*sh2_block_handler(UINT16 opcode))(UINT16 opcode)
+{
+	int i;
+
+	for (i = 0; i < sizeof(sh2_block_decode) / sizeof(sh2_block_decode[0]); i++)
+		if ((opcode & sh2_block_decode[i].mask) == sh2_block_decode[i].match)
+			return sh2_block_decode[i].handler;
+	return sh2_op_group[(opcode >> 12) & 15];
+}
+
+/* Pointer to the memory RW() reads an opcode from, NULL if it goes through a handler */
+static INLINE UINT8 *sh2_block_ptr(UINT32 A)
+{
+	return memory_get_read_ptr(sh2.cpu_number, A & AM);
+}
+
+/* Are the bytes of the block still in place? */
+static INLINE int sh2_block_valid(sh2_block *block)
+{
+	UINT8 *base;
+
+	/* nothing written to code and still running from the same memory */
+	if (block->stamp == sh2_block_stamp && OP_ROM + block->start == block->base)
+		return 1;
+
+	base = sh2_block_ptr(block->start);
+	if (base != block->base || memcmp(block->bytes, base, block->size))
+		return 0;
+	block->stamp = sh2_block_stamp;
+	return 1;
+}
+
+/* Run instructions with the interpreter, recording them into the block */
+static void sh2_record_block(sh2_block *block)
+{
+	UINT32 count = 0;
+	UINT32 stamp = sh2_block_stamp;
+	UINT32 start = block->pc & AM & ~3;
+	UINT32 end = start;
+	UINT32 fetch, next, opcode, page, i;
+	UINT8 *base;
+
+	block->pending = 0;
+	block->count = 0;
+	for (;;)
+	{
+		sh2_block_op *op = &block->op[count];
+
+		/* the same steps as sh2_execute_one() */
+		if (sh2.delay)
+		{
+			fetch = sh2.delay;
+			opcode = RW(sh2.delay & AM);
+			change_pc32bedw(sh2.pc & AM);
+			sh2.pc -= 2;
+		}
+		else
+		{
+			fetch = sh2.pc;
+			opcode = RW(sh2.pc & AM);
+		}
+
+		sh2.delay = 0;
+		sh2.pc += 2;
+		sh2.ppc = sh2.pc;
+
+		op->addr = fetch;
+		op->opcode = opcode;
+		op->handler = sh2_block_handler(opcode);
+		count++;
+
+		op->handler(opcode);
+
+		if(sh2.test_irq && !sh2.delay)
+		{
+			CHECK_PENDING_IRQ("mame_sh2_execute");
+			sh2.test_irq = 0;
+		}
+		sh2_icount--;
+
+		if ((fetch & AM) + 2 > end)
+			end = ((fetch & AM) + 2 + 3) & ~3;
+
+		/* follow the path taken, branches included, as long as it stays
+		   close enough for one copy of the bytes to cover it */
+		next = (sh2.delay ? sh2.delay : sh2.pc) & AM;
+		if (count == SH2_BLOCK_OPS || sh2_icount <= 0 || next < start || next + 2 > start + SH2_BLOCK_BYTES)
+			break;
+	}
+
+	base = sh2_block_ptr(start);
+	if (!base || end > start + SH2_BLOCK_BYTES || sh2_block_ptr(end - 4) != base + (end - start) - 4)
+		return;
+
+	/* code that changed while it was recorded has to be recorded again */
+	if (sh2_block_stamp != stamp)
+		for (i = 0; i < count; i++)
+			if (RW(block->op[i].addr & AM) != block->op[i].opcode)
+			{
+				block->pending = 1;
+				return;
+			}
+
+	/* writes to these pages move the stamp from now on */
+	for (page = start >> SH2_CODE_PAGE_SHIFT; page <= (end - 1) >> SH2_CODE_PAGE_SHIFT; page++)
+		sh2_code_pages[page >> 3] |= 1 << (page & 7);
+
+	block->base = base;
+	block->start = start;
+	block->size = end - start;
+	memcpy(block->bytes, base, block->size);
+	block->stamp = sh2_block_stamp;
+	block->count = count;
+}
+
+/* Replay a block until the next fetch leaves it */
+static void sh2_run_block(sh2_block *block)
+{
+	sh2_block_op *op = block->op;
+	sh2_block_op *last = op + block->count - 1;
+	UINT32 stamp = sh2_block_stamp;
+	UINT8 *rom = OP_ROM;
+
+	for (;;)
+	{
+		/* what sh2_execute_one() does, without reading the opcode again */
+		if (sh2.delay)
+		{
+			change_pc32bedw(sh2.pc & AM);
+			sh2.pc -= 2;
+		}
+
+		sh2.delay = 0;
+		sh2.pc += 2;
+		sh2.ppc = sh2.pc;
+
+		op->handler(op->opcode);
+
+		if(sh2.test_irq && !sh2.delay)
+		{
+			CHECK_PENDING_IRQ("mame_sh2_execute");
+			sh2.test_irq = 0;
+		}
+		sh2_icount--;
+
+		if (op == last || sh2_icount <= 0 || (sh2.delay ? sh2.delay : sh2.pc) != (++op)->addr)
+			return;
+
+		/* the rest of the block may have been overwritten or banked out */
+		if (sh2_block_stamp != stamp || OP_ROM != rom)
+		{
+			if (!sh2_block_valid(block))
+				return;
+			stamp = sh2_block_stamp;
+			rom = OP_ROM;
+		}
+	}
+}
+
+static void sh2_execute_blocks(void)
+{
+	do
+	{
+		sh2_block *block = &sh2_blocks[(sh2.pc >> 1) & (SH2_BLOCK_COUNT - 1)];
+
+		/* blocks start on an instruction of their own, never in a delay slot */
+		if (sh2.delay)
+			sh2_execute_one();
+		else if (block->pc != sh2.pc)
+		{
+			/* code that only runs once isn't worth recording */
+			block->pc = sh2.pc;
+			block->count = 0;
+			block->pending = 1;
+			sh2_execute_one();
+		}
+		else if (block->pending)
+			sh2_record_block(block);
+		else if (!block->count)
+			sh2_execute_one();
+		else if (!sh2_block_valid(block))
+			sh2_record_block(block);
+		else
+			sh2_run_block(block);
+	} while( sh2_icount > 0 );
+}
+
+#endif /* SH2_BLOCK_CACHE */
+
 /*****************************************************************************
  *	MAME CPU INTERFACE
  *****************************************************************************/
@@ -2337,52 +2841,16 @@ int sh2_execute(int cycles)
 	if (sh2.cpu_off)
 		return 0;
 
+#if SH2_BLOCK_CACHE
+	/* the other CPUs and DMA may have written code since the last timeslice */
+	sh2_block_stamp++;
+	sh2_execute_blocks();
+#else
 	do
 	{
-		UINT32 opcode;
-
-		if (sh2.delay)
-		{
-			opcode = RW(sh2.delay & AM);
-			change_pc32bedw(sh2.pc & AM);
-			sh2.pc -= 2;
-		}
-		else
-			opcode = RW(sh2.pc & AM);
-
-		CALL_MAME_DEBUG;
-
-		sh2.delay = 0;
-		sh2.pc += 2;
-		sh2.ppc = sh2.pc;
-
-		switch ((opcode >> 12) & 15)
-		{
-		case  0: op0000(opcode); break;
-		case  1: op0001(opcode); break;
-		case  2: op0010(opcode); break;
-		case  3: op0011(opcode); break;
-		case  4: op0100(opcode); break;
-		case  5: op0101(opcode); break;
-		case  6: op0110(opcode); break;
-		case  7: op0111(opcode); break;
-		case  8: op1000(opcode); break;
-		case  9: op1001(opcode); break;
-		case 10: op1010(opcode); break;
-		case 11: op1011(opcode); break;
-		case 12: op1100(opcode); break;
-		case 13: op1101(opcode); break;
-		case 14: op1110(opcode); break;
-		default: op1111(opcode); break;
-		}
-
-		if(sh2.test_irq && !sh2.delay)
-		{
-			CHECK_PENDING_IRQ("mame_sh2_execute");
-			sh2.test_irq = 0;
-		}
-		sh2_icount--;
+		sh2_execute_one();
 	} while( sh2_icount > 0 );
+#endif /* SH2_BLOCK_CACHE */
 
 	return cycles - sh2_icount;
 }
@@ -3110,6 +3578,12 @@ void sh2_init(void)
 	state_save_register_UINT32("sh2", cpu, "R13", &sh2.r[13], 1);
 	state_save_register_UINT32("sh2", cpu, "R14", &sh2.r[14], 1);
 	state_save_register_UINT32("sh2", cpu, "EA", &sh2.ea, 1);
+
+#if SH2_BLOCK_CACHE
+	/* forget the blocks of the previous game */
+	memset(sh2_blocks, 0, sizeof(sh2_blocks));
+	memset(sh2_code_pages, 0, sizeof(sh2_code_pages));
+#endif
 	return;
 }
 
@@ -12,12 +12,25 @@
 #include "state.h"
 #include "mamedbg.h"
 #include "cpuexec.h"
+#include "fileio.h"
 #include "log.h"
 
 
+/* set to 1 to trace every timeslice through log_cb; compiled out otherwise */
+#define VERBOSE 0
+
+#define LOG(x)	do { if (VERBOSE) log_cb x; } while (0)
+
+
 #if (HAS_M68000 || HAS_M68010 || HAS_M68020 || HAS_M68EC020)
 #include "cpu/m68000/m68000.h"
 #endif
+#if (HAS_Z80)
+#include "cpu/z80/z80.h"
+#endif
+#if (HAS_Z180)
+#include "cpu/z180/z180.h"
+#endif
 
 /*************************************
  *
@@ -122,8 +135,13 @@ struct cpuinfo
 	int 	iloops; 				/* number of interrupts remaining this frame */
 
 	UINT64 	totalcycles;			/* total CPU cycles executed */
-	double	localtime;				/* local time, relative to the timer system's global time */
+	mame_ticks localtime;			/* local time, relative to the timer system's global time */
+	UINT32	localtime_frac;			/* fraction of a tick carried over, in 1/2^32 units */
 	double	clockscale;				/* current active clock scale factor */
+
+	mame_ticks cycle_ticks;			/* ticks per cycle, integer part */
+	UINT32	cycle_ticks_frac;		/* ticks per cycle, fractional part in 1/2^32 units */
+	double	cycles_per_tick;		/* inverse, for computing how long to run */
 	
 	int 	vblankint_countdown;	/* number of vblank callbacks left until we interrupt */
 	int 	vblankint_multiplier;	/* number of vblank callbacks per interrupt */
@@ -132,6 +150,16 @@ struct cpuinfo
 	
 	void *	timedint_timer;			/* reference to this CPU's timer */
 	double	timedint_period; 		/* timing period of the timed interrupt */
+
+	UINT8 *	idle_regs;				/* registers compared by the idle loop detection */
+	int		idle_nregs;				/* number of them (0 = detection off) */
+	unsigned *idle_history;			/* register snapshots of the current probe */
+	int		idle_candidate;			/* true if the last slice made no writes */
+	int		idle_backoff;			/* slices to wait after a failed probe */
+	int		idle_delay;				/* slices left until the next probe */
+	UINT64	idle_cycles;			/* total cycles skipped */
+	UINT32	idle_loops;				/* number of idle loops detected */
+	offs_t	idle_pc;				/* PC of the last one */
 };
 
 
@@ -156,6 +184,308 @@ static int cycles_stolen;
 
 
 
+/*************************************
+ *
+ *	Idle loop detection
+ *
+ *	A CPU spinning in a wait loop reads memory or ports but writes
+ *	nothing, and comes back to the same register state every trip
+ *	around the loop. When a slice made no writes, the next one is run
+ *	in short probes and the registers are compared after each; if a
+ *	state repeats without any write in between, nothing but an
+ *	interrupt or a timer can get the CPU out, so the rest of the slice
+ *	is skipped. Failed probes back off exponentially.
+ *
+ *************************************/
+
+#define IDLE_HISTORY		8		/* probes per slice */
+#define IDLE_PROBE_CYCLES	64		/* cycles per probe */
+#define IDLE_MIN_SLICE		(4 * IDLE_HISTORY * IDLE_PROBE_CYCLES)
+#define IDLE_MAX_BACKOFF	64		/* slices */
+
+static void idle_init(int cpunum)
+{
+	const UINT8 *layout = (const UINT8 *)cpunum_reg_layout(cpunum);
+	struct cpuinfo *info = &cpu[cpunum];
+	int count = 0, i;
+
+	for (i = 0; layout[i]; i++)
+		if (layout[i] != 0xff)
+			count++;
+	if (!count)
+		return;
+
+	info->idle_regs = malloc(count);
+	info->idle_history = malloc(IDLE_HISTORY * count * sizeof(info->idle_history[0]));
+	if (!info->idle_regs || !info->idle_history)
+	{
+		free(info->idle_regs);
+		free(info->idle_history);
+		info->idle_regs = NULL;
+		info->idle_history = NULL;
+		return;
+	}
+
+	/* the Z80 refresh counter changes on every instruction */
+	for (i = 0; layout[i]; i++)
+	{
+		if (layout[i] == 0xff)
+			continue;
+#if (HAS_Z80)
+		if (Machine->drv->cpu[cpunum].cpu_type == CPU_Z80 && layout[i] == Z80_R)
+			continue;
+#endif
+#if (HAS_Z180)
+		if (Machine->drv->cpu[cpunum].cpu_type == CPU_Z180 && layout[i] == Z180_R)
+			continue;
+#endif
+		info->idle_regs[info->idle_nregs++] = layout[i];
+	}
+}
+
+static void idle_exit(int cpunum)
+{
+	struct cpuinfo *info = &cpu[cpunum];
+
+	if (info->idle_nregs && info->totalcycles)
+		log_cb(RETRO_LOG_INFO, LOGPRE "Idle loop detection: CPU #%d skipped %.1f%% of its cycles in %u loops, last at PC=%X\n",
+				cpunum, (double)info->idle_cycles * 100.0 / info->totalcycles, info->idle_loops, info->idle_pc);
+
+	free(info->idle_regs);
+	free(info->idle_history);
+	info->idle_regs = NULL;
+	info->idle_history = NULL;
+	info->idle_nregs = 0;
+}
+
+
+
+/*************************************
+ *
+ *	Exact conversion between cycles
+ *	and timer ticks
+ *
+ *************************************/
+
+static void compute_cycle_times(int cpunum)
+{
+	double ticks_per_cycle;
+
+	sec_to_cycles[cpunum] = cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock;
+	cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
+
+	/* the period of a cycle as a 32.32 fixed point number of ticks */
+	ticks_per_cycle = (double)TICKS_PER_SEC / sec_to_cycles[cpunum];
+	cpu[cpunum].cycle_ticks = (mame_ticks)ticks_per_cycle;
+	cpu[cpunum].cycle_ticks_frac = (UINT32)((ticks_per_cycle - (double)cpu[cpunum].cycle_ticks) * 4294967296.0);
+	cpu[cpunum].cycles_per_tick = sec_to_cycles[cpunum] / (double)TICKS_PER_SEC;
+}
+
+/* advance a CPU's local time by a number of cycles, carrying the fraction */
+static INLINE void add_local_cycles(int cpunum, int cycles)
+{
+	UINT64 frac = (UINT64)cycles * cpu[cpunum].cycle_ticks_frac + cpu[cpunum].localtime_frac;
+
+	cpu[cpunum].localtime += (mame_ticks)cycles * cpu[cpunum].cycle_ticks + (mame_ticks)(frac >> 32);
+	cpu[cpunum].localtime_frac = (UINT32)frac;
+}
+
+/* number of whole cycles that fit in a span of ticks */
+static INLINE int ticks_to_cycles(int cpunum, mame_ticks ticks)
+{
+	double cycles = (double)ticks * cpu[cpunum].cycles_per_tick;
+
+	if (cycles > (double)0x3fffffff)
+		return 0x3fffffff;
+	return (int)cycles;
+}
+
+
+
+/*************************************
+ *
+ *	Scheduler statistics
+ *
+ *	With the "Scheduler statistics"
+ *	option on, the counters for each
+ *	frame go into a ring of the last
+ *	SCHED_STATS_FRAMES frames, which
+ *	is summarized to the log and
+ *	written out as CSV on exit.
+ *
+ *************************************/
+
+#if (SCHED_STATS_CPUS != MAX_CPU)
+#error SCHED_STATS_CPUS must match MAX_CPU
+#endif
+
+static struct sched_frame_stats *sched_stats;	/* the ring, NULL when disabled */
+static struct sched_frame_stats *sched_frame;	/* record of the current frame */
+static int sched_stats_pos;						/* index of the current frame */
+static int sched_stats_count;					/* completed frames in the ring */
+
+static void sched_stats_init(void)
+{
+	sched_stats_pos = sched_stats_count = 0;
+	sched_frame = NULL;
+	timer_stats_enable(options.sched_stats);
+	if (!options.sched_stats)
+		return;
+
+	sched_stats = calloc(SCHED_STATS_FRAMES, sizeof(*sched_stats));
+	if (!sched_stats)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Scheduler statistics: out of memory, disabled\n");
+		timer_stats_enable(0);
+		return;
+	}
+	sched_frame = &sched_stats[0];
+}
+
+/* close the current frame's record and start the next one */
+static void sched_stats_frame_end(void)
+{
+	int slot;
+
+	sched_frame->frame = current_frame;
+	timer_stats_collect(sched_frame->timer_fired);
+	for (slot = 0; slot < TIMER_STATS_CALLBACKS; slot++)
+		sched_frame->timers_fired += sched_frame->timer_fired[slot];
+
+	sched_stats_pos = (sched_stats_pos + 1) % SCHED_STATS_FRAMES;
+	if (sched_stats_count < SCHED_STATS_FRAMES)
+		sched_stats_count++;
+	sched_frame = &sched_stats[sched_stats_pos];
+	memset(sched_frame, 0, sizeof(*sched_frame));
+}
+
+const struct sched_frame_stats *cpu_get_sched_stats(int *first, int *count)
+{
+	*first = (sched_stats_pos + SCHED_STATS_FRAMES - sched_stats_count) % SCHED_STATS_FRAMES;
+	*count = sched_stats_count;
+	return sched_stats;
+}
+
+static void sched_stats_write_csv(int first)
+{
+	char filename[64];
+	FILE *file;
+	int i, cpunum, slot;
+
+	snprintf(filename, sizeof(filename), "%s_sched.csv", Machine->gamedrv->name);
+	file = osd_fopen(FILETYPE_PROFILE, 0, filename, "w");
+	if (!file)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Scheduler statistics: unable to write %s\n", filename);
+		return;
+	}
+
+	fprintf(file, "frame,timeslices,boosts,boost_us,timers");
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		fprintf(file, ",cpu%d_slices,cpu%d_cycles,cpu%d_aborts", cpunum, cpunum, cpunum);
+	/* name each callback by its offset from timer_init; unlike the address */
+	/* itself, that stays the same from run to run when the core is relocated */
+	for (slot = 0; slot < TIMER_STATS_CALLBACKS; slot++)
+	{
+		void (*callback)(int) = timer_stats_callback(slot);
+		if (callback)
+		{
+			size_t callback_addr = (size_t)callback, anchor_addr = (size_t)timer_init;
+			if (callback_addr >= anchor_addr)
+				fprintf(file, ",timer_init+%lx", (unsigned long)(callback_addr - anchor_addr));
+			else
+				fprintf(file, ",timer_init-%lx", (unsigned long)(anchor_addr - callback_addr));
+		}
+	}
+	fprintf(file, ",timer_other\n");
+
+	for (i = 0; i < sched_stats_count; i++)
+	{
+		const struct sched_frame_stats *stats = &sched_stats[(first + i) % SCHED_STATS_FRAMES];
+
+		fprintf(file, "%u,%u,%u,%.3f,%u", stats->frame, stats->timeslices, stats->boosts,
+				stats->boost_time * 1000000.0, stats->timers_fired);
+		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+			fprintf(file, ",%u,%u,%u", stats->slices[cpunum], stats->cycles[cpunum], stats->aborts[cpunum]);
+		for (slot = 0; slot < TIMER_STATS_CALLBACKS - 1; slot++)
+			if (timer_stats_callback(slot))
+				fprintf(file, ",%u", stats->timer_fired[slot]);
+		fprintf(file, ",%u\n", stats->timer_fired[TIMER_STATS_CALLBACKS - 1]);
+	}
+
+	fclose(file);
+	log_cb(RETRO_LOG_INFO, LOGPRE "Scheduler statistics: wrote %s\n", filename);
+}
+
+static void sched_stats_exit(void)
+{
+	UINT64 timeslices = 0, boosts = 0, timers = 0;
+	UINT64 slices[MAX_CPU], cycles[MAX_CPU], aborts[MAX_CPU], fired[TIMER_STATS_CALLBACKS];
+	UINT32 max_timeslices = 0;
+	double boost_time = 0;
+	int first, count, i, cpunum, slot;
+
+	if (!sched_stats)
+		return;
+
+	memset(slices, 0, sizeof(slices));
+	memset(cycles, 0, sizeof(cycles));
+	memset(aborts, 0, sizeof(aborts));
+	memset(fired, 0, sizeof(fired));
+
+	cpu_get_sched_stats(&first, &count);
+	for (i = 0; i < count; i++)
+	{
+		const struct sched_frame_stats *stats = &sched_stats[(first + i) % SCHED_STATS_FRAMES];
+
+		timeslices += stats->timeslices;
+		if (stats->timeslices > max_timeslices)
+			max_timeslices = stats->timeslices;
+		boosts += stats->boosts;
+		boost_time += stats->boost_time;
+		timers += stats->timers_fired;
+		for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		{
+			slices[cpunum] += stats->slices[cpunum];
+			cycles[cpunum] += stats->cycles[cpunum];
+			aborts[cpunum] += stats->aborts[cpunum];
+		}
+		for (slot = 0; slot < TIMER_STATS_CALLBACKS; slot++)
+			fired[slot] += stats->timer_fired[slot];
+	}
+
+	if (sched_stats_count)
+	{
+		double frames = sched_stats_count;
+
+		log_cb(RETRO_LOG_INFO, LOGPRE "Scheduler statistics over the last %d frames: %.1f timeslices/frame (max %u), "
+				"%.1f timers fired/frame, %.2f interleave boosts/frame averaging %.1f us\n",
+				sched_stats_count, timeslices / frames, max_timeslices, timers / frames,
+				boosts / frames, boosts ? boost_time * 1000000.0 / boosts : 0);
+		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+			log_cb(RETRO_LOG_INFO, LOGPRE "  CPU #%d: %.1f slices/frame, %.0f cycles/slice, %.2f aborted slices/frame\n",
+					cpunum, slices[cpunum] / frames, slices[cpunum] ? (double)cycles[cpunum] / slices[cpunum] : 0,
+					aborts[cpunum] / frames);
+		for (slot = 0; slot < TIMER_STATS_CALLBACKS; slot++)
+			if (fired[slot])
+			{
+				void (*callback)(int) = timer_stats_callback(slot);
+				if (callback)
+					log_cb(RETRO_LOG_INFO, LOGPRE "  timer %p: %.2f fired/frame\n", (void *)callback, fired[slot] / frames);
+				else
+					log_cb(RETRO_LOG_INFO, LOGPRE "  other timers: %.2f fired/frame\n", fired[slot] / frames);
+			}
+		sched_stats_write_csv(first);
+	}
+
+	timer_stats_enable(0);
+	free(sched_stats);
+	sched_stats = NULL;
+	sched_frame = NULL;
+}
+
+
+
 /*************************************
  *
  *	Timer variables
@@ -236,17 +566,23 @@ int cpu_init(void)
 		cpu[cpunum].clockscale = cputype_get_interface(cputype)->overclock;
 
 		/* compute the cycle times */
-		sec_to_cycles[cpunum] = cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock;
-		cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
+		compute_cycle_times(cpunum);
 
 		/* initialize this CPU */
 		if (cpuintrf_init_cpu(cpunum, cputype))
 			return 1;
+
+		/* set up the idle loop detection */
+		if (options.idle_detect && !(Machine->drv->cpu[cpunum].cpu_flags & CPU_NO_IDLE_DETECT))
+			idle_init(cpunum);
 	}
 	
 	/* compute the perfect interleave factor */
 	compute_perfect_interleave();
 
+	/* set up the scheduler statistics */
+	sched_stats_init();
+
 	/* save some stuff in tag 0 */
 	state_save_set_current_tag(0);
 	state_save_register_INT32("cpu", 0, "watchdog count", &watchdog_counter, 1);
@@ -300,6 +636,7 @@ static void cpu_pre_run(void)
 		/* reset the total number of cycles */
 		cpu[cpunum].totalcycles = 0;
 		cpu[cpunum].localtime = 0;
+		cpu[cpunum].localtime_frac = 0;
 	}
 
 	vblank = 0;
@@ -361,6 +698,9 @@ void mame_frame(void)
         }
         
         gotFrame = 0;
+
+        if (sched_frame)
+            sched_stats_frame_end();
         
         if(time_to_reset)
         {
@@ -397,9 +737,14 @@ void cpu_exit(void)
 {
 	int cpunum;
 
+	sched_stats_exit();
+
 	/* shut down the CPU cores */
 	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
 		cpuintrf_exit_cpu(cpunum);
+		idle_exit(cpunum);
+	}
 }
 
 
@@ -564,6 +909,103 @@ void cpunum_set_halt_line(int cpunum, int state)
 #pragma mark CPU SCHEDULING
 #endif
 
+/*************************************
+ *
+ *	Run a CPU for a number of cycles,
+ *	with or without idle detection
+ *
+ *************************************/
+
+static int execute_cycles(int cpunum, int cycles)
+{
+	int ran;
+
+	cycles_running = cycles;
+	cycles_stolen = 0;
+	ran = cpunum_execute(cpunum, cycles);
+	ran -= cycles_stolen;
+
+	/* account for these cycles */
+	cpu[cpunum].totalcycles += ran;
+	add_local_cycles(cpunum, ran);
+	return ran;
+}
+
+static int idle_execute(int cpunum, int cycles)
+{
+	struct cpuinfo *info = &cpu[cpunum];
+	int nregs = info->idle_nregs;
+	int ran = 0, probe, i, j;
+	UINT32 writes;
+
+	if (!info->idle_candidate || info->idle_delay || cycles < IDLE_MIN_SLICE)
+	{
+		if (info->idle_delay)
+			info->idle_delay--;
+		writes = memory_writes;
+		ran = execute_cycles(cpunum, cycles);
+		info->idle_candidate = (memory_writes == writes);
+		return ran;
+	}
+
+	/* probe in short steps, looking for a repeated register state */
+	for (probe = 0; probe < IDLE_HISTORY; probe++)
+	{
+		unsigned *regs = &info->idle_history[probe * nregs];
+
+		writes = memory_writes;
+		ran += execute_cycles(cpunum, IDLE_PROBE_CYCLES);
+
+		/* the slice was cut short: leave it at that */
+		if (cycles_running != IDLE_PROBE_CYCLES)
+		{
+			info->idle_candidate = (memory_writes == writes);
+			return ran;
+		}
+		if (memory_writes != writes)
+		{
+			info->idle_candidate = 0;
+			break;
+		}
+
+		for (i = 0; i < nregs; i++)
+			regs[i] = cpunum_get_reg(cpunum, info->idle_regs[i]);
+		for (j = 0; j < probe; j++)
+			if (!memcmp(regs, &info->idle_history[j * nregs], nregs * sizeof(regs[0])))
+				break;
+
+		/* found one: eat the rest of the slice */
+		if (j < probe)
+		{
+			int skipped = cycles - ran;
+			info->totalcycles += skipped;
+			add_local_cycles(cpunum, skipped);
+			info->idle_cycles += skipped;
+			info->idle_loops++;
+			info->idle_pc = cpunum_get_pc(cpunum);
+			info->idle_backoff = 0;
+			return cycles;
+		}
+	}
+
+	/* no luck; wait a while before trying again */
+	info->idle_backoff = info->idle_backoff ? info->idle_backoff * 2 : 1;
+	if (info->idle_backoff > IDLE_MAX_BACKOFF)
+		info->idle_backoff = IDLE_MAX_BACKOFF;
+	info->idle_delay = info->idle_backoff;
+
+	/* run whatever is left */
+	if (ran < cycles)
+	{
+		writes = memory_writes;
+		ran += execute_cycles(cpunum, cycles - ran);
+		info->idle_candidate = (memory_writes == writes);
+	}
+	return ran;
+}
+
+
+
 /*************************************
  *
  *	Execute all the CPUs for one
@@ -573,17 +1015,20 @@ void cpunum_set_halt_line(int cpunum, int state)
 
 static void cpu_timeslice(void)
 {
-	double target = timer_time_until_next_timer();
+	mame_ticks target = timer_time_until_next_timer();
 	int cpunum, ran;
 	
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "------------------\n");
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu_timeslice: target = %.9f\n", target);
+	if (sched_frame)
+		sched_frame->timeslices++;
+
+	LOG((RETRO_LOG_DEBUG, LOGPRE "------------------\n"));
+	LOG((RETRO_LOG_DEBUG, LOGPRE "cpu_timeslice: target = %.9f\n", TICKS_TO_DOUBLE(target)));
 	
 	/* process any pending suspends */
 	for (cpunum = 0; Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
 	{
 		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
 		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
 		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
 	}
@@ -595,28 +1040,30 @@ static void cpu_timeslice(void)
 		if (!cpu[cpunum].suspend)
 		{
 			/* compute how long to run */
-			cycles_running = TIME_TO_CYCLES(cpunum, target - cpu[cpunum].localtime);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles\n", cpunum, cycles_running);
-		
+			int cycles = ticks_to_cycles(cpunum, target - cpu[cpunum].localtime);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles\n", cpunum, cycles));
+
 			/* run for the requested number of cycles */
-			if (cycles_running > 0)
+			if (cycles > 0)
 			{
 				profiler_mark(PROFILER_CPU1 + cpunum);
-				cycles_stolen = 0;
-				ran = cpunum_execute(cpunum, cycles_running);
-				ran -= cycles_stolen;
+				if (cpu[cpunum].idle_nregs)
+					ran = idle_execute(cpunum, cycles);
+				else
+					ran = execute_cycles(cpunum, cycles);
 				profiler_mark(PROFILER_END);
-				
-				/* account for these cycles */
-				cpu[cpunum].totalcycles += ran;
-				cpu[cpunum].localtime += TIME_IN_CYCLES(ran, cpunum);
-				log_cb(RETRO_LOG_DEBUG, LOGPRE "         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, cpu[cpunum].localtime);
+				if (sched_frame)
+				{
+					sched_frame->slices[cpunum]++;
+					sched_frame->cycles[cpunum] += ran;
+				}
+				LOG((RETRO_LOG_DEBUG, LOGPRE "         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, TICKS_TO_DOUBLE(cpu[cpunum].localtime)));
 				
 				/* if the new local CPU time is less than our target, move the target up */
 				if (cpu[cpunum].localtime < target && cpu[cpunum].localtime > 0)
 				{
 					target = cpu[cpunum].localtime;
-					log_cb(RETRO_LOG_DEBUG, LOGPRE "         (new target)\n");
+					LOG((RETRO_LOG_DEBUG, LOGPRE "         (new target)\n"));
 				}
 			}
 		}
@@ -629,17 +1076,17 @@ static void cpu_timeslice(void)
 		if (cpu[cpunum].suspend && cpu[cpunum].eatcycles && cpu[cpunum].localtime < target)
 		{
 			/* compute how long to run */
-			cycles_running = TIME_TO_CYCLES(cpunum, target - cpu[cpunum].localtime);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles (suspended)\n", cpunum, cycles_running);
+			cycles_running = ticks_to_cycles(cpunum, target - cpu[cpunum].localtime);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles (suspended)\n", cpunum, cycles_running));
 
 			cpu[cpunum].totalcycles += cycles_running;
-			cpu[cpunum].localtime += TIME_IN_CYCLES(cycles_running, cpunum);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "         %d skipped, %d total, time = %.9f\n", cycles_running, (INT32)cpu[cpunum].totalcycles, cpu[cpunum].localtime);
+			add_local_cycles(cpunum, cycles_running);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "         %d skipped, %d total, time = %.9f\n", cycles_running, (INT32)cpu[cpunum].totalcycles, TICKS_TO_DOUBLE(cpu[cpunum].localtime)));
 		}
 		
 		/* update the suspend state */
 		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
 		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
 		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
 
@@ -673,8 +1120,12 @@ void activecpu_abort_timeslice(void)
 	int current_icount;
 	
 	VERIFY_EXECUTINGCPU_VOID(activecpu_abort_timeslice);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "activecpu_abort_timeslice (CPU=%d, cycles_left=%d)\n", cpu_getexecutingcpu(), activecpu_get_icount() + 1);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "activecpu_abort_timeslice (CPU=%d, cycles_left=%d)\n", cpu_getexecutingcpu(), activecpu_get_icount() + 1));
 	
+	/* count the abort against the executing CPU */
+	if (sched_frame)
+		sched_frame->aborts[cpu_getexecutingcpu()]++;
+
 	/* swallow the remaining cycles */
 	current_icount = activecpu_get_icount() + 1;
 	cycles_stolen += current_icount;
@@ -692,9 +1143,9 @@ void activecpu_abort_timeslice(void)
  *
  *************************************/
 
-double cpunum_get_localtime(int cpunum)
+mame_ticks cpunum_get_localtime(int cpunum)
 {
-	double result;
+	mame_ticks result;
 	
 	VERIFY_CPUNUM(0, cpunum_get_localtime);
 
@@ -703,7 +1154,9 @@ double cpunum_get_localtime(int cpunum)
 	if (cpunum == cpu_getexecutingcpu())
 	{
 		int cycles = cycles_currently_ran();
-		result += TIME_IN_CYCLES(cycles, cpunum);
+		if (cycles > 0)
+			result += (mame_ticks)cycles * cpu[cpunum].cycle_ticks
+					+ (mame_ticks)(((UINT64)cycles * cpu[cpunum].cycle_ticks_frac + cpu[cpunum].localtime_frac) >> 32);
 	}
 	return result;
 }
@@ -720,7 +1173,7 @@ double cpunum_get_localtime(int cpunum)
 void cpunum_suspend(int cpunum, int reason, int eatcycles)
 {
 	VERIFY_CPUNUM_VOID(cpunum_suspend);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles));
 	
 	/* set the pending suspend bits, and force a resync */
 	cpu[cpunum].nextsuspend |= reason;
@@ -741,7 +1194,7 @@ void cpunum_suspend(int cpunum, int reason, int eatcycles)
 void cpunum_resume(int cpunum, int reason)
 {
 	VERIFY_CPUNUM_VOID(cpunum_resume);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason));
 
 	/* clear the pending suspend bits, and force a resync */
 	cpu[cpunum].nextsuspend &= ~reason;
@@ -793,8 +1246,7 @@ void cpunum_set_clockscale(int cpunum, double clockscale)
 	VERIFY_CPUNUM_VOID(cpunum_set_clockscale);
 
 	cpu[cpunum].clockscale = clockscale;
-	sec_to_cycles[cpunum] = cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock;
-	cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
+	compute_cycle_times(cpunum);
 
 	/* re-compute the perfect interleave factor */
 	compute_perfect_interleave();
@@ -815,7 +1267,12 @@ void cpu_boost_interleave(double timeslice_time, double boost_duration)
 	if (timeslice_time < perfect_interleave)
 		timeslice_time = perfect_interleave;
 	
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu_boost_interleave(%.9f, %.9f)\n", timeslice_time, boost_duration);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "cpu_boost_interleave(%.9f, %.9f)\n", timeslice_time, boost_duration));
+	if (sched_frame)
+	{
+		sched_frame->boosts++;
+		sched_frame->boost_time += boost_duration;
+	}
 
 	/* adjust the interleave timer */
 	timer_adjust(interleave_boost_timer, timeslice_time, 0, timeslice_time);		
@@ -1543,7 +2000,7 @@ static void cpu_timeslicecallback(int param)
 static void end_interleave_boost(int param)
 {
 	timer_adjust(interleave_boost_timer, TIME_NEVER, 0, TIME_NEVER);		
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "end_interleave_boost\n");
+	LOG((RETRO_LOG_DEBUG, LOGPRE "end_interleave_boost\n"));
 }
 
 
@@ -1578,7 +2035,7 @@ static void compute_perfect_interleave(void)
 	if (perfect_interleave == 1.0)
 		perfect_interleave = cycles_to_sec[0];
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Perfect interleave = %.9f, smallest = %.9f\n", perfect_interleave, smallest);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "Perfect interleave = %.9f, smallest = %.9f\n", perfect_interleave, smallest));
 }
 
 
@@ -69,7 +69,10 @@ enum
 	CPU_AUDIO_CPU = 0x0002,
 
 	/* the Z80 can be wired to use 16 bit addressing for I/O ports */
-	CPU_16BIT_PORT = 0x0001
+	CPU_16BIT_PORT = 0x0001,
+
+	/* set this if the generic idle loop detection upsets the CPU's timing */
+	CPU_NO_IDLE_DETECT = 0x0004
 };
 
 
@@ -163,7 +166,7 @@ int cpunum_is_suspended(int cpunum, int reason);
 void activecpu_abort_timeslice(void);
 
 /* Returns the current local time for a CPU, relative to the current timeslice */
-double cpunum_get_localtime(int cpunum);
+mame_ticks cpunum_get_localtime(int cpunum);
 
 /* Returns the current scaling factor for a CPU's clock speed */
 double cpunum_get_clockscale(int cpunum);
@@ -310,6 +313,35 @@ int cpu_getiloops(void);
 
 
 
+/*************************************
+ *
+ *	Scheduler statistics
+ *
+ *************************************/
+
+#define SCHED_STATS_FRAMES	3600		/* frames kept, one minute at 60Hz */
+#define SCHED_STATS_CPUS	8			/* MAX_CPU, which driver.h defines after including us */
+
+struct sched_frame_stats
+{
+	UINT32	frame;						/* cpu_getcurrentframe() at the end of the frame */
+	UINT32	timeslices;					/* scheduler timeslices */
+	UINT32	boosts;						/* cpu_boost_interleave() calls */
+	double	boost_time;					/* boost duration they asked for, in seconds */
+	UINT32	timers_fired;				/* timer callbacks run */
+	UINT32	slices[SCHED_STATS_CPUS];	/* slices each CPU ran in */
+	UINT32	cycles[SCHED_STATS_CPUS];	/* cycles each CPU ran */
+	UINT32	aborts[SCHED_STATS_CPUS];	/* activecpu_abort_timeslice() calls on each CPU */
+	UINT32	timer_fired[TIMER_STATS_CALLBACKS];	/* timers fired, per timer_stats_callback() slot */
+};
+
+/* return the ring of per-frame statistics, NULL if they are off; the oldest
+   of the *count recorded frames is at index *first, the ring wraps after
+   SCHED_STATS_FRAMES entries */
+const struct sched_frame_stats *cpu_get_sched_stats(int *first, int *count);
+
+
+
 /*************************************
  *
  *	Z80 daisy chain
@@ -667,9 +667,14 @@ static INLINE void set_cpu_context(int cpunum)
 	int newfamily = cpu[cpunum].family;
 	int oldcontext = cpu_active_context[newfamily];
 
+	profiler_count(PROFILER_COUNT_CONTEXT_SWITCH);
+
 	/* if we need to change contexts, save the one that was there */
 	if (oldcontext != cpunum && oldcontext != -1)
+	{
 		(*cpu[oldcontext].intf.get_context)(cpu[oldcontext].context);
+		profiler_count(PROFILER_COUNT_CONTEXT_COPY);
+	}
 
 	/* swap memory spaces */
 	activecpu = cpunum;
@@ -679,6 +684,7 @@ static INLINE void set_cpu_context(int cpunum)
 	if (oldcontext != cpunum)
 	{
 		(*cpu[cpunum].intf.set_context)(cpu[cpunum].context);
+		profiler_count(PROFILER_COUNT_CONTEXT_COPY);
 		cpu_active_context[newfamily] = cpunum;
 	}
 }
@@ -2,6 +2,28 @@
 
 #include "driver.h"
 
+/* the SSE2 rectangle blitters are built for any x86 target that gcc can
+   compile them for, and used when the CPU running the core has SSE2 */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && (defined(__i386__) || defined(__x86_64__))
+#define BLITRECT_SSE2
+#define BLITRECT_TARGET __attribute__((target("sse2")))
+#define BLITRECT_CPU_OK() __builtin_cpu_supports("sse2")
+#elif defined(__SSE2__)
+#define BLITRECT_SSE2
+#define BLITRECT_TARGET
+#define BLITRECT_CPU_OK() 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLITRECT_NEON
+#define BLITRECT_TARGET
+#define BLITRECT_CPU_OK() 1
+#endif
+
+#if defined(__SSE2__) || defined(BLITRECT_SSE2)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 
 #ifdef MSB_FIRST
 #define SHIFT0 24
@@ -81,6 +103,375 @@ void alpha_init(void)
 }
 
 
+/***************************************************************************
+
+  SIMD rectangle blitters
+
+  drawgfx_core hands unflipped, unpacked 8bpp elements at least 16
+  pixels wide, drawn without a priority buffer, to these when they are
+  in use. They cover the pen, pens, color and alpha modes into 16 and
+  32bpp bitmaps and give the same pixels as the blockmove_8toN_*
+  functions: eight pixels are tested and merged at a time, groups of
+  eight transparent pixels are skipped, and the last few pixels of each
+  line are drawn one by one. paldata is NULL for the raw modes, which
+  add colorbase to the pen instead.
+
+  tools/blitbench times them against the blockmove functions and checks
+  that they draw the same.
+
+***************************************************************************/
+
+typedef void (*blitrect_func)(void *dstdata,int dstmodulo,const UINT8 *srcdata,int srcmodulo,
+		int width,int height,const pen_t *paldata,unsigned int colorbase,const UINT16 *colortable,int transp);
+
+static int blitrect_active;
+
+#if defined(BLITRECT_SSE2) || defined(BLITRECT_NEON)
+
+#ifdef BLITRECT_SSE2
+
+/* eight pixels, one 16-bit lane each, all ones where the destination is kept */
+typedef __m128i blit_mask;
+
+static INLINE BLITRECT_TARGET blit_mask blit_transmask(const UINT8 *src,int transp)
+{
+	__m128i m = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_set1_epi8((char)transp));
+	return _mm_unpacklo_epi8(m, m);
+}
+
+/* bit n of bits set keeps the destination of pixel n */
+static INLINE BLITRECT_TARGET blit_mask blit_bitsmask(int bits)
+{
+	const __m128i lanes = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+	return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(bits), lanes), lanes);
+}
+
+static INLINE BLITRECT_TARGET int blit_mask_all(blit_mask m)
+{
+	return _mm_movemask_epi8(m) == 0xffff;
+}
+
+static INLINE BLITRECT_TARGET __m128i blit_select(__m128i m,__m128i d,__m128i s)
+{
+	return _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, s));
+}
+
+static INLINE BLITRECT_TARGET void blit_merge16(UINT16 *dst,const UINT16 *pix,blit_mask m)
+{
+	__m128i d = _mm_loadu_si128((const __m128i *)dst);
+	_mm_storeu_si128((__m128i *)dst, blit_select(m, d, _mm_loadu_si128((const __m128i *)pix)));
+}
+
+static INLINE BLITRECT_TARGET void blit_merge32(UINT32 *dst,const UINT32 *pix,blit_mask m)
+{
+	__m128i d0 = _mm_loadu_si128((const __m128i *)dst);
+	__m128i d1 = _mm_loadu_si128((const __m128i *)(dst+4));
+	_mm_storeu_si128((__m128i *)dst, blit_select(_mm_unpacklo_epi16(m, m), d0, _mm_loadu_si128((const __m128i *)pix)));
+	_mm_storeu_si128((__m128i *)(dst+4), blit_select(_mm_unpackhi_epi16(m, m), d1, _mm_loadu_si128((const __m128i *)(pix+4))));
+}
+
+/* alpha_blend16() on one 5-bit channel of eight pixels */
+static INLINE BLITRECT_TARGET __m128i blit_blend5(__m128i d,__m128i s,__m128i fs,__m128i fd,int shift)
+{
+	__m128i mask = _mm_set1_epi16(0x1f);
+	__m128i sc = _mm_and_si128(_mm_srl_epi16(s, _mm_cvtsi32_si128(shift)), mask);
+	__m128i dc = _mm_and_si128(_mm_srl_epi16(d, _mm_cvtsi32_si128(shift)), mask);
+	return _mm_sll_epi16(_mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(sc, fs), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(dc, fd), 8)), _mm_cvtsi32_si128(shift));
+}
+
+static INLINE BLITRECT_TARGET void blit_blend16(UINT16 *dst,const UINT16 *pix,blit_mask m,int fs,int fd)
+{
+	__m128i d = _mm_loadu_si128((const __m128i *)dst);
+	__m128i s = _mm_loadu_si128((const __m128i *)pix);
+	__m128i vfs = _mm_set1_epi16(fs), vfd = _mm_set1_epi16(fd);
+	__m128i r = _mm_or_si128(_mm_or_si128(blit_blend5(d, s, vfs, vfd, 0), blit_blend5(d, s, vfs, vfd, 5)), blit_blend5(d, s, vfs, vfd, 10));
+	_mm_storeu_si128((__m128i *)dst, blit_select(m, d, r));
+}
+
+/* alpha_blend32() on four pixels, all four bytes at once; the top one is cleared */
+static INLINE BLITRECT_TARGET __m128i blit_blendvec32(__m128i d,__m128i s,__m128i fs,__m128i fd)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), fs), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), fd), 8));
+	__m128i hi = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), fs), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), fd), 8));
+	return _mm_and_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0x00ffffff));
+}
+
+static INLINE BLITRECT_TARGET void blit_blend32(UINT32 *dst,const UINT32 *pix,blit_mask m,int fs,int fd)
+{
+	__m128i vfs = _mm_set1_epi16(fs), vfd = _mm_set1_epi16(fd);
+	__m128i d0 = _mm_loadu_si128((const __m128i *)dst);
+	__m128i d1 = _mm_loadu_si128((const __m128i *)(dst+4));
+	__m128i r0 = blit_blendvec32(d0, _mm_loadu_si128((const __m128i *)pix), vfs, vfd);
+	__m128i r1 = blit_blendvec32(d1, _mm_loadu_si128((const __m128i *)(pix+4)), vfs, vfd);
+	_mm_storeu_si128((__m128i *)dst, blit_select(_mm_unpacklo_epi16(m, m), d0, r0));
+	_mm_storeu_si128((__m128i *)(dst+4), blit_select(_mm_unpackhi_epi16(m, m), d1, r1));
+}
+
+#else	/* BLITRECT_NEON */
+
+typedef uint16x8_t blit_mask;
+
+static INLINE blit_mask blit_transmask(const UINT8 *src,int transp)
+{
+	uint8x8_t m = vceq_u8(vld1_u8(src), vdup_n_u8((UINT8)transp));
+	return vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(m)));
+}
+
+static INLINE blit_mask blit_bitsmask(int bits)
+{
+	static const UINT16 lanes[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	return vtstq_u16(vdupq_n_u16(bits), vld1q_u16(lanes));
+}
+
+static INLINE int blit_mask_all(blit_mask m)
+{
+	return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(m)), 0) == ~(UINT64)0;
+}
+
+static INLINE uint32x4_t blit_mask32(uint16x4_t m)
+{
+	return vreinterpretq_u32_s32(vmovl_s16(vreinterpret_s16_u16(m)));
+}
+
+static INLINE void blit_merge16(UINT16 *dst,const UINT16 *pix,blit_mask m)
+{
+	vst1q_u16(dst, vbslq_u16(m, vld1q_u16(dst), vld1q_u16(pix)));
+}
+
+static INLINE void blit_merge32(UINT32 *dst,const UINT32 *pix,blit_mask m)
+{
+	vst1q_u32(dst, vbslq_u32(blit_mask32(vget_low_u16(m)), vld1q_u32(dst), vld1q_u32(pix)));
+	vst1q_u32(dst+4, vbslq_u32(blit_mask32(vget_high_u16(m)), vld1q_u32(dst+4), vld1q_u32(pix+4)));
+}
+
+/* alpha_blend16() on one 5-bit channel of eight pixels, the channels already shifted down */
+static INLINE uint16x8_t blit_blend5(uint16x8_t d,uint16x8_t s,uint16x8_t fs,uint16x8_t fd)
+{
+	uint16x8_t mask = vdupq_n_u16(0x1f);
+	return vaddq_u16(vshrq_n_u16(vmulq_u16(vandq_u16(s, mask), fs), 8),
+			vshrq_n_u16(vmulq_u16(vandq_u16(d, mask), fd), 8));
+}
+
+static INLINE void blit_blend16(UINT16 *dst,const UINT16 *pix,blit_mask m,int fs,int fd)
+{
+	uint16x8_t d = vld1q_u16(dst);
+	uint16x8_t s = vld1q_u16(pix);
+	uint16x8_t vfs = vdupq_n_u16(fs), vfd = vdupq_n_u16(fd);
+	uint16x8_t r = blit_blend5(d, s, vfs, vfd);
+	r = vorrq_u16(r, vshlq_n_u16(blit_blend5(vshrq_n_u16(d, 5), vshrq_n_u16(s, 5), vfs, vfd), 5));
+	r = vorrq_u16(r, vshlq_n_u16(blit_blend5(vshrq_n_u16(d, 10), vshrq_n_u16(s, 10), vfs, vfd), 10));
+	vst1q_u16(dst, vbslq_u16(m, d, r));
+}
+
+/* alpha_blend32() on four pixels, all four bytes at once; the top one is cleared */
+static INLINE uint32x4_t blit_blendvec32(uint32x4_t d,uint32x4_t s,uint16x8_t fs,uint16x8_t fd)
+{
+	uint8x16_t sb = vreinterpretq_u8_u32(s), db = vreinterpretq_u8_u32(d);
+	uint16x8_t lo = vaddq_u16(vshrq_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(sb)), fs), 8),
+			vshrq_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(db)), fd), 8));
+	uint16x8_t hi = vaddq_u16(vshrq_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(sb)), fs), 8),
+			vshrq_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(db)), fd), 8));
+	return vandq_u32(vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))), vdupq_n_u32(0x00ffffff));
+}
+
+static INLINE void blit_blend32(UINT32 *dst,const UINT32 *pix,blit_mask m,int fs,int fd)
+{
+	uint16x8_t vfs = vdupq_n_u16(fs), vfd = vdupq_n_u16(fd);
+	uint32x4_t d0 = vld1q_u32(dst), d1 = vld1q_u32(dst+4);
+	uint32x4_t r0 = blit_blendvec32(d0, vld1q_u32(pix), vfs, vfd);
+	uint32x4_t r1 = blit_blendvec32(d1, vld1q_u32(pix+4), vfs, vfd);
+	vst1q_u32(dst, vbslq_u32(blit_mask32(vget_low_u16(m)), d0, r0));
+	vst1q_u32(dst+4, vbslq_u32(blit_mask32(vget_high_u16(m)), d1, r1));
+}
+
+#endif
+
+/* the colors of eight pixels, looked up or raw */
+#define BLITRECT_PENS(pix,src)								\
+	if (paldata)											\
+		for (i = 0; i < 8; i++) pix[i] = paldata[src[i]];	\
+	else													\
+		for (i = 0; i < 8; i++) pix[i] = colorbase + src[i];
+
+#define BLITRECT_PEN(n) (paldata ? paldata[n] : colorbase + (n))
+
+/* transparent pixels of eight for TRANSPARENCY_PENS and TRANSPARENCY_COLOR, one bit each;
+   pens above 31 wrap the shift the way PEN_IS_OPAQUE does on x86 and ARM64 */
+#define BLITRECT_PENSBITS(bits,src)							\
+	for (i = 0, bits = 0; i < 8; i++) bits |= ((transp >> (src[i] & 31)) & 1) << i;
+
+#define BLITRECT_COLORBITS(bits,src)						\
+	for (i = 0, bits = 0; i < 8; i++) bits |= (colortable[src[i]] == transp) << i;
+
+/* one blitter per mode and depth; GROUP draws s[x..x+7] to d[x..x+7] and PIXEL draws s[x] */
+#define BLITRECT(name,type,GROUP,PIXEL)																\
+static BLITRECT_TARGET void name(void *dstdata,int dstmodulo,const UINT8 *srcdata,int srcmodulo,	\
+		int width,int height,const pen_t *paldata,unsigned int colorbase,const UINT16 *colortable,int transp)	\
+{																									\
+	type pix[8];																					\
+	int bits;																						\
+	int fs = (alpha_cache.alphas - alpha_cache.alpha[0]) >> 8;										\
+	int fd = (alpha_cache.alphad - alpha_cache.alpha[0]) >> 8;										\
+	int x, i;																						\
+																									\
+	(void)bits; (void)fs; (void)fd; (void)colortable;												\
+	while (height--)																				\
+	{																								\
+		type *d = (type *)dstdata;																	\
+		const UINT8 *s = srcdata;																	\
+																									\
+		for (x = 0; x + 8 <= width; x += 8)															\
+		{																							\
+			GROUP																					\
+		}																							\
+		for ( ; x < width; x++)																		\
+		{																							\
+			PIXEL																					\
+		}																							\
+		dstdata = (type *)dstdata + dstmodulo;														\
+		srcdata += srcmodulo;																		\
+	}																								\
+}
+
+#define TRANSPEN_GROUP(merge)												\
+	blit_mask m = blit_transmask(&s[x], transp);							\
+	if (blit_mask_all(m)) continue;											\
+	BLITRECT_PENS(pix, (&s[x]))												\
+	merge(&d[x], pix, m);
+
+#define TRANSPEN_PIXEL														\
+	if (s[x] != transp) d[x] = BLITRECT_PEN(s[x]);
+
+#define TRANSMASK_GROUP(merge)												\
+	BLITRECT_PENSBITS(bits, (&s[x]))										\
+	if (bits == 0xff) continue;												\
+	BLITRECT_PENS(pix, (&s[x]))												\
+	merge(&d[x], pix, blit_bitsmask(bits));
+
+#define TRANSMASK_PIXEL														\
+	if (((1 << (s[x] & 31)) & transp) == 0) d[x] = BLITRECT_PEN(s[x]);
+
+#define TRANSCOLOR_GROUP(merge)												\
+	BLITRECT_COLORBITS(bits, (&s[x]))										\
+	if (bits == 0xff) continue;												\
+	BLITRECT_PENS(pix, (&s[x]))												\
+	merge(&d[x], pix, blit_bitsmask(bits));
+
+#define TRANSCOLOR_PIXEL													\
+	if (colortable[s[x]] != transp) d[x] = BLITRECT_PEN(s[x]);
+
+#define ALPHA_GROUP(blend)													\
+	blit_mask m = blit_transmask(&s[x], transp);							\
+	if (blit_mask_all(m)) continue;											\
+	BLITRECT_PENS(pix, (&s[x]))												\
+	blend(&d[x], pix, m, fs, fd);
+
+BLITRECT(blitrect_transpen16,   UINT16, TRANSPEN_GROUP(blit_merge16),   TRANSPEN_PIXEL)
+BLITRECT(blitrect_transpen32,   UINT32, TRANSPEN_GROUP(blit_merge32),   TRANSPEN_PIXEL)
+BLITRECT(blitrect_transmask16,  UINT16, TRANSMASK_GROUP(blit_merge16),  TRANSMASK_PIXEL)
+BLITRECT(blitrect_transmask32,  UINT32, TRANSMASK_GROUP(blit_merge32),  TRANSMASK_PIXEL)
+BLITRECT(blitrect_transcolor16, UINT16, TRANSCOLOR_GROUP(blit_merge16), TRANSCOLOR_PIXEL)
+BLITRECT(blitrect_transcolor32, UINT32, TRANSCOLOR_GROUP(blit_merge32), TRANSCOLOR_PIXEL)
+BLITRECT(blitrect_alpha16,      UINT16, ALPHA_GROUP(blit_blend16),      if (s[x] != transp) d[x] = alpha_blend16(d[x], paldata[s[x]]);)
+BLITRECT(blitrect_alpha32,      UINT32, ALPHA_GROUP(blit_blend32),      if (s[x] != transp) d[x] = alpha_blend32(d[x], paldata[s[x]]);)
+
+#endif	/* BLITRECT_SSE2 || BLITRECT_NEON */
+
+
+/*-------------------------------------------------
+	drawgfx_simd_init - use the SIMD rectangle
+	blitters if enable is set and the CPU has
+	them; returns whether they are used
+-------------------------------------------------*/
+
+int drawgfx_simd_init(int enable)
+{
+#if defined(BLITRECT_SSE2) || defined(BLITRECT_NEON)
+	blitrect_active = enable && BLITRECT_CPU_OK();
+#else
+	blitrect_active = 0;
+#endif
+	return blitrect_active;
+}
+
+
+/*-------------------------------------------------
+	blitrect_draw - draw an unflipped 8bpp element
+	with a SIMD rectangle blitter; returns 0 if
+	there is none for the mode
+-------------------------------------------------*/
+
+static int blitrect_draw(int transparency,int bytes,void *dstdata,int dstmodulo,
+		const UINT8 *srcdata,int srcmodulo,int srcheight,int leftskip,int topskip,int flipy,
+		int dstwidth,int dstheight,const pen_t *paldata,unsigned int colorbase,int transparent_color)
+{
+#if defined(BLITRECT_SSE2) || defined(BLITRECT_NEON)
+	blitrect_func func;
+	const UINT16 *colortable = NULL;
+
+	/* blitbench shows no gain below 16 pixels, and below 24 for TRANSPARENCY_PENS,
+	   whose transparency test stays scalar */
+	if (dstwidth < 16 || (bytes != 2 && bytes != 4))
+		return 0;
+
+	switch (transparency)
+	{
+		case TRANSPARENCY_PEN:
+		case TRANSPARENCY_PEN_RAW:
+			/* a pen the 8-bit compare can't see never matches, so draw it the long way */
+			if (transparent_color & ~0xff)
+				return 0;
+			func = (bytes == 2) ? blitrect_transpen16 : blitrect_transpen32;
+			break;
+
+		case TRANSPARENCY_PENS:
+		case TRANSPARENCY_PENS_RAW:
+			if (dstwidth < 24)
+				return 0;
+			func = (bytes == 2) ? blitrect_transmask16 : blitrect_transmask32;
+			break;
+
+		case TRANSPARENCY_COLOR:
+			colortable = Machine->game_colortable + (paldata - Machine->remapped_colortable);
+			func = (bytes == 2) ? blitrect_transcolor16 : blitrect_transcolor32;
+			break;
+
+		case TRANSPARENCY_ALPHA:
+			if (transparent_color & ~0xff)
+				return 0;
+			func = (bytes == 2) ? blitrect_alpha16 : blitrect_alpha32;
+			break;
+
+		default:
+			return 0;
+	}
+
+	if (is_raw[transparency])
+		paldata = NULL;
+
+	/* the same start as ADJUST_8 without flipx */
+	srcdata += leftskip;
+	if (flipy)
+	{
+		dstdata = (UINT8 *)dstdata + (dstheight-1) * dstmodulo * bytes;
+		dstmodulo = -dstmodulo;
+		srcdata += (srcheight - dstheight - topskip) * srcmodulo;
+	}
+	else
+		srcdata += topskip * srcmodulo;
+
+	(*func)(dstdata,dstmodulo,srcdata,srcmodulo,dstwidth,dstheight,paldata,colorbase,colortable,transparent_color);
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+
 static void calc_penusage(struct GfxElement *gfx,int num)
 {
 	int x,y;
@@ -205,6 +596,67 @@ void decodechar(struct GfxElement *gfx,int num,const UINT8 *src,const struct Gfx
 }
 
 
+/* elements are independent, so big sets are decoded in slices on worker threads */
+#define DECODE_MAX_THREADS	8
+#define DECODE_MIN_BYTES	(256 * 1024)	/* smaller sets are done before a thread starts */
+
+struct decode_slice
+{
+	struct GfxElement *gfx;
+	const UINT8 *src;
+	const struct GfxLayout *gl;
+	int first, last;
+};
+
+static void decode_slice_run(void *param)
+{
+	struct decode_slice *slice = param;
+	int c;
+
+	for (c = slice->first;c < slice->last;c++)
+		decodechar(slice->gfx,c,slice->src,slice->gl);
+}
+
+static void decode_elements(struct GfxElement *gfx,const UINT8 *src,const struct GfxLayout *gl)
+{
+	struct osd_thread *thread[DECODE_MAX_THREADS];
+	struct decode_slice slice[DECODE_MAX_THREADS];
+	int slices = 1;
+	int i;
+
+	if (gfx->total_elements * gfx->char_modulo >= DECODE_MIN_BYTES)
+	{
+		slices = osd_num_processors();
+		if (slices > DECODE_MAX_THREADS)
+			slices = DECODE_MAX_THREADS;
+	}
+
+	for (i = 0;i < slices;i++)
+	{
+		slice[i].gfx = gfx;
+		slice[i].src = src;
+		slice[i].gl = gl;
+		slice[i].first = gfx->total_elements * i / slices;
+		slice[i].last = gfx->total_elements * (i + 1) / slices;
+	}
+
+	/* without a thread a slice is simply decoded here */
+	for (i = 1;i < slices;i++)
+	{
+		thread[i] = osd_thread_create();
+		if (thread[i])
+			osd_thread_start(thread[i],decode_slice_run,&slice[i]);
+		else
+			decode_slice_run(&slice[i]);
+	}
+	decode_slice_run(&slice[0]);
+
+	for (i = 1;i < slices;i++)
+		if (thread[i])
+			osd_thread_destroy(thread[i]);
+}
+
+
 struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
 {
 	int c;
@@ -241,8 +693,10 @@ struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
 	}
 	else
 	{
-		if (0 && gl->planes <= 4 && !(gfx->width & 1))
-/*		if (gl->planes <= 4 && !(gfx->width & 1))*/
+		/* drivers flagged VIDEO_PACKED_GFX only draw through drawgfx and tilemaps, */
+		/* so their elements can be kept two pixels per byte */
+		if (Machine->drv && (Machine->drv->video_attributes & VIDEO_PACKED_GFX)
+				&& gl->planes <= 4 && !(gfx->width & 1))
 		{
 			gfx->flags |= GFX_PACKED;
 			gfx->line_modulo = gfx->width/2;
@@ -258,8 +712,11 @@ struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
 			return 0;
 		}
 
-		for (c = 0;c < gfx->total_elements;c++)
-			decodechar(gfx,c,src,gl);
+		decode_elements(gfx,src,gl);
+
+		if (gfx->flags & GFX_PACKED)
+			log_cb(RETRO_LOG_INFO, LOGPRE "%d %dx%d graphics elements stored packed, %d KB saved\n",
+					gfx->total_elements,gfx->width,gfx->height,gfx->total_elements * gfx->char_modulo / 1024);
 	}
 
 	return gfx;
@@ -278,6 +735,70 @@ void freegfx(struct GfxElement *gfx)
 }
 
 
+/***************************************************************************
+
+  Packed elements are drawn natively by the opaque, transpen and transcolor
+  blitters only. For everything else the element is expanded to 8bpp into a
+  scratch buffer and drawn from a one-element copy of the GfxElement.
+
+***************************************************************************/
+
+#define UNPACK_STACK_BYTES	4096	/* elements up to 64x64 are expanded on the stack */
+
+static INLINE void unpack_4bpp(UINT8 *dst,const UINT8 *src,int bytes)
+{
+	int x = 0;
+
+#if defined(__SSE2__)
+	const __m128i mask = _mm_set1_epi8(0x0f);
+
+	for ( ; x + 16 <= bytes; x += 16)
+	{
+		__m128i packed = _mm_loadu_si128((const __m128i *)&src[x]);
+		__m128i lo = _mm_and_si128(packed, mask);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+		_mm_storeu_si128((__m128i *)&dst[2*x], _mm_unpacklo_epi8(lo, hi));
+		_mm_storeu_si128((__m128i *)&dst[2*x+16], _mm_unpackhi_epi8(lo, hi));
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for ( ; x + 16 <= bytes; x += 16)
+	{
+		uint8x16_t packed = vld1q_u8(&src[x]);
+		uint8x16x2_t pixels;
+		pixels.val[0] = vandq_u8(packed, vdupq_n_u8(0x0f));
+		pixels.val[1] = vshrq_n_u8(packed, 4);
+		vst2q_u8(&dst[2*x], pixels);
+	}
+#endif
+
+	for ( ; x < bytes; x++)
+	{
+		dst[2*x] = src[x] & 0x0f;
+		dst[2*x+1] = src[x] >> 4;
+	}
+}
+
+static const struct GfxElement *unpack_gfx_element(const struct GfxElement *gfx,unsigned int code,
+		struct GfxElement *element,UINT8 *buffer)
+{
+	const UINT8 *src = gfx->gfxdata + code * gfx->char_modulo;
+	int y;
+
+	*element = *gfx;
+	element->gfxdata = buffer;
+	element->line_modulo = gfx->width;
+	element->char_modulo = gfx->width * gfx->height;
+	element->total_elements = 1;
+	element->pen_usage = gfx->pen_usage ? &gfx->pen_usage[code] : NULL;
+	element->flags &= ~GFX_PACKED;
+
+	for (y = 0;y < gfx->height;y++)
+		unpack_4bpp(buffer + y * gfx->width,src + y * gfx->line_modulo,gfx->width / 2);
+
+	return element;
+}
+
+
 
 
 static INLINE void blockmove_NtoN_transpen_noremap8(
@@ -892,6 +1413,30 @@ static INLINE void common_drawgfx(struct mame_bitmap *dest,const struct GfxEleme
 			transparency = TRANSPARENCY_NONE;
 	}
 
+	if ((gfx->flags & GFX_PACKED) && transparency != TRANSPARENCY_NONE && transparency != TRANSPARENCY_NONE_RAW
+			&& transparency != TRANSPARENCY_PEN && transparency != TRANSPARENCY_PEN_RAW
+			&& transparency != TRANSPARENCY_COLOR)
+	{
+		UINT8 stackbuf[UNPACK_STACK_BYTES];
+		UINT8 *buffer = stackbuf;
+		struct GfxElement element;
+
+		if (gfx->width * gfx->height > UNPACK_STACK_BYTES && (buffer = malloc(gfx->width * gfx->height)) == NULL)
+			return;
+		gfx = unpack_gfx_element(gfx,code,&element,buffer);
+
+		if (dest->depth == 8)
+			drawgfx_core8(dest,gfx,0,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+		else if(dest->depth == 15 || dest->depth == 16)
+			drawgfx_core16(dest,gfx,0,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+		else
+			drawgfx_core32(dest,gfx,0,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
+
+		if (buffer != stackbuf)
+			free(buffer);
+		return;
+	}
+
 	if (dest->depth == 8)
 		drawgfx_core8(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
 	else if(dest->depth == 15 || dest->depth == 16)
@@ -1347,6 +1892,9 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 {
 	struct rectangle myclip;
 	int alphapen = 0;
+	UINT8 stackbuf[UNPACK_STACK_BYTES];
+	UINT8 *unpacked = NULL;
+	struct GfxElement element;
 
 	UINT8 ah, al;
 
@@ -1386,6 +1934,17 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 	if (transparency == TRANSPARENCY_COLOR)
 		transparent_color = Machine->pens[transparent_color];
 
+	/* the zoomers read packed data themselves only when opaque or transpen at 8/16bpp */
+	if (gfx && (gfx->flags & GFX_PACKED)
+			&& !((transparency == TRANSPARENCY_NONE || transparency == TRANSPARENCY_PEN) && dest_bmp->depth <= 16))
+	{
+		unpacked = stackbuf;
+		if (gfx->width * gfx->height > UNPACK_STACK_BYTES && (unpacked = malloc(gfx->width * gfx->height)) == NULL)
+			return;
+		gfx = unpack_gfx_element(gfx,code % gfx->total_elements,&element,unpacked);
+		code = 0;
+	}
+
 
 	/*
 	scalex and scaley are 16.16 fixed point numbers
@@ -3427,6 +3986,9 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 			}
 		}
 	}
+
+	if (unpacked && unpacked != stackbuf)
+		free(unpacked);
 }
 
 void drawgfxzoom( struct mame_bitmap *dest_bmp,const struct GfxElement *gfx,
@@ -5138,6 +5700,11 @@ DECLARE(drawgfx_core,(
 			}
 		}
 
+		/* unflipped 8bpp elements without a priority buffer can go to the SIMD blitters */
+		if (blitrect_active && !flipx && !pribuf && !(gfx->flags & GFX_PACKED) &&
+				blitrect_draw(transparency,sizeof(DATA_TYPE),dd,dm,sd,sm,sh,ls,ts,flipy,dw,dh,paldata,color,transparent_color))
+			return;
+
 		switch (transparency)
 		{
 			case TRANSPARENCY_NONE:
@@ -184,6 +184,9 @@ void extract_scanline16(struct mame_bitmap *bitmap,int x,int y,int length,UINT16
 /* Alpha blending functions */
 extern int alpha_active;
 void alpha_init(void);
+
+/* SIMD rectangle blitters for drawgfx */
+int drawgfx_simd_init(int enable);
 static INLINE void alpha_set_level(int level) {
 	if(level == 0)
 		level = -1;
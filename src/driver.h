@@ -381,6 +381,26 @@ struct InternalMachineDriver
 /* automatically extend the palette creating a brighter copy for highlights */
 #define VIDEO_HAS_HIGHLIGHTS		0x0800
 
+/* video_update can run on a worker thread while the CPUs emulate the next frame. */
+/* It is called after video_eof, must redraw the whole cliprect, must not change */
+/* the palette, and may only read data the CPUs do not modify in the meantime */
+/* (buffered spriteram, or copies of video RAM and registers taken in video_eof */
+/* while video_update_threaded() is set; see pengo_vidhrdw.c). Partial updates */
+/* make the core fall back to rendering synchronously. */
+#define VIDEO_UPDATE_THREADED		0x1000
+
+/* graphics with up to 4 planes and an even width may be stored two pixels per */
+/* byte, halving their memory. This applies to every decodegfx() while the game */
+/* runs, so the driver and the chips it uses must draw them only through */
+/* drawgfx/drawgfxzoom and tilemaps, and never read gfxdata themselves. */
+#define VIDEO_PACKED_GFX			0x2000
+
+/* the driver's tile_get_info callbacks only read memory and fill in tile_info, */
+/* so that tilemaps with many dirty tiles may be refreshed on several threads */
+/* at once. Callbacks that write globals, or call tilemap functions, must not */
+/* set this. */
+#define VIDEO_REENTRANT_TILE_INFO	0x4000
+
 
 /* ----- flags for sound_attributes ----- */
 #define	SOUND_SUPPORTS_STEREO		0x0001
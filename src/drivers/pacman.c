@@ -2516,7 +2516,7 @@ static MACHINE_DRIVER_START( pacman )
 	MDRV_MACHINE_INIT(pacman)
 
 	/* video hardware */
-	MDRV_VIDEO_ATTRIBUTES(VIDEO_TYPE_RASTER)
+	MDRV_VIDEO_ATTRIBUTES(VIDEO_TYPE_RASTER | VIDEO_UPDATE_THREADED)
 	MDRV_SCREEN_SIZE(36*8, 28*8)
 	MDRV_VISIBLE_AREA(0*8, 36*8-1, 0*8, 28*8-1)
 	MDRV_GFXDECODE(gfxdecodeinfo)
@@ -2525,6 +2525,7 @@ static MACHINE_DRIVER_START( pacman )
 
 	MDRV_PALETTE_INIT(pacman)
 	MDRV_VIDEO_START(pacman)
+	MDRV_VIDEO_EOF(pengo)
 	MDRV_VIDEO_UPDATE(pengo)
 
 	/* sound hardware */
@@ -2612,7 +2613,9 @@ static MACHINE_DRIVER_START( vanvan )
 	MDRV_MACHINE_INIT(NULL)
 
 	/* video hardware */
+	MDRV_VIDEO_ATTRIBUTES(VIDEO_TYPE_RASTER)
 	MDRV_VISIBLE_AREA(2*8, 34*8-1, 0*8, 28*8-1)
+	MDRV_VIDEO_EOF(NULL)
 	MDRV_VIDEO_UPDATE(vanvan)
 
 	/* sound hardware */
@@ -2720,7 +2723,9 @@ static MACHINE_DRIVER_START( s2650games )
 
 	MDRV_VBLANK_DURATION(DEFAULT_REAL_60HZ_VBLANK_DURATION)
 
+	MDRV_VIDEO_ATTRIBUTES(VIDEO_TYPE_RASTER)
 	MDRV_VIDEO_START(s2650games)
+	MDRV_VIDEO_EOF(NULL)
 	MDRV_VIDEO_UPDATE(s2650games)
 
 	/* sound hardware */
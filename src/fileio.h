@@ -38,6 +38,8 @@ enum
 	FILETYPE_LANGUAGE,
 	FILETYPE_CTRLR,
 	FILETYPE_XML_DAT,
+	FILETYPE_PROFILE,
+	FILETYPE_GFXCACHE,
 	FILETYPE_end /* dummy last entry */
 };
 
@@ -37,7 +37,23 @@ static void copy_to_memory (int cpu, int addr, const UINT8 *source, int num_byte
 
 static void copy_from_memory (int cpu, int addr, UINT8 *dest, int num_bytes)
 {
+	const struct memory_zone *zone = memory_find_zone (cpu, addr, addr + num_bytes - 1);
 	int i;
+
+	if (zone)
+	{
+		/* plain RAM: read it directly, swizzling bytes within the data bus word */
+		const UINT8 *base = (const UINT8 *)zone->base - zone->start;
+		int xor = 0;
+		if (cpunum_databus_width (cpu) == 16)
+			xor = (cpunum_endianess (cpu) == CPU_IS_BE) ? BYTE_XOR_BE(0) : BYTE_XOR_LE(0);
+		else if (cpunum_databus_width (cpu) == 32)
+			xor = (cpunum_endianess (cpu) == CPU_IS_BE) ? BYTE4_XOR_BE(0) : BYTE4_XOR_LE(0);
+		for (i=0; i<num_bytes; i++)
+			dest[i] = base[(addr+i) ^ xor];
+		return;
+	}
+
 	for (i=0; i<num_bytes; i++)
 	{
 		dest[i] = cpunum_read_byte (cpu, addr+i);
@@ -15,6 +15,7 @@ VIDEO_START( pengo );
 WRITE_HANDLER( pengo_gfxbank_w );
 WRITE_HANDLER( pengo_flipscreen_w );
 
+VIDEO_EOF( pengo );
 VIDEO_UPDATE( pengo );
 
 WRITE_HANDLER( vanvan_bgcolor_w );
@@ -214,6 +214,7 @@ UI_PAN_UP                UI_PAN_DOWN              UI_PAN_LEFT
 UI_PAN_RIGHT             UI_TOGGLE_DEBUG          UI_SAVE_STATE
 UI_LOAD_STATE            UI_ADD_CHEAT             UI_DELETE_CHEAT
 UI_SAVE_CHEAT            UI_WATCH_VALUE           UI_EDIT_CHEAT
+UI_REWIND
 START1                   START2                   START3
 START4                   COIN1                    COIN2
 COIN3                    COIN4                    SERVICE1
@@ -416,6 +417,7 @@ struct ipd inputport_defaults[] =
   { IPT_UI_SAVE_CHEAT,        "Save Cheat",     SEQ_DEF_1(KEYCODE_NONE) },
   { IPT_UI_WATCH_VALUE,       "Watch Value",    SEQ_DEF_1(KEYCODE_NONE) },
   { IPT_UI_EDIT_CHEAT,        "Edit Cheat",     SEQ_DEF_1(KEYCODE_NONE) },
+  { IPT_UI_REWIND,            "Rewind",         SEQ_DEF_1(KEYCODE_BACKSPACE) },
 
 	{ IPT_START1, "P1 Start",  SEQ_DEF_3(KEYCODE_1, CODE_OR, JOYCODE_1_START) },
 	{ IPT_START2, "P2 Start", SEQ_DEF_3(KEYCODE_2, CODE_OR, JOYCODE_2_START) },
@@ -1122,6 +1124,7 @@ struct ik input_keywords[] =
 	{ "UI_SAVE_CHEAT",			IKT_IPT,		IPT_UI_SAVE_CHEAT },
 	{ "UI_WATCH_VALUE",			IKT_IPT,		IPT_UI_WATCH_VALUE },
 	{ "UI_EDIT_CHEAT",			IKT_IPT,		IPT_UI_EDIT_CHEAT },
+	{ "UI_REWIND",				IKT_IPT,		IPT_UI_REWIND },
 	{ "START1",					IKT_IPT,		IPT_START1 },
 	{ "START2",					IKT_IPT,		IPT_START2 },
 	{ "START3",					IKT_IPT,		IPT_START3 },
@@ -1573,7 +1576,7 @@ const char *generic_ctrl_label(int input)
     struct ipd *entry = &inputport_defaults[i];
     if(entry->type == input)
     {
-      if(input >= IPT_SERVICE1 && input <= IPT_UI_EDIT_CHEAT)
+      if((input >= IPT_SERVICE1 && input <= IPT_UI_EDIT_CHEAT) || input == IPT_UI_REWIND)
         return entry->name; /* these strings are not player-specific */
       else /* start with the third character, trimming the initial 'P1', 'P2', etc which we don't need for libretro */
         return &entry->name[3];
@@ -100,6 +100,9 @@ enum { IPT_END=1,IPT_PORT,
 	/* 8 player support */
 	IPT_START5, IPT_START6, IPT_START7, IPT_START8,
 	IPT_COIN5, IPT_COIN6, IPT_COIN7, IPT_COIN8,
+
+	/* added after the 8 player codes to keep the numbering of saved configurations */
+	IPT_UI_REWIND,
 	__ipt_max
 };
 
@@ -492,7 +492,10 @@ InputCode code_read_async(void)
 
 	for(i=0;i<code_mac;++i)
 		if (code_pressed_memory(i))
+		{
+			profiler_mark(PROFILER_END);
 			return i;
+		}
 
 	profiler_mark(PROFILER_END);
 
@@ -512,6 +515,7 @@ INT8 code_read_hex_async(void)
 	for(i=0;i<code_mac;++i)
 		if (code_pressed_memory(i))
 		{
+			profiler_mark(PROFILER_END);
 			if ((i >= KEYCODE_A) && (i <= KEYCODE_F))
 				return i - KEYCODE_A + 10;
 			else if ((i >= KEYCODE_0) && (i <= KEYCODE_9))
@@ -51,13 +51,35 @@
 	(such as RAM, ROM, NOP, and banking). Table values between 32 and 192
 	are assigned dynamically at startup.
 
+	Alongside each memory lookup table sits a page table with one host
+	pointer per upper-half index. When the whole block behind that index
+	is plain RAM, ROM (for reads) or a bank that reads and writes its
+	memory directly, the pointer is set so that pointer + address is the
+	byte to access, and the accessors skip the lookup and the handler
+	entirely. Every other block holds NULL and goes through the table as
+	described above. The page tables are rebuilt whenever a handler is
+	installed and patched whenever cpu_setbank() moves a bank.
+
 ***************************************************************************/
 
-/* macros for the profiler */
+/* macros for the profiler; marking every single access is too costly
+   outside of debug builds, so release builds charge memory accesses to
+   whichever section (normally the CPU) is performing them. Writes are
+   always counted, for the idle loop detection in cpuexec.c */
+#ifdef MAME_DEBUG
 #define MEMREADSTART			profiler_mark(PROFILER_MEMREAD);
 #define MEMREADEND(ret)			{ profiler_mark(PROFILER_END); return ret; }
-#define MEMWRITESTART			profiler_mark(PROFILER_MEMWRITE);
+#define MEMWRITESTART			memory_writes++; profiler_mark(PROFILER_MEMWRITE);
 #define MEMWRITEEND(ret)		{ (ret); profiler_mark(PROFILER_END); return; }
+#else
+#define MEMREADSTART
+#define MEMREADEND(ret)			{ return ret; }
+#define MEMWRITESTART			memory_writes++;
+#define MEMWRITEEND(ret)		{ (ret); return; }
+#endif
+
+/* with timing statistics, one access in this many + 1 to each handler is timed */
+#define HANDLER_TIMING_MASK		63
 
 #define DATABITS_TO_SHIFT(d)	(((d) == 32) ? 2 : ((d) == 16) ? 1 : 0)
 
@@ -93,12 +115,23 @@ struct handler_data
 	offs_t				top;				/* maximum offset for handler */
 };
 
+struct handler_count
+{
+	UINT64				accesses;			/* accesses through this entry */
+	UINT64				timed;				/* handler calls that were timed */
+	cycles_t			ticks;				/* osd_profiling_ticks() spent in the timed calls */
+};
+
 struct table_data
 {
 	UINT8 *				table;				/* pointer to base of table */
 	UINT8 				subtable_count;		/* number of subtables used */
 	UINT8 				subtable_alloc;		/* number of subtables allocated */
 	struct handler_data *handlers;			/* pointer to which set of handlers */
+	UINT8 **			pages;				/* direct pointer per level 1 entry, or NULL */
+	offs_t				bank_first[STATIC_RAM];	/* first level 1 entry mapping each bank */
+	offs_t				bank_end[STATIC_RAM];	/* last level 1 entry mapping each bank + 1 */
+	struct handler_count *counts;			/* per entry statistics, or NULL */
 };
 
 struct memport_data
@@ -153,13 +186,30 @@ static UINT8 *				writemem_lookup;				/* memory write lookup table */
 static UINT8 *				readport_lookup;				/* port read lookup table */
 static UINT8 *				writeport_lookup;				/* port write lookup table */
 
+static UINT8 **				readmem_pages;					/* memory read page table */
+static UINT8 **				writemem_pages;					/* memory write page table */
+static UINT8 **				readport_pages;					/* port read page table (always NULL) */
+static UINT8 **				writeport_pages;				/* port write page table (always NULL) */
+
+static struct handler_count *readmem_counts;				/* memory read statistics, or NULL */
+static struct handler_count *writemem_counts;				/* memory write statistics, or NULL */
+static struct handler_count *readport_counts;				/* port read statistics, or NULL */
+static struct handler_count *writeport_counts;				/* port write statistics, or NULL */
+static int					handler_timing;					/* time a sample of the handler calls */
+static cycles_t				timing_start_ticks;				/* osd_profiling_ticks() when timing started */
+static cycles_t				timing_start_usec;				/* osd_cycles() when timing started, to calibrate */
+
 offs_t						mem_amask;						/* memory address mask */
+UINT32						memory_writes;					/* memory and port writes so far */
 static offs_t				port_amask;						/* port address mask */
 
 UINT8 *						cpu_bankbase[STATIC_COUNT];		/* array of bank bases */
 int ext_entries = 0;										/* number of entries ext_memory[] entries used */
 struct ExtMemory			ext_memory[MAX_EXT_MEMORY];		/* externally-allocated memory */
 
+static struct memory_zone *	memory_zones;					/* RAM zones registered by register_banks() */
+static int					memory_zone_count;				/* number of memory_zones[] entries used */
+
 static data32_t				unmap_value;					/* unmapped memory value */
 
 static opbase_handler		opbasefunc;						/* opcode base override */
@@ -198,6 +248,8 @@ static void populate_table(struct memport_data *memport, int iswrite, offs_t sta
 static void *assign_dynamic_bank(int cpunum, offs_t start);
 static void install_mem_handler(struct memport_data *memport, int iswrite, offs_t start, offs_t end, void *handler);
 static void install_port_handler(struct memport_data *memport, int iswrite, offs_t start, offs_t end, void *handler);
+static void update_page_table(struct memport_data *memport, int iswrite);
+static void report_handler_stats(void);
 static void set_static_handler(int idx,
 		read8_handler r8handler, read16_handler r16handler, read32_handler r32handler,
 		write8_handler w8handler, write16_handler w16handler, write32_handler w32handler);
@@ -235,6 +287,9 @@ int memory_init(void)
 	/* no current context to start */
 	cur_context = -1;
 	unmap_value = 0;
+	handler_timing = (options.handler_stats == HANDLER_STATS_TIMING);
+	timing_start_usec = osd_cycles();
+	timing_start_ticks = osd_profiling_ticks();
 
 	/* init the static handlers */
 	if (!init_static())
@@ -281,6 +336,10 @@ void memory_shutdown(void)
 	int ext_entry;
 	int cpunum;
 
+	/* report the statistics before the tables go away */
+	if (options.handler_stats != HANDLER_STATS_NONE)
+		report_handler_stats();
+
 	/* free all the tables */
 	for (cpunum = 0; cpunum < MAX_CPU; cpunum++ )
 	{
@@ -292,6 +351,14 @@ void memory_shutdown(void)
 			free(cpudata[cpunum].port.read.table);
 		if (cpudata[cpunum].port.write.table)
 			free(cpudata[cpunum].port.write.table);
+		free(cpudata[cpunum].mem.read.pages);
+		free(cpudata[cpunum].mem.write.pages);
+		free(cpudata[cpunum].port.read.pages);
+		free(cpudata[cpunum].port.write.pages);
+		free(cpudata[cpunum].mem.read.counts);
+		free(cpudata[cpunum].mem.write.counts);
+		free(cpudata[cpunum].port.read.counts);
+		free(cpudata[cpunum].port.write.counts);
 	}
 	memset(&cpudata, 0, sizeof(cpudata));
 
@@ -304,6 +371,10 @@ void memory_shutdown(void)
 	}
 	memset(ext_memory, 0, sizeof(ext_memory));
 	ext_entries = 0;
+
+	free(memory_zones);
+	memory_zones = 0;
+	memory_zone_count = 0;
 }
 
 
@@ -365,6 +436,16 @@ void memory_set_context(int activecpu)
 	readport_lookup = cpudata[activecpu].port.read.table;
 	writeport_lookup = cpudata[activecpu].port.write.table;
 
+	readmem_pages = cpudata[activecpu].mem.read.pages;
+	writemem_pages = cpudata[activecpu].mem.write.pages;
+	readport_pages = cpudata[activecpu].port.read.pages;
+	writeport_pages = cpudata[activecpu].port.write.pages;
+
+	readmem_counts = cpudata[activecpu].mem.read.counts;
+	writemem_counts = cpudata[activecpu].mem.write.counts;
+	readport_counts = cpudata[activecpu].port.read.counts;
+	writeport_counts = cpudata[activecpu].port.write.counts;
+
 	mem_amask = cpudata[activecpu].mem.mask;
 	port_amask = cpudata[activecpu].port.mask;
 
@@ -402,6 +483,7 @@ void memory_set_bankhandler_r(int bank, offs_t offset, mem_read_handler handler)
 	if (HANDLER_IS_STATIC(handler))
 		handler = rmemhandler8s[(FPTR)handler];
 	rmemhandler8[bank].handler = (void *)handler;
+	memory_refresh_bank(bank);
 }
 
 
@@ -424,6 +506,7 @@ void memory_set_bankhandler_w(int bank, offs_t offset, mem_write_handler handler
 	if (HANDLER_IS_STATIC(handler))
 		handler = wmemhandler8s[(FPTR)handler];
 	wmemhandler8[bank].handler = (void *)handler;
+	memory_refresh_bank(bank);
 }
 
 
@@ -458,6 +541,8 @@ data8_t *install_mem_read_handler(int cpunum, offs_t start, offs_t end, mem_read
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 0, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -482,6 +567,8 @@ data16_t *install_mem_read16_handler(int cpunum, offs_t start, offs_t end, mem_r
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 0, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -506,6 +593,8 @@ data32_t *install_mem_read32_handler(int cpunum, offs_t start, offs_t end, mem_r
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 0, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -530,6 +619,8 @@ data8_t *install_mem_write_handler(int cpunum, offs_t start, offs_t end, mem_wri
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 1, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -554,6 +645,8 @@ data16_t *install_mem_write16_handler(int cpunum, offs_t start, offs_t end, mem_
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 1, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -578,6 +671,8 @@ data32_t *install_mem_write32_handler(int cpunum, offs_t start, offs_t end, mem_
 
 	/* install the handler */
 	install_mem_handler(&cpudata[cpunum].mem, 1, start, end, (void *)handler);
+	update_page_table(&cpudata[cpunum].mem, 0);
+	update_page_table(&cpudata[cpunum].mem, 1);
 #ifdef MEM_DUMP
 	/* dump the new memory configuration */
 	mem_dump();
@@ -767,6 +862,40 @@ void *memory_find_base(int cpunum, offs_t offset)
 }
 
 
+/*-------------------------------------------------
+	memory_get_zone_count/memory_get_zone - the
+	RAM zones registered into the state save
+	system, with their host pointers
+-------------------------------------------------*/
+
+int memory_get_zone_count(void)
+{
+	return memory_zone_count;
+}
+
+const struct memory_zone *memory_get_zone(int index)
+{
+	return (index >= 0 && index < memory_zone_count) ? &memory_zones[index] : NULL;
+}
+
+
+/*-------------------------------------------------
+	memory_find_zone - return the RAM zone that
+	holds the whole of start..end for the given
+	CPU, or NULL
+-------------------------------------------------*/
+
+const struct memory_zone *memory_find_zone(int cpunum, offs_t start, offs_t end)
+{
+	int i;
+
+	for (i = 0; i < memory_zone_count; i++)
+		if (memory_zones[i].cpunum == cpunum && memory_zones[i].start <= start && memory_zones[i].end >= end)
+			return &memory_zones[i];
+	return NULL;
+}
+
+
 /*-------------------------------------------------
 	memory_get_read_ptr - return a pointer to the
 	base of RAM associated with the given CPU
@@ -1043,6 +1172,125 @@ void install_port_handler(struct memport_data *memport, int iswrite, offs_t star
 }
 
 
+/*-------------------------------------------------
+	direct_base - return the direct page pointer
+	for a lookup table entry, or NULL if the
+	entry needs its handler
+-------------------------------------------------*/
+
+static UINT8 *direct_base(struct memport_data *memport, int iswrite, UINT8 entry)
+{
+	struct table_data *tabledata = iswrite ? &memport->write : &memport->read;
+	struct handler_data *handler = &tabledata->handlers[entry];
+	UINT8 *base;
+
+	/* RAM, and ROM which reads as RAM */
+	if (entry == STATIC_RAM)
+		base = cpudata[memport->cpunum].rambase;
+
+	/* banks, as long as the 8-bit ones still use the stock handler */
+	else if (entry >= STATIC_BANK1 && entry <= STATIC_BANKMAX)
+	{
+		if (memport->dbits == 8 && handler->handler != (iswrite ? (void *)wmemhandler8s[entry] : (void *)rmemhandler8s[entry]))
+			return NULL;
+		base = cpu_bankbase[entry];
+	}
+	else
+		return NULL;
+
+	/* the byte lanes only line up if the block starts on a bus boundary */
+	if (!base || (handler->offset & ((memport->dbits / 8) - 1)))
+		return NULL;
+	return base - (memport->dbits == 8 && entry == STATIC_RAM ? 0 : handler->offset);
+}
+
+
+/*-------------------------------------------------
+	page_base - return what the page table holds
+	for a lookup table entry; with statistics on
+	every access must reach the lookup table
+-------------------------------------------------*/
+
+static UINT8 *page_base(struct memport_data *memport, int iswrite, UINT8 entry)
+{
+	if ((iswrite ? memport->write.counts : memport->read.counts) != NULL)
+		return NULL;
+	return direct_base(memport, iswrite, entry);
+}
+
+
+/*-------------------------------------------------
+	update_page_table - rebuild the direct page
+	table for a memory space from its lookup
+	table
+-------------------------------------------------*/
+
+static void update_page_table(struct memport_data *memport, int iswrite)
+{
+	struct table_data *tabledata = iswrite ? &memport->write : &memport->read;
+	offs_t count = 1 << LEVEL1_BITS(memport->ebits);
+	UINT8 *base[SUBTABLE_BASE];
+	offs_t i;
+	int entry;
+
+	if (!tabledata->pages)
+		return;
+
+	for (entry = 0; entry < SUBTABLE_BASE; entry++)
+		base[entry] = page_base(memport, iswrite, entry);
+	memset(tabledata->bank_first, 0, sizeof(tabledata->bank_first));
+	memset(tabledata->bank_end, 0, sizeof(tabledata->bank_end));
+
+	for (i = 0; i < count; i++)
+	{
+		entry = tabledata->table[i];
+
+		/* blocks split by a subtable always take the slow path */
+		tabledata->pages[i] = (entry < SUBTABLE_BASE) ? base[entry] : NULL;
+
+		/* remember where each bank lives so cpu_setbank can patch it */
+		if (entry >= STATIC_BANK1 && entry <= STATIC_BANKMAX)
+		{
+			if (tabledata->bank_first[entry] == tabledata->bank_end[entry])
+				tabledata->bank_first[entry] = i;
+			tabledata->bank_end[entry] = i + 1;
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+	memory_refresh_bank - patch the direct pages
+	of every CPU that maps a bank after its base
+	or handler changed
+-------------------------------------------------*/
+
+void memory_refresh_bank(int bank)
+{
+	int cpunum, iswrite;
+
+	if (bank < STATIC_BANK1 || bank > STATIC_BANKMAX)
+		return;
+
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		for (iswrite = 0; iswrite < 2; iswrite++)
+		{
+			struct memport_data *memport = &cpudata[cpunum].mem;
+			struct table_data *tabledata = iswrite ? &memport->write : &memport->read;
+			UINT8 *base;
+			offs_t i;
+
+			if (!tabledata->pages || tabledata->bank_first[bank] == tabledata->bank_end[bank])
+				continue;
+
+			base = page_base(memport, iswrite, bank);
+			for (i = tabledata->bank_first[bank]; i < tabledata->bank_end[bank]; i++)
+				if (tabledata->table[i] == bank)
+					tabledata->pages[i] = base;
+		}
+}
+
+
 /*-------------------------------------------------
 	set_static_handler - handy shortcut for
 	setting all 6 handlers for a given index
@@ -1150,6 +1398,21 @@ static int init_memport(int cpunum, struct memport_data *data, int abits, int db
 	if (!data->write.table)
 		return fatalerror("cpu #%d couldn't allocate write table\n", cpunum);
 
+	/* page tables start out empty; ports never get any direct pages */
+	data->read.pages = calloc(1 << LEVEL1_BITS(data->ebits), sizeof(data->read.pages[0]));
+	data->write.pages = calloc(1 << LEVEL1_BITS(data->ebits), sizeof(data->write.pages[0]));
+	if (!data->read.pages || !data->write.pages)
+		return fatalerror("cpu #%d couldn't allocate page tables\n", cpunum);
+
+	/* optional per entry statistics */
+	if (options.handler_stats != HANDLER_STATS_NONE)
+	{
+		data->read.counts = calloc(ENTRY_COUNT, sizeof(data->read.counts[0]));
+		data->write.counts = calloc(ENTRY_COUNT, sizeof(data->write.counts[0]));
+		if (!data->read.counts || !data->write.counts)
+			return fatalerror("cpu #%d couldn't allocate handler statistics\n", cpunum);
+	}
+
 	/* initialize everything to unmapped */
 	memset(data->read.table, STATIC_UNMAP, 1 << LEVEL1_BITS(data->ebits));
 	memset(data->write.table, STATIC_UNMAP, 1 << LEVEL1_BITS(data->ebits));
@@ -1475,6 +1738,10 @@ static int populate_memory(void)
 					if (mwa->size) *mwa->size = mwa->end - mwa->start + 1;
 				}
 		}
+
+		/* build the direct pages once everything is in place */
+		update_page_table(&cpudata[cpunum].mem, 0);
+		update_page_table(&cpudata[cpunum].mem, 1);
 	}
 	return 1;
 }
@@ -1631,6 +1898,20 @@ static void rg_map_clear(void)
 static void register_zone(int cpunum, UINT32 start, UINT32 end)
 {
 	char name[256];
+	struct memory_zone *zones;
+
+	zones = realloc(memory_zones, (memory_zone_count + 1) * sizeof(*zones));
+	if (zones)
+	{
+		memory_zones = zones;
+		zones[memory_zone_count].cpunum = cpunum;
+		zones[memory_zone_count].start = start;
+		zones[memory_zone_count].end = end;
+		zones[memory_zone_count].base = memory_find_base(cpunum, start);
+		if (zones[memory_zone_count].base)
+			memory_zone_count++;
+	}
+
 	sprintf (name, "%08x-%08x", start, end);
 	switch (cpunum_databus_width(cpunum))
 	{
@@ -1652,6 +1933,10 @@ void register_banks(void)
 	int banksize[MAX_BANKS];
 	int bankcpu[MAX_BANKS];
 
+	free(memory_zones);
+	memory_zones = 0;
+	memory_zone_count = 0;
+
 	for (i=0; i<MAX_BANKS; i++)
 	{
 		banksize[i] = 0;
@@ -1794,22 +2079,213 @@ void register_banks(void)
 
 }
 
+
+/*-------------------------------------------------
+	timed_read/timed_write - call a handler for
+	the statistics and charge its time to the
+	entry
+-------------------------------------------------*/
+
+static data8_t timed_read8(struct handler_count *count, read8_handler handler, offs_t offset)
+{
+	cycles_t start = osd_profiling_ticks();
+	data8_t result = (*handler)(offset);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+	return result;
+}
+
+static data16_t timed_read16(struct handler_count *count, read16_handler handler, offs_t offset, data16_t mem_mask)
+{
+	cycles_t start = osd_profiling_ticks();
+	data16_t result = (*handler)(offset, mem_mask);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+	return result;
+}
+
+static data32_t timed_read32(struct handler_count *count, read32_handler handler, offs_t offset, data32_t mem_mask)
+{
+	cycles_t start = osd_profiling_ticks();
+	data32_t result = (*handler)(offset, mem_mask);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+	return result;
+}
+
+static void timed_write8(struct handler_count *count, write8_handler handler, offs_t offset, data8_t data)
+{
+	cycles_t start = osd_profiling_ticks();
+	(*handler)(offset, data);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+}
+
+static void timed_write16(struct handler_count *count, write16_handler handler, offs_t offset, data16_t data, data16_t mem_mask)
+{
+	cycles_t start = osd_profiling_ticks();
+	(*handler)(offset, data, mem_mask);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+}
+
+static void timed_write32(struct handler_count *count, write32_handler handler, offs_t offset, data32_t data, data32_t mem_mask)
+{
+	cycles_t start = osd_profiling_ticks();
+	(*handler)(offset, data, mem_mask);
+	count->ticks += osd_profiling_ticks() - start;
+	count->timed++;
+}
+
+
+/*-------------------------------------------------
+	report_handler_stats - log the busiest
+	lookup entries of every CPU, most accessed
+	first
+-------------------------------------------------*/
+
+#define HANDLER_REPORT_LINES	40
+
+struct handler_report
+{
+	UINT8				cpunum;
+	UINT8				isport;
+	UINT8				iswrite;
+	UINT8				entry;
+	const struct handler_count *count;
+};
+
+static int compare_handler_reports(const void *a, const void *b)
+{
+	UINT64 ca = ((const struct handler_report *)a)->count->accesses;
+	UINT64 cb = ((const struct handler_report *)b)->count->accesses;
+	return (ca < cb) - (ca > cb);
+}
+
+static void report_handler_stats(void)
+{
+	struct handler_report *report;
+	int reports = 0, cpunum, isport, iswrite, entry, i;
+	UINT64 total = 0;
+	double ns_per_tick = 0;
+
+	/* calibrate the tick counter against osd_cycles() over the whole run */
+	if (handler_timing)
+	{
+		cycles_t ticks = osd_profiling_ticks() - timing_start_ticks;
+		cycles_t usec = osd_cycles() - timing_start_usec;
+		ns_per_tick = (ticks > 0 && usec > 0) ? (double)usec * 1000.0 / (double)ticks : 1000.0;
+	}
+
+	report = malloc(MAX_CPU * 4 * ENTRY_COUNT * sizeof(report[0]));
+	if (!report)
+		return;
+
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		for (isport = 0; isport < 2; isport++)
+			for (iswrite = 0; iswrite < 2; iswrite++)
+			{
+				struct memport_data *memport = isport ? &cpudata[cpunum].port : &cpudata[cpunum].mem;
+				struct handler_count *counts = iswrite ? memport->write.counts : memport->read.counts;
+
+				if (!counts)
+					continue;
+				for (entry = 0; entry < ENTRY_COUNT; entry++)
+					if (counts[entry].accesses)
+					{
+						report[reports].cpunum = cpunum;
+						report[reports].isport = isport;
+						report[reports].iswrite = iswrite;
+						report[reports].entry = entry;
+						report[reports].count = &counts[entry];
+						total += counts[entry].accesses;
+						reports++;
+					}
+			}
+
+	if (reports)
+	{
+		qsort(report, reports, sizeof(report[0]), compare_handler_reports);
+
+		log_cb(RETRO_LOG_INFO, LOGPRE "Memory handler statistics: %.0f accesses, busiest %d of %d entries\n",
+				(double)total, (reports < HANDLER_REPORT_LINES) ? reports : HANDLER_REPORT_LINES, reports);
+		log_cb(RETRO_LOG_INFO, LOGPRE "%3s %-5s %-3s %-18s %-9s %-6s %14s %6s%s\n",
+				"cpu", "space", "dir", "range", "kind", "path", "accesses", "share", handler_timing ? "   ns/call" : "");
+
+		for (i = 0; i < reports && i < HANDLER_REPORT_LINES; i++)
+		{
+			const struct handler_report *r = &report[i];
+			struct memport_data *memport = r->isport ? &cpudata[r->cpunum].port : &cpudata[r->cpunum].mem;
+			struct table_data *tabledata = r->iswrite ? &memport->write : &memport->read;
+			const struct handler_data *handler = &tabledata->handlers[r->entry];
+			char range[20], kind[10], timing[16] = "";
+
+			/* the static entries cover many ranges; banks and handlers have their own */
+			if (r->entry > STATIC_BANKMAX && r->entry < STATIC_COUNT)
+				strcpy(range, "-");
+			else
+				sprintf(range, "%08X-%08X", handler->offset, handler->top);
+
+			if (r->entry == STATIC_RAM)
+				strcpy(kind, "RAM");
+			else if (r->entry == STATIC_ROM)
+				strcpy(kind, "ROM");
+			else if (r->entry == STATIC_RAMROM)
+				strcpy(kind, "RAMROM");
+			else if (r->entry == STATIC_NOP)
+				strcpy(kind, "NOP");
+			else if (r->entry == STATIC_UNMAP)
+				strcpy(kind, "unmapped");
+			else if (r->entry >= STATIC_BANK1 && r->entry <= STATIC_BANKMAX)
+				sprintf(kind, "bank%d", r->entry);
+			else if (r->entry < STATIC_COUNT)
+				strcpy(kind, "static");
+			else
+				strcpy(kind, "handler");
+
+			if (handler_timing && r->count->timed)
+				sprintf(timing, " %9.1f", (double)r->count->ticks * ns_per_tick / r->count->timed);
+			else if (handler_timing)
+				strcpy(timing, "         -");
+
+			/* "direct" entries are served by the page table when statistics are off */
+			log_cb(RETRO_LOG_INFO, LOGPRE "%3d %-5s %-3s %-18s %-9s %-6s %14.0f %5.1f%%%s\n",
+					r->cpunum, r->isport ? "port" : "mem", r->iswrite ? "W" : "R", range, kind,
+					(!r->isport && direct_base(memport, r->iswrite, r->entry)) ? "direct" : "lookup",
+					(double)r->count->accesses, 100.0 * r->count->accesses / total, timing);
+		}
+	}
+	free(report);
+}
+
+
 /*-------------------------------------------------
 	READBYTE - generic byte-sized read handler
 -------------------------------------------------*/
 
-#define READBYTE8(name,abits,lookup,handlist,mask)										\
+#define READBYTE8(name,abits,lookup,pages,counts,handlist,mask)							\
 data8_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,0)];										\
+	if (base)																			\
+		MEMREADEND(base[address])														\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,0)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,0)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* for compatibility with setbankhandler, 8-bit systems */							\
 	/* must call handlers for banks */													\
 	if (entry == STATIC_RAM)															\
@@ -1819,23 +2295,36 @@ data8_t name(offs_t address)															\
 	else																				\
 	{																					\
 		read8_handler handler = (read8_handler)handlist[entry].handler;					\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read8(&counts[entry], handler, address - handlist[entry].offset)) \
 		MEMREADEND((*handler)(address - handlist[entry].offset))						\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READBYTE16BE(name,abits,lookup,handlist,mask)									\
+#define READBYTE16BE(name,abits,lookup,pages,counts,handlist,mask)						\
 data8_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMREADEND(base[BYTE_XOR_BE(address)])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1846,23 +2335,36 @@ data8_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (~address & 1);													\
 		read16_handler handler = (read16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read16(&counts[entry], handler, address >> 1, ~(0xff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 1, ~(0xff << shift)) >> shift)					\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READBYTE16LE(name,abits,lookup,handlist,mask)									\
+#define READBYTE16LE(name,abits,lookup,pages,counts,handlist,mask)						\
 data8_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMREADEND(base[BYTE_XOR_LE(address)])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1873,23 +2375,36 @@ data8_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (address & 1);													\
 		read16_handler handler = (read16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read16(&counts[entry], handler, address >> 1, ~(0xff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 1, ~(0xff << shift)) >> shift)					\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READBYTE32BE(name,abits,lookup,handlist,mask)									\
+#define READBYTE32BE(name,abits,lookup,pages,counts,handlist,mask)						\
 data8_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMREADEND(base[BYTE4_XOR_BE(address)])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1900,23 +2415,36 @@ data8_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (~address & 3);													\
 		read32_handler handler = (read32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read32(&counts[entry], handler, address >> 2, ~(0xff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 2, ~(0xff << shift)) >> shift) 				\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READBYTE32LE(name,abits,lookup,handlist,mask)									\
+#define READBYTE32LE(name,abits,lookup,pages,counts,handlist,mask)						\
 data8_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMREADEND(base[BYTE4_XOR_LE(address)])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1927,6 +2455,8 @@ data8_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (address & 3);													\
 		read32_handler handler = (read32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read32(&counts[entry], handler, address >> 2, ~(0xff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 2, ~(0xff << shift)) >> shift) 				\
 	}																					\
 	return 0;																			\
@@ -1938,18 +2468,29 @@ data8_t name(offs_t address)															\
 	(16-bit and 32-bit aligned only!)
 -------------------------------------------------*/
 
-#define READWORD16(name,abits,lookup,handlist,mask)										\
+#define READWORD16(name,abits,lookup,pages,counts,handlist,mask)						\
 data16_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMREADEND(*(data16_t *)&base[address])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1959,23 +2500,36 @@ data16_t name(offs_t address)															\
 	else																				\
 	{																					\
 		read16_handler handler = (read16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read16(&counts[entry], handler, address >> 1,0))			\
 		MEMREADEND((*handler)(address >> 1,0))										 	\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READWORD32BE(name,abits,lookup,handlist,mask)									\
+#define READWORD32BE(name,abits,lookup,pages,counts,handlist,mask)						\
 data16_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMREADEND(*(data16_t *)&base[WORD_XOR_BE(address)])							\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -1986,23 +2540,36 @@ data16_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (~address & 2);													\
 		read32_handler handler = (read32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read32(&counts[entry], handler, address >> 2, ~(0xffff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 2, ~(0xffff << shift)) >> shift)				\
 	}																					\
 	return 0;																			\
 }																						\
 
-#define READWORD32LE(name,abits,lookup,handlist,mask)									\
+#define READWORD32LE(name,abits,lookup,pages,counts,handlist,mask)						\
 data16_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMREADEND(*(data16_t *)&base[WORD_XOR_LE(address)])							\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2013,6 +2580,8 @@ data16_t name(offs_t address)															\
 	{																					\
 		int shift = 8 * (address & 2);													\
 		read32_handler handler = (read32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read32(&counts[entry], handler, address >> 2, ~(0xffff << shift)) >> shift) \
 		MEMREADEND((*handler)(address >> 2, ~(0xffff << shift)) >> shift)				\
 	}																					\
 	return 0;																			\
@@ -2024,18 +2593,29 @@ data16_t name(offs_t address)															\
 	(32-bit aligned only!)
 -------------------------------------------------*/
 
-#define READLONG32(name,abits,lookup,handlist,mask)										\
+#define READLONG32(name,abits,lookup,pages,counts,handlist,mask)						\
 data32_t name(offs_t address)															\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMREADSTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~3;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMREADEND(*(data32_t *)&base[address])											\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2045,6 +2625,8 @@ data32_t name(offs_t address)															\
 	else																				\
 	{																					\
 		read32_handler handler = (read32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMREADEND(timed_read32(&counts[entry], handler, address >> 2,0))			\
 		MEMREADEND((*handler)(address >> 2,0))										 	\
 	}																					\
 	return 0;																			\
@@ -2055,18 +2637,29 @@ data32_t name(offs_t address)															\
 	WRITEBYTE - generic byte-sized write handler
 -------------------------------------------------*/
 
-#define WRITEBYTE8(name,abits,lookup,handlist,mask)										\
+#define WRITEBYTE8(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data8_t data)													\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,0)];										\
+	if (base)																			\
+		MEMWRITEEND(base[address] = data)												\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,0)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,0)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* for compatibility with setbankhandler, 8-bit systems */							\
 	/* must call handlers for banks */													\
 	if (entry == (FPTR)MRA_RAM)															\
@@ -2076,22 +2669,35 @@ void name(offs_t address, data8_t data)													\
 	else																				\
 	{																					\
 		write8_handler handler = (write8_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write8(&counts[entry], handler, address - handlist[entry].offset, data)) \
 		MEMWRITEEND((*handler)(address - handlist[entry].offset, data))					\
 	}																					\
 }																						\
 
-#define WRITEBYTE16BE(name,abits,lookup,handlist,mask)									\
+#define WRITEBYTE16BE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data8_t data)													\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMWRITEEND(base[BYTE_XOR_BE(address)] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2102,22 +2708,35 @@ void name(offs_t address, data8_t data)													\
 	{																					\
 		int shift = 8 * (~address & 1);													\
 		write16_handler handler = (write16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write16(&counts[entry], handler, address >> 1, data << shift, ~(0xff << shift))) \
 		MEMWRITEEND((*handler)(address >> 1, data << shift, ~(0xff << shift))) 			\
 	}																					\
 }																						\
 
-#define WRITEBYTE16LE(name,abits,lookup,handlist,mask)									\
+#define WRITEBYTE16LE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data8_t data)													\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMWRITEEND(base[BYTE_XOR_LE(address)] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2128,22 +2747,35 @@ void name(offs_t address, data8_t data)													\
 	{																					\
 		int shift = 8 * (address & 1);													\
 		write16_handler handler = (write16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write16(&counts[entry], handler, address >> 1, data << shift, ~(0xff << shift))) \
 		MEMWRITEEND((*handler)(address >> 1, data << shift, ~(0xff << shift)))			\
 	}																					\
 }																						\
 
-#define WRITEBYTE32BE(name,abits,lookup,handlist,mask)									\
+#define WRITEBYTE32BE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data8_t data)													\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMWRITEEND(base[BYTE4_XOR_BE(address)] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2154,22 +2786,35 @@ void name(offs_t address, data8_t data)													\
 	{																					\
 		int shift = 8 * (~address & 3);													\
 		write32_handler handler = (write32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write32(&counts[entry], handler, address >> 2, data << shift, ~(0xff << shift))) \
 		MEMWRITEEND((*handler)(address >> 2, data << shift, ~(0xff << shift))) 			\
 	}																					\
 }																						\
 
-#define WRITEBYTE32LE(name,abits,lookup,handlist,mask)									\
+#define WRITEBYTE32LE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data8_t data)													\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask;																	\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMWRITEEND(base[BYTE4_XOR_LE(address)] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2180,6 +2825,8 @@ void name(offs_t address, data8_t data)													\
 	{																					\
 		int shift = 8 * (address & 3);													\
 		write32_handler handler = (write32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write32(&counts[entry], handler, address >> 2, data << shift, ~(0xff << shift))) \
 		MEMWRITEEND((*handler)(address >> 2, data << shift, ~(0xff << shift))) 			\
 	}																					\
 }																						\
@@ -2190,18 +2837,29 @@ void name(offs_t address, data8_t data)													\
 	(16-bit and 32-bit aligned only!)
 -------------------------------------------------*/
 
-#define WRITEWORD16(name,abits,lookup,handlist,mask)									\
+#define WRITEWORD16(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data16_t data)												\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,1)];										\
+	if (base)																			\
+		MEMWRITEEND(*(data16_t *)&base[address] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,1)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,1)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2211,22 +2869,35 @@ void name(offs_t address, data16_t data)												\
 	else																				\
 	{																					\
 		write16_handler handler = (write16_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write16(&counts[entry], handler, address >> 1, data, 0))	\
 		MEMWRITEEND((*handler)(address >> 1, data, 0))								 	\
 	}																					\
 }																						\
 
-#define WRITEWORD32BE(name,abits,lookup,handlist,mask)									\
+#define WRITEWORD32BE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data16_t data)												\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMWRITEEND(*(data16_t *)&base[WORD_XOR_BE(address)] = data)					\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2237,22 +2908,35 @@ void name(offs_t address, data16_t data)												\
 	{																					\
 		int shift = 8 * (~address & 2);													\
 		write32_handler handler = (write32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write32(&counts[entry], handler, address >> 2, data << shift, ~(0xffff << shift))) \
 		MEMWRITEEND((*handler)(address >> 2, data << shift, ~(0xffff << shift))) 		\
 	}																					\
 }																						\
 
-#define WRITEWORD32LE(name,abits,lookup,handlist,mask)									\
+#define WRITEWORD32LE(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data16_t data)												\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~1;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMWRITEEND(*(data16_t *)&base[WORD_XOR_LE(address)] = data)					\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2263,6 +2947,8 @@ void name(offs_t address, data16_t data)												\
 	{																					\
 		int shift = 8 * (address & 2);													\
 		write32_handler handler = (write32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write32(&counts[entry], handler, address >> 2, data << shift, ~(0xffff << shift))) \
 		MEMWRITEEND((*handler)(address >> 2, data << shift, ~(0xffff << shift))) 		\
 	}																					\
 }																						\
@@ -2273,18 +2959,29 @@ void name(offs_t address, data16_t data)												\
 	(32-bit aligned only!)
 -------------------------------------------------*/
 
-#define WRITELONG32(name,abits,lookup,handlist,mask)									\
+#define WRITELONG32(name,abits,lookup,pages,counts,handlist,mask)						\
 void name(offs_t address, data32_t data)												\
 {																						\
-	UINT8 entry;																		\
+	UINT8 entry, *base;																	\
 	MEMWRITESTART																		\
 																						\
 	/* perform lookup */																\
 	address &= mask & ~3;																\
+																						\
+	/* plain memory goes straight through the page table */								\
+	base = pages[LEVEL1_INDEX(address,abits,2)];										\
+	if (base)																			\
+		MEMWRITEEND(*(data32_t *)&base[address] = data)									\
+																						\
+	/* otherwise use the lookup table */												\
 	entry = lookup[LEVEL1_INDEX(address,abits,2)];										\
 	if (entry >= SUBTABLE_BASE)															\
 		entry = lookup[LEVEL2_INDEX(entry,address,abits,2)];							\
 																						\
+	/* optional statistics */															\
+	if (counts)																			\
+		counts[entry].accesses++;														\
+																						\
 	/* handle banks inline */															\
 	address -= handlist[entry].offset;													\
 	if (entry <= STATIC_RAM)															\
@@ -2294,6 +2991,8 @@ void name(offs_t address, data32_t data)												\
 	else																				\
 	{																					\
 		write32_handler handler = (write32_handler)handlist[entry].handler;				\
+		if (counts && handler_timing && !(counts[entry].accesses & HANDLER_TIMING_MASK)) \
+			MEMWRITEEND(timed_write32(&counts[entry], handler, address >> 2, data, 0))	\
 		MEMWRITEEND((*handler)(address >> 2, data, 0))								 	\
 	}																					\
 }																						\
@@ -2357,36 +3056,36 @@ void name(offs_t pc)																	\
 -------------------------------------------------*/
 
 #define GENERATE_HANDLERS_8BIT(type, abits) \
-	    READBYTE8(cpu_read##type##abits,             abits, read##type##_lookup,  r##type##handler8,  type##_amask) \
-	   WRITEBYTE8(cpu_write##type##abits,            abits, write##type##_lookup, w##type##handler8,  type##_amask)
+	    READBYTE8(cpu_read##type##abits,             abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler8,  type##_amask) \
+	   WRITEBYTE8(cpu_write##type##abits,            abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler8,  type##_amask)
 
 #define GENERATE_HANDLERS_16BIT_BE(type, abits) \
-	 READBYTE16BE(cpu_read##type##abits##bew,        abits, read##type##_lookup,  r##type##handler16, type##_amask) \
-	   READWORD16(cpu_read##type##abits##bew_word,   abits, read##type##_lookup,  r##type##handler16, type##_amask) \
-	WRITEBYTE16BE(cpu_write##type##abits##bew,       abits, write##type##_lookup, w##type##handler16, type##_amask) \
-	  WRITEWORD16(cpu_write##type##abits##bew_word,  abits, write##type##_lookup, w##type##handler16, type##_amask)
+	 READBYTE16BE(cpu_read##type##abits##bew,        abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler16, type##_amask) \
+	   READWORD16(cpu_read##type##abits##bew_word,   abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler16, type##_amask) \
+	WRITEBYTE16BE(cpu_write##type##abits##bew,       abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler16, type##_amask) \
+	  WRITEWORD16(cpu_write##type##abits##bew_word,  abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler16, type##_amask)
 
 #define GENERATE_HANDLERS_16BIT_LE(type, abits) \
-	 READBYTE16LE(cpu_read##type##abits##lew,        abits, read##type##_lookup,  r##type##handler16, type##_amask) \
-	   READWORD16(cpu_read##type##abits##lew_word,   abits, read##type##_lookup,  r##type##handler16, type##_amask) \
-	WRITEBYTE16LE(cpu_write##type##abits##lew,       abits, write##type##_lookup, w##type##handler16, type##_amask) \
-	  WRITEWORD16(cpu_write##type##abits##lew_word,  abits, write##type##_lookup, w##type##handler16, type##_amask)
+	 READBYTE16LE(cpu_read##type##abits##lew,        abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler16, type##_amask) \
+	   READWORD16(cpu_read##type##abits##lew_word,   abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler16, type##_amask) \
+	WRITEBYTE16LE(cpu_write##type##abits##lew,       abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler16, type##_amask) \
+	  WRITEWORD16(cpu_write##type##abits##lew_word,  abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler16, type##_amask)
 
 #define GENERATE_HANDLERS_32BIT_BE(type, abits) \
-	 READBYTE32BE(cpu_read##type##abits##bedw,       abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	 READWORD32BE(cpu_read##type##abits##bedw_word,  abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	   READLONG32(cpu_read##type##abits##bedw_dword, abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	WRITEBYTE32BE(cpu_write##type##abits##bedw,      abits, write##type##_lookup, w##type##handler32, type##_amask) \
-	WRITEWORD32BE(cpu_write##type##abits##bedw_word, abits, write##type##_lookup, w##type##handler32, type##_amask) \
-	  WRITELONG32(cpu_write##type##abits##bedw_dword,abits, write##type##_lookup, w##type##handler32, type##_amask)
+	 READBYTE32BE(cpu_read##type##abits##bedw,       abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	 READWORD32BE(cpu_read##type##abits##bedw_word,  abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	   READLONG32(cpu_read##type##abits##bedw_dword, abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	WRITEBYTE32BE(cpu_write##type##abits##bedw,      abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask) \
+	WRITEWORD32BE(cpu_write##type##abits##bedw_word, abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask) \
+	  WRITELONG32(cpu_write##type##abits##bedw_dword,abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask)
 
 #define GENERATE_HANDLERS_32BIT_LE(type, abits) \
-	 READBYTE32LE(cpu_read##type##abits##ledw,       abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	 READWORD32LE(cpu_read##type##abits##ledw_word,  abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	   READLONG32(cpu_read##type##abits##ledw_dword, abits, read##type##_lookup,  r##type##handler32, type##_amask) \
-	WRITEBYTE32LE(cpu_write##type##abits##ledw,      abits, write##type##_lookup, w##type##handler32, type##_amask) \
-	WRITEWORD32LE(cpu_write##type##abits##ledw_word, abits, write##type##_lookup, w##type##handler32, type##_amask) \
-	  WRITELONG32(cpu_write##type##abits##ledw_dword,abits, write##type##_lookup, w##type##handler32, type##_amask)
+	 READBYTE32LE(cpu_read##type##abits##ledw,       abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	 READWORD32LE(cpu_read##type##abits##ledw_word,  abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	   READLONG32(cpu_read##type##abits##ledw_dword, abits, read##type##_lookup,  read##type##_pages,  read##type##_counts,  r##type##handler32, type##_amask) \
+	WRITEBYTE32LE(cpu_write##type##abits##ledw,      abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask) \
+	WRITEWORD32LE(cpu_write##type##abits##ledw_word, abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask) \
+	  WRITELONG32(cpu_write##type##abits##ledw_dword,abits, write##type##_lookup, write##type##_pages, write##type##_counts, w##type##handler32, type##_amask)
 
 
 /*-------------------------------------------------
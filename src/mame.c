@@ -104,6 +104,7 @@
 #include <ctype.h>
 #include <stdarg.h>
 #include <file/file_path.h>
+#include <zlib.h>
 #include "ui_text.h"
 #include "mamedbg.h"
 #include "artwork.h"
@@ -161,6 +162,20 @@ static UINT8 visible_area_changed;
 static UINT8 full_refresh_pending;
 static int last_partial_scanline;
 
+/* rendering on a worker thread (VIDEO_UPDATE_THREADED) */
+static struct osd_thread *render_thread;
+static struct mame_bitmap *render_bitmap;		/* target of the worker, swapped with scrbitmap when done */
+static struct rectangle render_clip;
+static int render_erase_pen;					/* pen to erase render_bitmap with first, or -1 */
+static int render_pending;						/* the worker has a frame in progress */
+static int render_frame_ready;					/* scrbitmap holds a frame which has not been shown */
+static rgb_t *render_palette;					/* colors of the frames being rendered */
+static UINT32 *render_palette_dirty;
+static int render_palette_entries;
+static int render_palette_changed;
+static const rgb_t *live_palette;				/* palette.c's own palette and dirty bits */
+static UINT32 *live_palette_dirty;
+
 /* speed computation */
 static struct performance_info performance;
 
@@ -224,6 +239,8 @@ static int decode_graphics(const struct GfxDecodeInfo *gfxdecodeinfo);
 static void compute_aspect_ratio(const struct InternalMachineDriver *drv, int *aspect_x, int *aspect_y);
 static void scale_vectorgames(int gfx_width, int gfx_height, int *width, int *height);
 static int init_buffered_spriteram(void);
+static void threaded_render_start(void);
+static void threaded_render_stop(void);
 
 
 /***************************************************************************
@@ -478,6 +495,9 @@ void run_machine_done(void)
 {				
 	sound_stop();
 
+	/* finish any frame in progress before the driver's video goes away */
+	threaded_render_stop();
+
     /* shut down the driver's video and kill and artwork */
     if (Machine->drv->video_stop)
         (*Machine->drv->video_stop)();
@@ -604,6 +624,9 @@ static int vh_open(void)
 	int bmwidth = Machine->drv->screen_width;
 	int bmheight = Machine->drv->screen_height;
 
+	/* draw 8bpp elements with the SIMD blitters when the CPU has them */
+	drawgfx_simd_init(1);
+
 	/* first allocate the necessary palette structures */
 	if (palette_start())
 		goto cant_start_palette;
@@ -710,6 +733,9 @@ static int vh_open(void)
 	pdrawgfx_shadow_lowpri = 0;
 	leds_status = 0;
 
+	/* render on a worker thread if the driver allows it */
+	threaded_render_start();
+
 	return 0;
 
 cant_init_palette:
@@ -739,6 +765,9 @@ static void vh_close(void)
 {
 	int i;
 
+	/* the worker may still be drawing with the graphics elements */
+	threaded_render_stop();
+
 	/* free all the graphics elements */
 	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
 	{
@@ -836,14 +865,161 @@ static void init_game_options(void)
 
 
 
+/*-------------------------------------------------
+	graphics decode cache
+
+	With options.gfx_cache the decoded sets are
+	kept in gfxcache/<game>.gfx: a header with one
+	entry per gfxdecodeinfo slot, then each set's
+	pixel data and pen usage, 16-byte aligned and
+	in native byte order. An entry is only used if
+	the CRCs of its source region and its layout
+	still match; GFX_RAW sets are not stored.
+-------------------------------------------------*/
+
+#define GFX_CACHE_MAGIC		0x58464743	/* "CGFX" */
+#define GFX_CACHE_VERSION	1
+#define GFX_CACHE_ALIGN		16
+
+struct gfx_cache_entry
+{
+	UINT32 present;
+	UINT32 region_crc;			/* crc32 of the whole source region */
+	UINT32 layout_crc;			/* crc32 of the layout, start offset and packing */
+	UINT32 width, height, total_elements;
+	UINT32 line_modulo, char_modulo, flags;
+	UINT32 has_pen_usage;
+	UINT32 offset;				/* of the pixel data; the pen usage follows it */
+};
+
+struct gfx_cache_header
+{
+	UINT32 magic;
+	UINT32 version;
+	struct gfx_cache_entry entry[MAX_GFX_ELEMENTS];
+};
+
+static UINT32 gfx_cache_layout_crc(const struct GfxLayout *gl, int start)
+{
+	UINT32 packed = (Machine->drv->video_attributes & VIDEO_PACKED_GFX) ? 1 : 0;
+	UINT32 crc = crc32(0, (const UINT8 *)&start, sizeof(start));
+
+	crc = crc32(crc, (const UINT8 *)&packed, sizeof(packed));
+	crc = crc32(crc, (const UINT8 *)&gl->width, sizeof(gl->width));
+	crc = crc32(crc, (const UINT8 *)&gl->height, sizeof(gl->height));
+	crc = crc32(crc, (const UINT8 *)&gl->total, sizeof(gl->total));
+	crc = crc32(crc, (const UINT8 *)&gl->planes, sizeof(gl->planes));
+	crc = crc32(crc, (const UINT8 *)gl->planeoffset, sizeof(gl->planeoffset));
+	crc = crc32(crc, (const UINT8 *)gl->xoffset, sizeof(gl->xoffset));
+	crc = crc32(crc, (const UINT8 *)gl->yoffset, sizeof(gl->yoffset));
+	return crc32(crc, (const UINT8 *)&gl->charincrement, sizeof(gl->charincrement));
+}
+
+static struct GfxElement *gfx_cache_load(FILE *file, const struct gfx_cache_entry *entry, const struct GfxLayout *gl)
+{
+	struct GfxElement *gfx;
+	size_t size = entry->total_elements * entry->char_modulo;
+
+	if ((gfx = calloc(1, sizeof(struct GfxElement))) == NULL)
+		return NULL;
+
+	gfx->width = entry->width;
+	gfx->height = entry->height;
+	gfx->total_elements = entry->total_elements;
+	gfx->color_granularity = 1 << gl->planes;
+	gfx->line_modulo = entry->line_modulo;
+	gfx->char_modulo = entry->char_modulo;
+	gfx->flags = entry->flags;
+	gfx->gfxdata = malloc(size);
+	if (entry->has_pen_usage)
+		gfx->pen_usage = malloc(gfx->total_elements * sizeof(UINT32));
+
+	if (!gfx->gfxdata || (entry->has_pen_usage && !gfx->pen_usage)
+			|| fseek(file, entry->offset, SEEK_SET) != 0
+			|| fread(gfx->gfxdata, 1, size, file) != size
+			|| (gfx->pen_usage && fread(gfx->pen_usage, sizeof(UINT32), gfx->total_elements, file) != gfx->total_elements))
+	{
+		freegfx(gfx);
+		return NULL;
+	}
+	return gfx;
+}
+
+static void gfx_cache_save(struct gfx_cache_header *header)
+{
+	static const UINT8 padding[GFX_CACHE_ALIGN];
+	char filename[256];
+	UINT32 offset = (sizeof(*header) + GFX_CACHE_ALIGN - 1) & ~(GFX_CACHE_ALIGN - 1);
+	FILE *file;
+	int i;
+
+	snprintf(filename, sizeof(filename), "%s.gfx", Machine->gamedrv->name);
+	if ((file = osd_fopen(FILETYPE_GFXCACHE, 0, filename, "wb")) == NULL)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Could not write the graphics cache %s\n", filename);
+		return;
+	}
+
+	/* lay the sets out first so the header can go in front of them */
+	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
+	{
+		struct gfx_cache_entry *entry = &header->entry[i];
+		if (!entry->present)
+			continue;
+		entry->offset = offset;
+		offset += entry->total_elements * entry->char_modulo;
+		if (entry->has_pen_usage)
+			offset += entry->total_elements * sizeof(UINT32);
+		offset = (offset + GFX_CACHE_ALIGN - 1) & ~(GFX_CACHE_ALIGN - 1);
+	}
+
+	header->magic = GFX_CACHE_MAGIC;
+	header->version = GFX_CACHE_VERSION;
+	fwrite(header, sizeof(*header), 1, file);
+
+	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
+	{
+		const struct gfx_cache_entry *entry = &header->entry[i];
+		const struct GfxElement *gfx = Machine->gfx[i];
+		if (!entry->present)
+			continue;
+		fwrite(padding, 1, entry->offset - ftell(file), file);
+		fwrite(gfx->gfxdata, 1, entry->total_elements * entry->char_modulo, file);
+		if (entry->has_pen_usage)
+			fwrite(gfx->pen_usage, sizeof(UINT32), entry->total_elements, file);
+	}
+
+	if (ferror(file))
+		log_cb(RETRO_LOG_WARN, LOGPRE "Could not write the graphics cache %s\n", filename);
+	fclose(file);
+}
+
+
+
 /*-------------------------------------------------
 	decode_graphics - decode the graphics
 -------------------------------------------------*/
 
 static int decode_graphics(const struct GfxDecodeInfo *gfxdecodeinfo)
 {
+	struct gfx_cache_header *cache = NULL;
+	UINT32 region_crc[MAX_GFX_ELEMENTS];
+	UINT8 region_crc_valid[MAX_GFX_ELEMENTS] = { 0 };
+	FILE *cachefile = NULL;
+	int cached = 0, decoded = 0;
 	int i;
 
+	/* read the cache header; a stale or broken one is rebuilt from scratch */
+	if (options.gfx_cache && (cache = calloc(1, sizeof(*cache))) != NULL)
+	{
+		char filename[256];
+		snprintf(filename, sizeof(filename), "%s.gfx", Machine->gamedrv->name);
+		cachefile = osd_fopen(FILETYPE_GFXCACHE, 0, filename, "rb");
+		if (cachefile && (fread(cache, sizeof(*cache), 1, cachefile) != 1
+				|| cache->magic != GFX_CACHE_MAGIC || cache->version != GFX_CACHE_VERSION))
+			memset(cache, 0, sizeof(*cache));
+	}
+
 	/* loop over all elements */
 	for (i = 0; i < MAX_GFX_ELEMENTS && gfxdecodeinfo[i].memory_region != -1; i++)
 	{
@@ -896,19 +1072,78 @@ static int decode_graphics(const struct GfxDecodeInfo *gfxdecodeinfo)
 			}
 		}
 
+		/* take decoded sets from the cache when their source is unchanged */
+		Machine->gfx[i] = NULL;
+		if (cache && glcopy.planeoffset[0] == GFX_RAW)
+			cache->entry[i].present = 0;
+		else if (cache)
+		{
+			struct gfx_cache_entry *entry = &cache->entry[i];
+			UINT32 layout_crc = gfx_cache_layout_crc(&glcopy, gfxdecodeinfo[i].start);
+
+			/* several sets often share a region; sum it only once */
+			for (j = 0; j < i; j++)
+				if (region_crc_valid[j] && gfxdecodeinfo[j].memory_region == gfxdecodeinfo[i].memory_region)
+					break;
+			region_crc[i] = (j < i) ? region_crc[j] : crc32(0, region_base, region_length / 8);
+			region_crc_valid[i] = 1;
+
+			if (cachefile && entry->present && entry->region_crc == region_crc[i] && entry->layout_crc == layout_crc)
+				Machine->gfx[i] = gfx_cache_load(cachefile, entry, &glcopy);
+
+			if (Machine->gfx[i])
+				cached++;
+			else
+			{
+				entry->present = 0;
+				entry->region_crc = region_crc[i];
+				entry->layout_crc = layout_crc;
+				decoded++;
+			}
+		}
+
 		/* now decode the actual graphics */
-		if ((Machine->gfx[i] = decodegfx(region_base + gfxdecodeinfo[i].start, &glcopy)) == 0)
+		if (!Machine->gfx[i] && (Machine->gfx[i] = decodegfx(region_base + gfxdecodeinfo[i].start, &glcopy)) == 0)
 		{
 			bailing = 1;
 			log_cb(RETRO_LOG_ERROR, LOGPRE "Out of memory decoding gfx\n");
+			if (cachefile)
+				fclose(cachefile);
+			free(cache);
 			return 1;
 		}
 
+		if (cache && glcopy.planeoffset[0] != GFX_RAW && !cache->entry[i].present)
+		{
+			struct gfx_cache_entry *entry = &cache->entry[i];
+			entry->present = 1;
+			entry->width = Machine->gfx[i]->width;
+			entry->height = Machine->gfx[i]->height;
+			entry->total_elements = Machine->gfx[i]->total_elements;
+			entry->line_modulo = Machine->gfx[i]->line_modulo;
+			entry->char_modulo = Machine->gfx[i]->char_modulo;
+			entry->flags = Machine->gfx[i]->flags;
+			entry->has_pen_usage = (Machine->gfx[i]->pen_usage != NULL);
+		}
+
 		/* if we have a remapped colortable, point our local colortable to it */
 		if (Machine->remapped_colortable)
 			Machine->gfx[i]->colortable = &Machine->remapped_colortable[gfxdecodeinfo[i].color_codes_start];
 		Machine->gfx[i]->total_colors = gfxdecodeinfo[i].total_color_codes;
 	}
+
+	if (cache)
+	{
+		/* rewrite the whole file if any set had to be decoded */
+		if (cachefile)
+			fclose(cachefile);
+		for ( ; i < MAX_GFX_ELEMENTS; i++)
+			cache->entry[i].present = 0;
+		if (decoded)
+			gfx_cache_save(cache);
+		log_cb(RETRO_LOG_INFO, LOGPRE "Graphics cache: %d sets loaded, %d decoded\n", cached, decoded);
+		free(cache);
+	}
 	return 0;
 }
 
@@ -1070,6 +1305,13 @@ void force_partial_update(int scanline)
 	if (osd_skip_this_frame())
 		return;
 
+	/* partial updates have to happen on this thread, in step with the CPUs */
+	if (render_thread)
+	{
+		log_cb(RETRO_LOG_INFO, LOGPRE "Threaded video: the driver uses partial updates, rendering synchronously\n");
+		threaded_render_stop();
+	}
+
 	/* skip if less than the lowest so far */
 	if (scanline < last_partial_scanline)
 		return;
@@ -1120,6 +1362,228 @@ void draw_screen(void)
 }
 
 
+/*-------------------------------------------------
+	threaded_render_start - set up rendering on a
+	worker thread for VIDEO_UPDATE_THREADED
+	drivers
+
+	Frame N is drawn into render_bitmap by the
+	worker while the CPUs emulate frame N+1, and
+	shown at the end of frame N+1. The palette
+	the frame was drawn with is captured along
+	with it.
+-------------------------------------------------*/
+
+static void threaded_render_start(void)
+{
+	if (!options.threaded_video)
+		return;
+
+	if (!(Machine->drv->video_attributes & VIDEO_UPDATE_THREADED) || (Machine->drv->video_attributes & VIDEO_TYPE_VECTOR))
+	{
+		log_cb(RETRO_LOG_INFO, LOGPRE "Threaded video: not supported by this driver\n");
+		return;
+	}
+
+	render_bitmap = auto_bitmap_alloc_depth(Machine->scrbitmap->width, Machine->scrbitmap->height, Machine->color_depth);
+	if (render_bitmap)
+		render_thread = osd_thread_create();
+	if (!render_thread)
+	{
+		log_cb(RETRO_LOG_INFO, LOGPRE "Threaded video: no worker thread available\n");
+		return;
+	}
+
+	render_pending = 0;
+	render_frame_ready = 0;
+	log_cb(RETRO_LOG_INFO, LOGPRE "Threaded video: enabled\n");
+}
+
+
+/*-------------------------------------------------
+	threaded_render_stop - go back to rendering
+	on the emulation thread
+-------------------------------------------------*/
+
+static void threaded_render_stop(void)
+{
+	int i;
+
+	if (!render_thread)
+		return;
+
+	wait_for_threaded_render();
+	osd_thread_destroy(render_thread);
+	render_thread = NULL;
+
+	/* the OSD has only seen the captured colors; have it pick up palette.c's again */
+	if (live_palette_dirty)
+		for (i = 0; i < render_palette_entries; i += 32)
+			live_palette_dirty[i / 32] |= render_palette_dirty[i / 32];
+
+	free(render_palette);
+	free(render_palette_dirty);
+	render_palette = NULL;
+	render_palette_dirty = NULL;
+	render_palette_entries = 0;
+	render_palette_changed = 0;
+	live_palette = NULL;
+	live_palette_dirty = NULL;
+}
+
+
+/*-------------------------------------------------
+	threaded_render_palette - show the palette the
+	frame was rendered with instead of the live
+	one
+-------------------------------------------------*/
+
+static void threaded_render_palette(struct mame_display *display)
+{
+	int entries = display->game_palette_entries;
+	int i;
+
+	if (!display->game_palette)
+		return;
+
+	live_palette = display->game_palette;
+	live_palette_dirty = display->game_palette_dirty;
+
+	if (entries != render_palette_entries)
+	{
+		free(render_palette);
+		free(render_palette_dirty);
+		render_palette = malloc(entries * sizeof(render_palette[0]));
+		render_palette_dirty = calloc((entries + 31) / 32, sizeof(render_palette_dirty[0]));
+		if (!render_palette || !render_palette_dirty)
+		{
+			log_cb(RETRO_LOG_ERROR, LOGPRE "Threaded video: out of memory\n");
+			threaded_render_stop();
+			return;
+		}
+
+		/* start from a full copy */
+		memcpy(render_palette, live_palette, entries * sizeof(render_palette[0]));
+		for (i = 0; i < entries; i += 32)
+		{
+			live_palette_dirty[i / 32] = 0;
+			render_palette_dirty[i / 32] = ~0;
+		}
+		render_palette_entries = entries;
+		render_palette_changed = 1;
+	}
+
+	display->game_palette = render_palette;
+	display->game_palette_dirty = render_palette_dirty;
+	display->changed_flags &= ~GAME_PALETTE_CHANGED;
+	if (render_palette_changed)
+		display->changed_flags |= GAME_PALETTE_CHANGED;
+	render_palette_changed = 0;
+}
+
+
+/*-------------------------------------------------
+	threaded_render_capture_palette - copy the
+	colors changed since the last frame
+-------------------------------------------------*/
+
+static void threaded_render_capture_palette(void)
+{
+	int i, j;
+
+	if (!live_palette)
+		return;
+
+	for (i = 0; i < render_palette_entries; i += 32)
+	{
+		UINT32 dirtyflags = live_palette_dirty[i / 32];
+		if (!dirtyflags)
+			continue;
+
+		live_palette_dirty[i / 32] = 0;
+		render_palette_dirty[i / 32] |= dirtyflags;
+		render_palette_changed = 1;
+		for (j = i; dirtyflags && j < render_palette_entries; j++, dirtyflags >>= 1)
+			if (dirtyflags & 1)
+				render_palette[j] = live_palette[j];
+	}
+}
+
+
+/*-------------------------------------------------
+	threaded_render_frame - the worker's job
+-------------------------------------------------*/
+
+static void threaded_render_frame(void *param)
+{
+	if (render_erase_pen >= 0)
+		fillbitmap(render_bitmap, render_erase_pen, NULL);
+
+	(*Machine->drv->video_update)(render_bitmap, &render_clip);
+
+	if (gbPriorityBitmapIsDirty)
+	{
+		fillbitmap(priority_bitmap, 0x00, NULL);
+		gbPriorityBitmapIsDirty = 0;
+	}
+}
+
+
+/*-------------------------------------------------
+	threaded_render_kick - start rendering the
+	frame that just ended
+-------------------------------------------------*/
+
+static void threaded_render_kick(void)
+{
+	render_clip = Machine->visible_area;
+	render_erase_pen = -1;
+	if (full_refresh_pending)
+	{
+		render_erase_pen = get_black_pen();
+		full_refresh_pending = 0;
+	}
+
+	threaded_render_capture_palette();
+
+	render_pending = 1;
+	osd_thread_start(render_thread, threaded_render_frame, NULL);
+}
+
+
+/*-------------------------------------------------
+	wait_for_threaded_render - wait for the frame
+	in progress; it becomes Machine->scrbitmap
+-------------------------------------------------*/
+
+void wait_for_threaded_render(void)
+{
+	struct mame_bitmap *temp;
+
+	if (!render_pending)
+		return;
+
+	osd_thread_wait(render_thread);
+	render_pending = 0;
+
+	temp = Machine->scrbitmap;
+	Machine->scrbitmap = render_bitmap;
+	render_bitmap = temp;
+	render_frame_ready = 1;
+}
+
+
+/*-------------------------------------------------
+	video_update_threaded - tell drivers whether
+	video_update runs on the worker thread
+-------------------------------------------------*/
+
+int video_update_threaded(void)
+{
+	return render_thread != NULL;
+}
+
+
 /*-------------------------------------------------
 	update_video_and_audio - actually call the
 	OSD layer to perform an update
@@ -1127,7 +1591,8 @@ void draw_screen(void)
 
 void update_video_and_audio(void)
 {
-	int skipped_it = osd_skip_this_frame();
+	/* with a worker thread, show whatever it finished during this frame */
+	int skipped_it = render_thread ? !render_frame_ready : osd_skip_this_frame();
 
 #ifdef MAME_DEBUG
 	debug_trace_delay = 0;
@@ -1179,6 +1644,9 @@ void update_video_and_audio(void)
 
 	/* update with data from other parts of the system */
 	palette_update_display(&current_display);
+	if (render_thread)
+		threaded_render_palette(&current_display);
+	render_frame_ready = 0;
 
 	/* render */
 	artwork_update_video_and_audio(&current_display);
@@ -1201,8 +1669,15 @@ int updatescreen(void)
 	/* update sound */
 	sound_update();
 
-	/* if we're not skipping this frame, draw the screen */
-	if (osd_skip_this_frame() == 0)
+	/* if we're not skipping this frame, draw the screen; the worker */
+	/* thread has been drawing the previous frame in the meantime */
+	if (render_thread)
+	{
+		profiler_mark(PROFILER_VIDEO);
+		wait_for_threaded_render();
+		profiler_mark(PROFILER_END);
+	}
+	else if (osd_skip_this_frame() == 0)
 	{
 		profiler_mark(PROFILER_VIDEO);
 		draw_screen();
@@ -1227,6 +1702,10 @@ int updatescreen(void)
 		profiler_mark(PROFILER_END);
 	}
 
+	/* hand this frame to the worker while the CPUs move on */
+	if (render_thread && osd_skip_this_frame() == 0)
+		threaded_render_kick();
+
 	return 0;
 }
 
@@ -183,6 +183,23 @@ enum /* used to index content-specific flags */
   CONTENT_end,
 };
 
+enum /* values of the profiler core option */
+{
+  PROFILER_OUTPUT_NONE = 0,
+  PROFILER_OUTPUT_LOG,
+  PROFILER_OUTPUT_JSON
+};
+
+enum /* values of the memory handler statistics core option */
+{
+  HANDLER_STATS_NONE = 0,
+  HANDLER_STATS_COUNTS,
+  HANDLER_STATS_TIMING
+};
+
+#define FRAMESKIP_LEVELS  12  /* frameskip levels 0 (never skip) to 11 (skip 11 frames in 12) */
+#define FRAMESKIP_AUTO    -1  /* options.frameskip value selecting automatic frameskip */
+
 /* The host platform should fill these fields with the preferences specified in the GUI */
 /* or on the commandline. */
 struct GameOptions
@@ -219,6 +236,15 @@ struct GameOptions
   int      crosshair_enable;
   unsigned activate_dcs_speedhack;
   bool     mame_remapping;       /* display MAME input remapping menu */
+  int      profiler;             /* PROFILER_OUTPUT_NONE, PROFILER_OUTPUT_LOG or PROFILER_OUTPUT_JSON */
+  int      rewind;               /* seconds of in-core rewind history, 0 disables it */
+  bool     frontend_framebuffer; /* convert video straight into the frontend's framebuffer */
+  bool     threaded_video;       /* render VIDEO_UPDATE_THREADED drivers on a worker thread */
+  int      handler_stats;        /* HANDLER_STATS_NONE, HANDLER_STATS_COUNTS or HANDLER_STATS_TIMING */
+  bool     idle_detect;          /* skip the rest of the slice when a CPU is found spinning */
+  bool     sched_stats;          /* record per-frame scheduler statistics */
+  bool     gfx_cache;            /* keep decoded graphics on disk for the next launch */
+  bool     threaded_tilemaps;    /* refresh heavily dirtied tilemaps on worker threads */
 
   int		   samplerate;		       /* sound sample playback rate, in KHz */
   bool	   use_samples;	         /* 1 to enable external .wav samples */
@@ -226,7 +252,7 @@ struct GameOptions
   float	   brightness;		       /* brightness of the display */
   float	   pause_bright;		     /* additional brightness when in pause */
   float	   gamma;			           /* gamma correction of the display */
-  int      frameskip;
+  int      frameskip;            /* 0 to FRAMESKIP_LEVELS - 1, or FRAMESKIP_AUTO */
   int		   color_depth;	         /* valid: 15, 16, or 32. any other value means auto */
   int		   ui_orientation;	     /* orientation of the UI relative to the video */
       
@@ -362,6 +388,13 @@ void force_partial_update(int scanline);
 /* finish updating the screen for this frame */
 void draw_screen(void);
 
+/* wait for the frame being rendered on the video thread, if any */
+void wait_for_threaded_render(void);
+
+/* nonzero while video_update runs on the video thread; VIDEO_UPDATE_THREADED */
+/* drivers then take the state they draw from in video_eof */
+int video_update_threaded(void);
+
 /* update the video by calling down to the OSD layer */
 void update_video_and_audio(void);
 
@@ -7,6 +7,7 @@
 *********************************************************************/    
 
 #include <stdint.h>
+#include <time.h>
 #include <string/stdstring.h>
 #include <libretro.h>
 #include <file/file_path.h>
@@ -23,12 +24,9 @@
 
 
 static const struct GameDriver  *game_driver;
-static float              delta_samples;
 int                       samples_per_frame = 0;
-int 			  orig_samples_per_frame =0;
-short*                    samples_buffer;
-short*                    conversion_buffer;
-int                       usestereo = 1;
+static UINT64             samples_per_frame_fixed;  /* exact samples per frame, 32.32 fixed point */
+static UINT64             samples_fraction;
 int16_t                   prev_pointer_x;
 int16_t                   prev_pointer_y;
 unsigned                  retroColorMode;
@@ -46,6 +44,7 @@ struct ipd          *default_inputs; /* pointer the array of structs with defaul
 
 static struct retro_variable_default  default_options[OPT_end + 1];    /* need the plus one for the NULL entries at the end */
 static struct retro_variable          current_options[OPT_end + 1];
+static struct retro_memory_descriptor *memory_descriptors;  /* published by set_memory_maps() */
 
 static struct retro_input_descriptor empty[] = { { 0 } };
 
@@ -73,6 +72,7 @@ static void   update_variables(bool first_time);
 static void   set_variables(bool first_time);
 static struct retro_variable_default *spawn_effective_default(int option_index);
 static void   check_system_specs(void);
+static void   set_memory_maps(void);
        void   retro_describe_controls(void);
        int    get_mame_ctrl_id(int display_idx, int retro_ID);
 
@@ -91,9 +91,9 @@ void retro_init (void)
   else
     log_cb = NULL;
 
-#ifdef LOG_PERFORMANCE
+  /* the perf interface also provides the timers behind osd_cycles() */
+  memset(&perf_cb, 0, sizeof(perf_cb));
   environ_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf_cb);
-#endif
 
   check_system_specs();
 }
@@ -113,7 +113,7 @@ void retro_set_environment(retro_environment_t cb)
 
 static void init_core_options(void)
 {
-  init_default(&default_options[OPT_FRAMESKIP],           APPNAME"_frameskip",           "Frameskip; 0|1|2|3|4|5");
+  init_default(&default_options[OPT_FRAMESKIP],           APPNAME"_frameskip",           "Frameskip; 0|1|2|3|4|5|auto");
 #if defined(__IOS__)
   init_default(&default_options[OPT_MOUSE_DEVICE],        APPNAME"_mouse_device",        "Mouse Device; pointer|mouse|disabled");
 #else
@@ -148,6 +148,15 @@ static void init_core_options(void)
   init_default(&default_options[OPT_DCS_SPEEDHACK],       APPNAME"_dcs_speedhack",       "DCS Speedhack; enabled|disabled");
   init_default(&default_options[OPT_INPUT_INTERFACE],     APPNAME"_input_interface",     "Input interface; retropad|mame_keyboard|simultaneous");  
   init_default(&default_options[OPT_MAME_REMAPPING],      APPNAME"_mame_remapping",      "Activate MAME Remapping (!NETPLAY); disabled|enabled");
+  init_default(&default_options[OPT_PROFILER],            APPNAME"_profiler",            "Profiler; disabled|log|json");
+  init_default(&default_options[OPT_REWIND],              APPNAME"_rewind",              "In-core rewind (seconds); disabled|10|30|60");
+  init_default(&default_options[OPT_FRONTEND_FRAMEBUFFER], APPNAME"_frontend_framebuffer", "Render into frontend framebuffer; disabled|enabled");
+  init_default(&default_options[OPT_THREADED_VIDEO],      APPNAME"_threaded_video",      "Threaded video (Restart); disabled|enabled");
+  init_default(&default_options[OPT_HANDLER_STATS],       APPNAME"_handler_stats",       "Memory handler statistics (Restart); disabled|counts|timing");
+  init_default(&default_options[OPT_IDLE_DETECT],         APPNAME"_idle_detect",         "Idle loop detection (Restart); disabled|enabled");
+  init_default(&default_options[OPT_SCHED_STATS],         APPNAME"_sched_stats",         "Scheduler statistics (Restart); disabled|enabled");
+  init_default(&default_options[OPT_GFX_CACHE],           APPNAME"_gfx_cache",           "Graphics decode cache (Restart); disabled|enabled");
+  init_default(&default_options[OPT_THREADED_TILEMAPS],   APPNAME"_threaded_tilemaps",   "Threaded tilemap refresh (Restart); disabled|enabled");
   
   init_default(&default_options[OPT_end], NULL, NULL);
   set_variables(true);
@@ -246,7 +255,10 @@ static void update_variables(bool first_time)
       switch(index)
       {
         case OPT_FRAMESKIP:
-          options.frameskip = atoi(var.value);
+          if(strcmp(var.value, "auto") == 0)
+            options.frameskip = FRAMESKIP_AUTO;
+          else
+            options.frameskip = atoi(var.value);
           break;
 
         case OPT_INPUT_INTERFACE:
@@ -494,6 +506,70 @@ static void update_variables(bool first_time)
           if(!first_time)
             setup_menu_init();
           break;
+
+        case OPT_PROFILER:
+          if(strcmp(var.value, "log") == 0)
+            options.profiler = PROFILER_OUTPUT_LOG;
+          else if(strcmp(var.value, "json") == 0)
+            options.profiler = PROFILER_OUTPUT_JSON;
+          else
+            options.profiler = PROFILER_OUTPUT_NONE;
+          break;
+
+        case OPT_REWIND:
+          options.rewind = atoi(var.value); /* 0 for "disabled" */
+          break;
+
+        case OPT_FRONTEND_FRAMEBUFFER:
+          if(strcmp(var.value, "enabled") == 0)
+            options.frontend_framebuffer = true;
+          else
+            options.frontend_framebuffer = false;
+          break;
+
+        case OPT_THREADED_VIDEO:
+          if(strcmp(var.value, "enabled") == 0)
+            options.threaded_video = true;
+          else
+            options.threaded_video = false;
+          break;
+
+        case OPT_HANDLER_STATS:
+          if(strcmp(var.value, "counts") == 0)
+            options.handler_stats = HANDLER_STATS_COUNTS;
+          else if(strcmp(var.value, "timing") == 0)
+            options.handler_stats = HANDLER_STATS_TIMING;
+          else
+            options.handler_stats = HANDLER_STATS_NONE;
+          break;
+
+        case OPT_IDLE_DETECT:
+          if(strcmp(var.value, "enabled") == 0)
+            options.idle_detect = true;
+          else
+            options.idle_detect = false;
+          break;
+
+        case OPT_SCHED_STATS:
+          if(strcmp(var.value, "enabled") == 0)
+            options.sched_stats = true;
+          else
+            options.sched_stats = false;
+          break;
+
+        case OPT_GFX_CACHE:
+          if(strcmp(var.value, "enabled") == 0)
+            options.gfx_cache = true;
+          else
+            options.gfx_cache = false;
+          break;
+
+        case OPT_THREADED_TILEMAPS:
+          if(strcmp(var.value, "enabled") == 0)
+            options.threaded_tilemaps = true;
+          else
+            options.threaded_tilemaps = false;
+          break;
       }
     }
   }
@@ -678,7 +754,9 @@ bool retro_load_game(const struct retro_game_info *game)
   
   if(!run_game(driverIndex))
     return false;
-  
+
+  set_memory_maps();
+
   return true;
 }
 
@@ -900,6 +978,7 @@ extern	const char* ost_drivers[];
 
 void retro_reset (void)
 {
+    wait_for_threaded_render();
     machine_reset(); /* use MAME function */
 }
 
@@ -929,6 +1008,8 @@ void retro_run (void)
    bool pointer_pressed;
    const struct KeyboardInfo *thisInput;
    bool updated = false;
+   cycles_t frame_start;
+   bool rewinding;
 
    poll_cb();
 
@@ -1013,13 +1094,26 @@ void retro_run (void)
       }
    }
 
+   /* while the rewind input is held, step back one frame and emulate it again for display */
+   rewinding = options.rewind && seq_pressed(input_port_type_seq(IPT_UI_REWIND)) && rewind_restore(1);
+
+   frame_start = osd_cycles();
+   profiler_frame_begin();
    mame_frame();
+   profiler_frame_end();
+   osd_frameskip_end_frame(osd_cycles() - frame_start);
 
+   if (!rewinding)
+      rewind_capture();
 }
 
 void retro_unload_game(void)
 {
+    profiler_dump();
+    rewind_reset();
     mame_done();
+    free(memory_descriptors);
+    memory_descriptors = NULL;
     /* do we need to be freeing things here? */
     
     free(options.romset_filename_noext); 
@@ -1043,7 +1137,9 @@ size_t retro_serialize_size(void)
 bool retro_serialize(void *data, size_t size)
 {
    int cpunum;
-	if( ( retro_serialize_size() ) && (data)  && (size) )
+   size_t state_size = retro_serialize_size();
+
+	if( ( state_size ) && (data)  && (size >= state_size) )
 	{
 		/* write the save state */
 		state_save_save_begin(data);
@@ -1083,8 +1179,11 @@ bool retro_serialize(void *data, size_t size)
 bool retro_unserialize(const void * data, size_t size)
 {
     int cpunum;
+
+    /* the video thread may be reading the state we are about to replace */
+    wait_for_threaded_render();
 	/* if successful, load it */
-	if ( (retro_serialize_size() ) && ( data ) && ( size ) && ( !state_save_load_begin((void*)data, size) ) )
+	if ( (retro_serialize_size() ) && ( data ) && ( !state_save_load_begin((void*)data, size) ) )
 	{
         /* read tag 0 */
         state_save_set_current_tag(0);
@@ -1142,75 +1241,84 @@ bool retro_unserialize(const void * data, size_t size)
 
 ******************************************************************************/
 
+/* the whole number of samples for the next frame; the fraction left over
+   is carried into the following one, so the long-term rate is exact */
+static int next_samples_per_frame(void)
+{
+	samples_fraction = (samples_fraction & 0xffffffff) + samples_per_frame_fixed;
+	samples_per_frame = (int)(samples_fraction >> 32);
+	return samples_per_frame;
+}
+
 int osd_start_audio_stream(int stereo)
 {
     if  ( ( Machine->drv->frames_per_second * 1000 < options.samplerate) || (Machine->drv->frames_per_second < 60) )   Machine->sample_rate = Machine->drv->frames_per_second * 1000;
     else Machine->sample_rate = options.samplerate;
 
-	delta_samples = 0.0f;
-	usestereo = stereo ? 1 : 0;
-
-	/* determine the number of samples per frame */
-	samples_per_frame = Machine->sample_rate / Machine->drv->frames_per_second;
-	orig_samples_per_frame = samples_per_frame;
+	/* the mixer always hands over interleaved stereo, ready for audio_batch_cb */
+	samples_per_frame_fixed = (UINT64)((double)Machine->sample_rate * 4294967296.0 / Machine->drv->frames_per_second);
+	samples_fraction = 0;
 
 	if (Machine->sample_rate == 0) return 0;
 
-	samples_buffer = (short *) calloc(samples_per_frame+16, 2 + usestereo * 2);
-	if (!usestereo) conversion_buffer = (short *) calloc(samples_per_frame+16, 4);
-	
-	return samples_per_frame;
+	return next_samples_per_frame();
 }
 
 
 int osd_update_audio_stream(INT16 *buffer)
 {
-	int i,j;
-	
-	if ( Machine->sample_rate !=0 && buffer )
-	{
-   		memcpy(samples_buffer, buffer, samples_per_frame * (usestereo ? 4 : 2));
-		if (usestereo)
-			audio_batch_cb(samples_buffer, samples_per_frame);
-		else
-		{
-			for (i = 0, j = 0; i < samples_per_frame; i++)
-        		{
-				conversion_buffer[j++] = samples_buffer[i];
-				conversion_buffer[j++] = samples_buffer[i];
-		        }
-         		audio_batch_cb(conversion_buffer,samples_per_frame);
-		}	
-		
-			
-		//process next frame
-			
-		if ( samples_per_frame  != orig_samples_per_frame ) samples_per_frame = orig_samples_per_frame;
-		
-		// dont drop any sample frames some games like mk will drift with time
-   		delta_samples += (Machine->sample_rate / Machine->drv->frames_per_second) - orig_samples_per_frame;
-		if ( delta_samples >= 1.0f )
-		{
-		
-			int integer_delta = (int)delta_samples;
-			if (integer_delta <= 16 )
-                        { 
-				log_cb(RETRO_LOG_DEBUG,"sound: Delta added value %d added to frame\n",integer_delta);
-				samples_per_frame += integer_delta;
-			}
-			else if(integer_delta >= 16) log_cb(RETRO_LOG_INFO, "sound: Delta not added to samples_per_frame too large integer_delta:%d\n", integer_delta);
-			else log_cb(RETRO_LOG_DEBUG,"sound(delta) no contitions met\n");	
-			delta_samples -= integer_delta; 
+	if (Machine->sample_rate == 0 || !buffer)
+		return samples_per_frame;
 
-		}
-	}
-        return samples_per_frame;
+	audio_batch_cb(buffer, samples_per_frame);
+
+	return next_samples_per_frame();
 }
 
 void osd_stop_audio_stream(void)
 {
 }
 
+
+/******************************************************************************
+
+	Timing
+
+	osd_cycles() is a microsecond clock provided by the frontend's perf
+	interface when available. osd_profiling_ticks() reads the cheapest counter
+	the CPU offers; the profiler calibrates it against osd_cycles().
+
+******************************************************************************/
+
+cycles_t osd_cycles(void)
+{
+	if (perf_cb.get_time_usec)
+		return perf_cb.get_time_usec();
+	return (cycles_t)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+
+cycles_t osd_cycles_per_second(void)
+{
+	return 1000000;
+}
+
+cycles_t osd_profiling_ticks(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	UINT32 lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((cycles_t)hi << 32) | lo;
+#elif defined(__GNUC__) && defined(__aarch64__)
+	UINT64 ticks;
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (ticks));
+	return (cycles_t)ticks;
+#else
+	if (perf_cb.get_perf_counter)
+		return perf_cb.get_perf_counter();
+	return osd_cycles();
+#endif
+}
+
 /******************************************************************************
 
 Miscellaneous
@@ -1218,8 +1326,111 @@ Miscellaneous
 ******************************************************************************/
 
 unsigned retro_get_region (void) {return RETRO_REGION_NTSC;}
-void *retro_get_memory_data(unsigned type) {return 0;}
-size_t retro_get_memory_size(unsigned type) {return 0;}
+
+/* the main CPU's largest RAM zone stands in for "system RAM" */
+static const struct memory_zone *get_system_ram_zone(void)
+{
+  const struct memory_zone *best = NULL;
+  int index;
+
+  for(index = 0; index < memory_get_zone_count(); index++)
+  {
+    const struct memory_zone *zone = memory_get_zone(index);
+    if(zone->cpunum == 0 && (!best || zone->end - zone->start > best->end - best->start))
+      best = zone;
+  }
+  return best;
+}
+
+void *retro_get_memory_data(unsigned type)
+{
+  const struct memory_zone *zone = (type == RETRO_MEMORY_SYSTEM_RAM) ? get_system_ram_zone() : NULL;
+  return zone ? zone->base : NULL;
+}
+
+size_t retro_get_memory_size(unsigned type)
+{
+  const struct memory_zone *zone = (type == RETRO_MEMORY_SYSTEM_RAM) ? get_system_ram_zone() : NULL;
+  return zone ? zone->end - zone->start + 1 : 0;
+}
+
+/* Publish the RAM zones the memory system registered for save states, so that
+   cheats, achievements and RAM watchers read the emulated RAM in place. CPU 0
+   uses the unnamed address space, the others CPU1..CPU7. Zones of 16 and 32-bit
+   CPUs hold host-endian data bus words. */
+static void set_memory_maps(void)
+{
+  static const char *const cpu_spaces[MAX_CPU] = { "", "CPU1", "CPU2", "CPU3", "CPU4", "CPU5", "CPU6", "CPU7" };
+  struct retro_memory_map map;
+  bool achievements = true;
+  int pass, index, count = 0;
+
+  free(memory_descriptors);
+  memory_descriptors = NULL;
+
+  /* pass 0 counts the descriptors, pass 1 fills them in */
+  for(pass = 0; pass < 2; pass++)
+  {
+    count = 0;
+    for(index = 0; index < memory_get_zone_count(); index++)
+    {
+      const struct memory_zone *zone = memory_get_zone(index);
+      unsigned width = cpunum_databus_width(zone->cpunum);
+      UINT64 start = zone->start;
+      UINT64 flags = 0;
+
+      if(width == 16)
+        flags |= RETRO_MEMDESC_MINSIZE_2;
+      else if(width == 32)
+        flags |= RETRO_MEMDESC_MINSIZE_4;
+#ifdef MSB_FIRST
+      if(width > 8)
+        flags |= RETRO_MEMDESC_BIGENDIAN;
+#endif
+
+      /* split the zone into naturally aligned power of two blocks, which 'select' describes exactly */
+      while(start <= zone->end)
+      {
+        UINT64 remaining = (UINT64)zone->end - start + 1;
+        UINT64 len = 1;
+
+        while(!(start & (len * 2 - 1)) && len * 2 <= remaining)
+          len *= 2;
+
+        if(pass)
+        {
+          struct retro_memory_descriptor *desc = &memory_descriptors[count];
+          memset(desc, 0, sizeof(*desc));
+          desc->flags     = flags;
+          desc->ptr       = zone->base;
+          desc->offset    = start - zone->start;
+          desc->start     = start;
+          desc->select    = ~(size_t)(len - 1) & cpunum_address_mask(zone->cpunum);
+          desc->len       = len;
+          desc->addrspace = cpu_spaces[zone->cpunum];
+        }
+        count++;
+        start += len;
+      }
+    }
+
+    if(!count)
+      return;
+    if(!pass)
+    {
+      memory_descriptors = calloc(count, sizeof(*memory_descriptors));
+      if(!memory_descriptors)
+        return;
+    }
+  }
+
+  map.descriptors     = memory_descriptors;
+  map.num_descriptors = count;
+  environ_cb(RETRO_ENVIRONMENT_SET_MEMORY_MAPS, &map);
+  environ_cb(RETRO_ENVIRONMENT_SET_SUPPORT_ACHIEVEMENTS, &achievements);
+
+  log_cb(RETRO_LOG_INFO, LOGPRE "Published %d memory descriptors for %d RAM zones.\n", count, memory_get_zone_count());
+}
 bool retro_load_game_special(unsigned game_type, const struct retro_game_info *info, size_t num_info){return false;}
 void retro_cheat_reset(void){}
 void retro_cheat_set(unsigned unused, bool unused1, const char* unused2){}
@@ -79,6 +79,15 @@ enum
   OPT_DCS_SPEEDHACK,
   OPT_INPUT_INTERFACE,  
   OPT_MAME_REMAPPING,
+  OPT_PROFILER,
+  OPT_REWIND,
+  OPT_FRONTEND_FRAMEBUFFER,
+  OPT_THREADED_VIDEO,
+  OPT_HANDLER_STATS,
+  OPT_IDLE_DETECT,
+  OPT_SCHED_STATS,
+  OPT_GFX_CACHE,
+  OPT_THREADED_TILEMAPS,
   OPT_end /* dummy last entry */
 };
 
@@ -356,6 +365,52 @@ cycles_t osd_cycles_per_second(void);
    it isn't necessary to know the number of ticks per seconds. */
 cycles_t osd_profiling_ticks(void);
 
+/* called once per retro_run() with the osd_cycles() spent emulating the frame;
+   decides whether the next frame is skipped (see osd_skip_this_frame()) */
+void osd_frameskip_end_frame(cycles_t emulation_time);
+
+
+/******************************************************************************
+
+	Rewind history (rewind.c)
+
+******************************************************************************/
+
+/* snapshot the frame that was just emulated; also (re)starts the history when
+   options.rewind changes */
+void rewind_capture(void);
+
+/* step the machine back by up to the given number of frames, returns the number
+   of frames actually rewound */
+unsigned rewind_restore(unsigned frames);
+
+/* drop the history and report its statistics */
+void rewind_reset(void);
+
+
+/******************************************************************************
+
+	Worker threads (thread.c)
+
+******************************************************************************/
+
+struct osd_thread;
+
+/* start a worker thread; returns NULL when the platform has no threads */
+struct osd_thread *osd_thread_create(void);
+
+/* run func(param) on the worker; the previous job must have been waited for */
+void osd_thread_start(struct osd_thread *thread, void (*func)(void *), void *param);
+
+/* block until the job started last has returned */
+void osd_thread_wait(struct osd_thread *thread);
+
+/* wait for the current job, then stop and free the worker */
+void osd_thread_destroy(struct osd_thread *thread);
+
+/* number of processors available to the core, at least 1 */
+int osd_num_processors(void);
+
 
 #ifdef __cplusplus
 }
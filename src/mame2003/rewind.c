@@ -0,0 +1,432 @@
+/*********************************************************************
+
+	rewind.c
+
+	In-core rewind history.
+
+	After every emulated frame the machine state is serialized and
+	compared with the previous snapshot, entry by entry, using the
+	layout frozen by state.c. Only the XOR of the two is kept, run-length
+	encoded, in a fixed-size byte ring. The newest full snapshot is kept
+	aside, so stepping back one frame is a matter of XORing the newest
+	delta into it and loading the result; the oldest deltas are simply
+	dropped when the ring fills up.
+
+	Each delta starts with a map holding two bits per state entry:
+
+		0	entry unchanged
+		1	run-length encoded XOR: pairs of (zero run, literal count)
+			varints, each followed by that many literal XOR bytes,
+			until the entry is covered
+		2	raw XOR of the whole entry, when RLE would not be smaller
+
+*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <libretro.h>
+
+#include "mame2003.h"
+#include "driver.h"
+#include "state.h"
+#include "log.h"
+
+#define REWIND_BUFFER_SIZE	(32 * 1024 * 1024)	/* bytes of delta history */
+#define REWIND_MIN_ZERO_RUN	4					/* shorter runs of equal bytes stay in the literal */
+
+enum
+{
+	REWIND_ENTRY_SAME = 0,
+	REWIND_ENTRY_RLE,
+	REWIND_ENTRY_RAW
+};
+
+struct rewind_range
+{
+	unsigned offset;
+	unsigned size;
+};
+
+struct rewind_frame
+{
+	unsigned pos;
+	unsigned length;
+};
+
+static int rewind_seconds;					/* history length the buffers were built for */
+static int rewind_failed;					/* setting rewind_init failed for, not retried until it changes */
+static size_t rewind_state_size;
+static UINT8 *rewind_state;					/* newest snapshot */
+static UINT8 *rewind_scratch;				/* snapshot being captured */
+static UINT8 *rewind_delta;					/* delta being encoded */
+static size_t rewind_delta_max;
+
+static struct rewind_range *rewind_ranges;
+static int rewind_range_count;
+static unsigned rewind_map_size;
+
+static UINT8 *rewind_ring;
+static struct rewind_frame *rewind_frames;	/* circular, oldest at rewind_first */
+static unsigned rewind_max_frames;
+static unsigned rewind_first;
+static unsigned rewind_count;
+
+/* statistics */
+static unsigned rewind_captures;
+static cycles_t rewind_capture_time;
+static UINT64 rewind_delta_bytes;
+
+
+/*************************************
+ *
+ *	Setup and teardown
+ *
+ *************************************/
+
+static int rewind_compare_ranges(const void *a, const void *b)
+{
+	const struct rewind_range *ra = a;
+	const struct rewind_range *rb = b;
+	return (ra->offset > rb->offset) - (ra->offset < rb->offset);
+}
+
+static void rewind_clear_history(void)
+{
+	rewind_first = 0;
+	rewind_count = 0;
+}
+
+void rewind_reset(void)
+{
+	if (rewind_captures)
+	{
+		UINT64 used = 0;
+		unsigned i;
+
+		for (i = 0; i < rewind_count; i++)
+			used += rewind_frames[(rewind_first + i) % rewind_max_frames].length;
+
+		log_cb(RETRO_LOG_INFO, LOGPRE "Rewind: %u frames (%.1f s) in %u of %u KB of history, %u KB of snapshots; "
+				"%.0f bytes and %.1f us per captured frame\n",
+				rewind_count, rewind_count / Machine->drv->frames_per_second,
+				(unsigned)(used / 1024), REWIND_BUFFER_SIZE / 1024, (unsigned)(2 * rewind_state_size / 1024),
+				(double)rewind_delta_bytes / rewind_captures,
+				(double)rewind_capture_time * 1000000.0 / osd_cycles_per_second() / rewind_captures);
+	}
+
+	free(rewind_state);
+	free(rewind_scratch);
+	free(rewind_delta);
+	free(rewind_ranges);
+	free(rewind_ring);
+	free(rewind_frames);
+	rewind_state = rewind_scratch = rewind_delta = rewind_ring = NULL;
+	rewind_ranges = NULL;
+	rewind_frames = NULL;
+	rewind_seconds = 0;
+	rewind_state_size = 0;
+	rewind_range_count = 0;
+	rewind_captures = 0;
+	rewind_capture_time = 0;
+	rewind_delta_bytes = 0;
+	rewind_failed = 0;
+	rewind_clear_history();
+}
+
+static int rewind_init(void)
+{
+	int i;
+
+	rewind_state_size = retro_serialize_size();
+	rewind_range_count = state_save_get_entry_count();
+	if (!rewind_state_size || !rewind_range_count)
+		return 0;
+
+	/* worst case: the map, a raw copy of every entry */
+	rewind_map_size = (rewind_range_count + 3) / 4;
+	rewind_delta_max = rewind_map_size + rewind_state_size;
+	rewind_max_frames = (unsigned)(options.rewind * Machine->drv->frames_per_second) + 1;
+
+	rewind_state = malloc(rewind_state_size);
+	rewind_scratch = malloc(rewind_state_size);
+	rewind_delta = malloc(rewind_delta_max);
+	rewind_ranges = malloc(rewind_range_count * sizeof(rewind_ranges[0]));
+	rewind_ring = malloc(REWIND_BUFFER_SIZE);
+	rewind_frames = malloc(rewind_max_frames * sizeof(rewind_frames[0]));
+	if (!rewind_state || !rewind_scratch || !rewind_delta || !rewind_ranges || !rewind_ring || !rewind_frames)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Rewind: out of memory, history disabled\n");
+		return 0;
+	}
+
+	/* walk the entries in buffer order */
+	for (i = 0; i < rewind_range_count; i++)
+		state_save_get_entry_range(i, &rewind_ranges[i].offset, &rewind_ranges[i].size);
+	qsort(rewind_ranges, rewind_range_count, sizeof(rewind_ranges[0]), rewind_compare_ranges);
+
+	if (!retro_serialize(rewind_state, rewind_state_size))
+		return 0;
+
+	rewind_seconds = options.rewind;
+	rewind_clear_history();
+	return 1;
+}
+
+
+/*************************************
+ *
+ *	Delta encoding
+ *
+ *************************************/
+
+INLINE UINT8 *rewind_put_varint(UINT8 *out, unsigned value)
+{
+	while (value >= 0x80)
+	{
+		*out++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*out++ = value;
+	return out;
+}
+
+INLINE const UINT8 *rewind_get_varint(const UINT8 *in, unsigned *value)
+{
+	unsigned result = 0;
+	int shift = 0;
+	while (*in & 0x80)
+	{
+		result |= (*in++ & 0x7f) << shift;
+		shift += 7;
+	}
+	*value = result | (*in++ << shift);
+	return in;
+}
+
+/* RLE encode a ^ b; returns NULL if the result would not fit before limit */
+static UINT8 *rewind_encode_rle(UINT8 *out, const UINT8 *limit, const UINT8 *a, const UINT8 *b, unsigned size)
+{
+	unsigned i = 0;
+
+	while (i < size)
+	{
+		unsigned zero_start = i, lit_start, j;
+
+		while (i < size && a[i] == b[i])
+			i++;
+
+		lit_start = i;
+		while (i < size)
+		{
+			if (a[i] != b[i])
+			{
+				i++;
+				continue;
+			}
+			for (j = i; j < size && j - i < REWIND_MIN_ZERO_RUN && a[j] == b[j]; j++) ;
+			if (j - i >= REWIND_MIN_ZERO_RUN || j == size)
+				break;
+			i = j;
+		}
+
+		/* two varints of at most 5 bytes each */
+		if (out + 10 + (i - lit_start) > limit)
+			return NULL;
+		out = rewind_put_varint(out, lit_start - zero_start);
+		out = rewind_put_varint(out, i - lit_start);
+		for (j = lit_start; j < i; j++)
+			*out++ = a[j] ^ b[j];
+	}
+	return out;
+}
+
+/* encode the difference between rewind_scratch and rewind_state into rewind_delta */
+static size_t rewind_encode(void)
+{
+	UINT8 *map = rewind_delta;
+	UINT8 *out = rewind_delta + rewind_map_size;
+	int i;
+
+	memset(map, 0, rewind_map_size);
+	for (i = 0; i < rewind_range_count; i++)
+	{
+		const UINT8 *a = rewind_scratch + rewind_ranges[i].offset;
+		const UINT8 *b = rewind_state + rewind_ranges[i].offset;
+		unsigned size = rewind_ranges[i].size;
+		UINT8 *end;
+		unsigned j;
+
+		if (!memcmp(a, b, size))
+			continue;
+
+		end = rewind_encode_rle(out, out + size, a, b, size);
+		if (end)
+		{
+			map[i / 4] |= REWIND_ENTRY_RLE << ((i & 3) * 2);
+			out = end;
+		}
+		else
+		{
+			map[i / 4] |= REWIND_ENTRY_RAW << ((i & 3) * 2);
+			for (j = 0; j < size; j++)
+				*out++ = a[j] ^ b[j];
+		}
+	}
+	return out - rewind_delta;
+}
+
+/* XOR a delta into rewind_state */
+static void rewind_apply(const UINT8 *delta)
+{
+	const UINT8 *map = delta;
+	const UINT8 *in = delta + rewind_map_size;
+	int i;
+
+	for (i = 0; i < rewind_range_count; i++)
+	{
+		UINT8 *state = rewind_state + rewind_ranges[i].offset;
+		unsigned size = rewind_ranges[i].size;
+		unsigned pos, run, j;
+
+		switch ((map[i / 4] >> ((i & 3) * 2)) & 3)
+		{
+			case REWIND_ENTRY_RLE:
+				for (pos = 0; pos < size; pos += run)
+				{
+					in = rewind_get_varint(in, &run);
+					pos += run;
+					in = rewind_get_varint(in, &run);
+					for (j = 0; j < run; j++)
+						state[pos + j] ^= *in++;
+				}
+				break;
+
+			case REWIND_ENTRY_RAW:
+				for (j = 0; j < size; j++)
+					state[j] ^= *in++;
+				break;
+		}
+	}
+}
+
+
+/*************************************
+ *
+ *	History ring
+ *
+ *************************************/
+
+static void rewind_store(size_t length)
+{
+	struct rewind_frame *newest;
+	unsigned pos = 0;
+
+	if (length > REWIND_BUFFER_SIZE)
+	{
+		/* the chain back to older frames is broken */
+		rewind_clear_history();
+		return;
+	}
+
+	if (rewind_count)
+	{
+		newest = &rewind_frames[(rewind_first + rewind_count - 1) % rewind_max_frames];
+		pos = newest->pos + newest->length;
+		if (pos + length > REWIND_BUFFER_SIZE)
+		{
+			/* wrap; everything stored past the newest frame is older still */
+			while (rewind_count && rewind_frames[rewind_first].pos >= pos)
+			{
+				rewind_first = (rewind_first + 1) % rewind_max_frames;
+				rewind_count--;
+			}
+			pos = 0;
+		}
+	}
+
+	/* drop the oldest frames that are in the way */
+	while (rewind_count && (rewind_count == rewind_max_frames ||
+			(rewind_frames[rewind_first].pos < pos + length &&
+			 rewind_frames[rewind_first].pos + rewind_frames[rewind_first].length > pos)))
+	{
+		rewind_first = (rewind_first + 1) % rewind_max_frames;
+		rewind_count--;
+	}
+	if (!rewind_count)
+		rewind_first = 0;
+
+	memcpy(rewind_ring + pos, rewind_delta, length);
+	newest = &rewind_frames[(rewind_first + rewind_count) % rewind_max_frames];
+	newest->pos = pos;
+	newest->length = length;
+	rewind_count++;
+}
+
+
+/*************************************
+ *
+ *	Interface
+ *
+ *************************************/
+
+void rewind_capture(void)
+{
+	cycles_t start;
+	size_t length;
+	UINT8 *temp;
+
+	if (rewind_failed && options.rewind == rewind_failed)
+		return;
+	if (options.rewind != rewind_seconds || (rewind_seconds && retro_serialize_size() != rewind_state_size))
+	{
+		/* (re)start the history from the current state */
+		rewind_reset();
+		if (options.rewind && !rewind_init())
+		{
+			rewind_reset();
+			rewind_failed = options.rewind;
+		}
+		return;
+	}
+	if (!rewind_seconds)
+		return;
+
+	start = osd_cycles();
+	if (!retro_serialize(rewind_scratch, rewind_state_size))
+		return;
+
+	/* the delta takes the newest snapshot back to the previous one */
+	length = rewind_encode();
+	rewind_store(length);
+
+	temp = rewind_state;
+	rewind_state = rewind_scratch;
+	rewind_scratch = temp;
+
+	rewind_captures++;
+	rewind_delta_bytes += length;
+	rewind_capture_time += osd_cycles() - start;
+}
+
+unsigned rewind_restore(unsigned frames)
+{
+	unsigned restored = 0;
+
+	if (!rewind_seconds)
+		return 0;
+
+	while (restored < frames && rewind_count)
+	{
+		const struct rewind_frame *newest = &rewind_frames[(rewind_first + rewind_count - 1) % rewind_max_frames];
+		rewind_apply(rewind_ring + newest->pos);
+		rewind_count--;
+		restored++;
+	}
+
+	if (restored && !retro_unserialize(rewind_state, rewind_state_size))
+	{
+		rewind_reset();
+		return 0;
+	}
+	return restored;
+}
@@ -0,0 +1,152 @@
+/*********************************************************************
+
+	thread.c
+
+	Worker threads for the optional parallel parts of the core.
+
+	A worker runs one job at a time: osd_thread_start() hands it a
+	function, osd_thread_wait() blocks until that function has
+	returned. Without HAVE_THREADS no worker can be created and the
+	callers keep doing the work themselves.
+
+*********************************************************************/
+
+#include <stdlib.h>
+#include <libretro.h>
+
+#ifdef HAVE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "mame2003.h"
+#include "log.h"
+
+#ifdef HAVE_THREADS
+
+struct osd_thread
+{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	void (*func)(void *);
+	void *param;
+	int busy;				/* a job has been started and has not returned yet */
+	int quit;
+};
+
+static void *osd_thread_main(void *param)
+{
+	struct osd_thread *thread = param;
+
+	pthread_mutex_lock(&thread->lock);
+	for (;;)
+	{
+		while (!thread->func && !thread->quit)
+			pthread_cond_wait(&thread->cond, &thread->lock);
+		if (thread->quit)
+			break;
+
+		pthread_mutex_unlock(&thread->lock);
+		(*thread->func)(thread->param);
+		pthread_mutex_lock(&thread->lock);
+
+		thread->func = NULL;
+		thread->busy = 0;
+		pthread_cond_broadcast(&thread->cond);
+	}
+	pthread_mutex_unlock(&thread->lock);
+	return NULL;
+}
+
+struct osd_thread *osd_thread_create(void)
+{
+	struct osd_thread *thread = calloc(1, sizeof(*thread));
+
+	if (!thread)
+		return NULL;
+
+	pthread_mutex_init(&thread->lock, NULL);
+	pthread_cond_init(&thread->cond, NULL);
+	if (pthread_create(&thread->thread, NULL, osd_thread_main, thread))
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Unable to create a worker thread\n");
+		pthread_cond_destroy(&thread->cond);
+		pthread_mutex_destroy(&thread->lock);
+		free(thread);
+		return NULL;
+	}
+	return thread;
+}
+
+void osd_thread_start(struct osd_thread *thread, void (*func)(void *), void *param)
+{
+	pthread_mutex_lock(&thread->lock);
+	thread->func = func;
+	thread->param = param;
+	thread->busy = 1;
+	pthread_cond_broadcast(&thread->cond);
+	pthread_mutex_unlock(&thread->lock);
+}
+
+void osd_thread_wait(struct osd_thread *thread)
+{
+	pthread_mutex_lock(&thread->lock);
+	while (thread->busy)
+		pthread_cond_wait(&thread->cond, &thread->lock);
+	pthread_mutex_unlock(&thread->lock);
+}
+
+void osd_thread_destroy(struct osd_thread *thread)
+{
+	if (!thread)
+		return;
+
+	osd_thread_wait(thread);
+	pthread_mutex_lock(&thread->lock);
+	thread->quit = 1;
+	pthread_cond_broadcast(&thread->cond);
+	pthread_mutex_unlock(&thread->lock);
+
+	pthread_join(thread->thread, NULL);
+	pthread_cond_destroy(&thread->cond);
+	pthread_mutex_destroy(&thread->lock);
+	free(thread);
+}
+
+int osd_num_processors(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (count > 1)
+		return (int)count;
+#endif
+	return 1;
+}
+
+#else
+
+struct osd_thread *osd_thread_create(void)
+{
+	return NULL;
+}
+
+void osd_thread_start(struct osd_thread *thread, void (*func)(void *), void *param)
+{
+	(*func)(param);
+}
+
+void osd_thread_wait(struct osd_thread *thread)
+{
+}
+
+void osd_thread_destroy(struct osd_thread *thread)
+{
+}
+
+int osd_num_processors(void)
+{
+	return 1;
+}
+
+#endif /* HAVE_THREADS */
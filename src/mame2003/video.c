@@ -9,6 +9,12 @@
 #include "driver.h"
 #include "log.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 extern retro_environment_t environ_cb;
 extern retro_video_refresh_t video_cb;
 extern retro_set_led_state_t led_state_cb;
@@ -24,10 +30,307 @@ int gotFrame;
 
 extern unsigned retroColorMode;
 
+static const int frameskip_table[12][12] = { { 0,0,0,0,0,0,0,0,0,0,0,0 },
+	                                                                    { 0,0,0,0,0,0,0,0,0,0,0,1 },
+	                                                                    { 0,0,0,0,0,1,0,0,0,0,0,1 },
+	                                                                    { 0,0,0,1,0,0,0,1,0,0,0,1 },
+	                                                                    { 0,0,1,0,0,1,0,0,1,0,0,1 },
+	                                                                    { 0,1,0,0,1,0,1,0,0,1,0,1 },
+	                                                                    { 0,1,0,1,0,1,0,1,0,1,0,1 },
+	                                                                    { 0,1,0,1,1,0,1,0,1,1,0,1 },
+	                                                                    { 0,1,1,0,1,1,0,1,1,0,1,1 },
+	                                                                    { 0,1,1,1,0,1,1,1,0,1,1,1 },
+	                                                                    { 0,1,1,1,1,1,0,1,1,1,1,1 },
+	                                                                    { 0,1,1,1,1,1,1,1,1,1,1,1 } };
+
+/* The skip decision for a frame is made once, at the end of the previous frame,
+   so force_partial_update(), updatescreen(), the drivers and the pixel conversion in
+   osd_update_video_and_audio() all see the same answer and a frame is never half drawn. */
+static unsigned frameskip_counter = 0;
+static int skip_this_frame = 0;
+
+/* automatic frameskip, re-evaluated once per FRAMESKIP_LEVELS frames */
+#define AUTO_FRAMESKIP_TARGET   90  /* percent of the frame budget the core may spend emulating */
+
+static int auto_frameskip_level = 0;
+static int auto_frameskip_adjust = 0;
+static cycles_t auto_frameskip_time = 0;
+
+int osd_skip_this_frame(void)
+{
+   return skip_this_frame;
+}
+
+static void auto_frameskip_update(void)
+{
+   cycles_t cycles_per_second = osd_cycles_per_second();
+   double budget = (double)cycles_per_second * FRAMESKIP_LEVELS / Machine->drv->frames_per_second;
+   double speed;
+
+   if (auto_frameskip_time <= 0)
+      return;
+
+   /* percentage of the target speed reached over the last FRAMESKIP_LEVELS frames */
+   speed = budget * AUTO_FRAMESKIP_TARGET / auto_frameskip_time;
+   auto_frameskip_time = 0;
+
+   if (speed >= 100)
+   {
+      /* keeping up: back off one level after three good cycles in a row */
+      if (++auto_frameskip_adjust >= 3)
+      {
+         auto_frameskip_adjust = 0;
+         if (auto_frameskip_level > 0)
+            auto_frameskip_level--;
+      }
+   }
+   else
+   {
+      /* falling behind: the further behind, the faster the level climbs */
+      if (speed < 80)
+         auto_frameskip_adjust -= (int)(90 - speed) / 5;
+      else
+         auto_frameskip_adjust--;
+
+      while (auto_frameskip_adjust <= -2)
+      {
+         auto_frameskip_adjust += 2;
+         if (auto_frameskip_level < FRAMESKIP_LEVELS - 1)
+            auto_frameskip_level++;
+      }
+   }
+}
+
+void osd_frameskip_end_frame(cycles_t emulation_time)
+{
+   int level = options.frameskip;
+
+   if (level == FRAMESKIP_AUTO)
+   {
+      auto_frameskip_time += emulation_time;
+      if (frameskip_counter == FRAMESKIP_LEVELS - 1)
+         auto_frameskip_update();
+      level = auto_frameskip_level;
+   }
+   else if (level < 0 || level >= FRAMESKIP_LEVELS)
+      level = 0;
+
+   frameskip_counter = (frameskip_counter + 1) % FRAMESKIP_LEVELS;
+   skip_this_frame = frameskip_table[level][frameskip_counter];
+}
+
+/* Conversion of the game bitmap into the frontend's pixel format.
+
+   Palettized games are converted through a copy of the palette kept in
+   RGB565, refreshed from the game's dirty pen bits instead of unpacking
+   every pen every frame. The source pixels of the last converted frame
+   are kept aside, so lines which are unchanged since are not converted
+   again; this does not apply when rendering into the frontend's own
+   framebuffer, whose previous contents are unknown. */
+
+#define RGB_TO_565(c)   ((((c) >> 8) & 0xf800) | (((c) >> 5) & 0x07e0) | (((c) >> 3) & 0x001f))
+#define RGB555_TO_8888(c)  ((((c) & 0x7c00) << 9) | (((c) & 0x03e0) << 6) | (((c) & 0x001f) << 3))
+
+static uint16_t palette_565[65536];
+static unsigned palette_565_entries;
+
+static uint16_t *shadow_lines;     /* source pixels of the frame held in videoBuffer */
+static size_t shadow_size;
+static int shadow_valid;
+
+static void update_palette_565(const struct mame_display *display)
+{
+   unsigned entries = display->game_palette_entries;
+   unsigned i, j;
+
+   if (entries > 65536)
+      entries = 65536;
+
+   if (entries != palette_565_entries)
+   {
+      for (i = 0; i < entries; i++)
+         palette_565[i] = RGB_TO_565(display->game_palette[i]);
+      for (i = 0; i < entries; i += 32)
+         display->game_palette_dirty[i / 32] = 0;
+      palette_565_entries = entries;
+   }
+   else
+   {
+      /* consume the dirty bits; artwork does the same when it is active */
+      for (i = 0; i < entries; i += 32)
+      {
+         UINT32 dirtyflags = display->game_palette_dirty[i / 32];
+         if (!dirtyflags)
+            continue;
+         display->game_palette_dirty[i / 32] = 0;
+         for (j = i; dirtyflags && j < entries; j++, dirtyflags >>= 1)
+            if (dirtyflags & 1)
+               palette_565[j] = RGB_TO_565(display->game_palette[j]);
+      }
+   }
+
+   /* every line has to be converted again with the new colors */
+   shadow_valid = 0;
+}
+
+static void convert_line_palette(uint16_t *output, const uint16_t *input, unsigned width)
+{
+   unsigned j;
+
+   for (j = 0; j + 4 <= width; j += 4)
+   {
+      output[j + 0] = palette_565[input[j + 0]];
+      output[j + 1] = palette_565[input[j + 1]];
+      output[j + 2] = palette_565[input[j + 2]];
+      output[j + 3] = palette_565[input[j + 3]];
+   }
+   for (; j < width; j++)
+      output[j] = palette_565[input[j]];
+}
+
+#if defined(__SSE2__)
+INLINE __m128i expand_555_sse2(__m128i c)
+{
+   return _mm_or_si128(_mm_or_si128(
+         _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x7c00)), 9),
+         _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x03e0)), 6)),
+         _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x001f)), 3));
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+INLINE uint32x4_t expand_555_neon(uint32x4_t c)
+{
+   return vorrq_u32(vorrq_u32(
+         vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x7c00)), 9),
+         vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x03e0)), 6)),
+         vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x001f)), 3));
+}
+#endif
+
+static void convert_line_555(uint32_t *output, const uint16_t *input, unsigned width)
+{
+   unsigned j = 0;
+
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+   for (; j + 8 <= width; j += 8)
+   {
+      const __m128i src = _mm_loadu_si128((const __m128i *)&input[j]);
+      _mm_storeu_si128((__m128i *)&output[j + 0], expand_555_sse2(_mm_unpacklo_epi16(src, zero)));
+      _mm_storeu_si128((__m128i *)&output[j + 4], expand_555_sse2(_mm_unpackhi_epi16(src, zero)));
+   }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+   for (; j + 8 <= width; j += 8)
+   {
+      const uint16x8_t src = vld1q_u16(&input[j]);
+      vst1q_u32(&output[j + 0], expand_555_neon(vmovl_u16(vget_low_u16(src))));
+      vst1q_u32(&output[j + 4], expand_555_neon(vmovl_u16(vget_high_u16(src))));
+   }
+#endif
+   for (; j < width; j++)
+      output[j] = RGB555_TO_8888(input[j]);
+}
+
+/* ask the frontend for a buffer to render into directly */
+static int get_frontend_framebuffer(struct retro_framebuffer *fb, unsigned width, unsigned height)
+{
+   memset(fb, 0, sizeof(*fb));
+   fb->width = width;
+   fb->height = height;
+   fb->access_flags = RETRO_MEMORY_ACCESS_WRITE;
+
+   return environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, fb)
+         && fb->data && fb->format == retroColorMode
+         && fb->width == width && fb->height == height;
+}
+
+/* make room for the source of a width x height frame; returns whether the
+   shadow still describes what videoBuffer holds */
+static int prepare_shadow_lines(unsigned width, unsigned height)
+{
+   size_t size = (size_t)width * height;
+
+   if (size != shadow_size)
+   {
+      free(shadow_lines);
+      shadow_lines = malloc(size * sizeof(shadow_lines[0]));
+      shadow_size = shadow_lines ? size : 0;
+      shadow_valid = 0;
+   }
+   return shadow_lines && shadow_valid;
+}
+
+static void free_shadow_lines(void)
+{
+   free(shadow_lines);
+   shadow_lines = NULL;
+   shadow_size = 0;
+   shadow_valid = 0;
+}
+
+/* convert a 15 or 16bpp frame, skipping the lines whose source is unchanged */
+static void convert_frame(const struct mame_display *display, const uint16_t *input, uint32_t pitch, unsigned width, unsigned height)
+{
+   const int depth = display->game_bitmap->depth;
+   const size_t line_bytes = width * sizeof(input[0]);
+   struct retro_framebuffer fb;
+   void *frame = videoBuffer;
+   uint8_t *output;
+   size_t out_pitch = width * (depth == 16 ? 2 : 4);
+   uint16_t *shadow = NULL;
+   int reuse = 0;
+   unsigned i;
+
+   if (options.frontend_framebuffer && get_frontend_framebuffer(&fb, width, height))
+   {
+      frame = fb.data;
+      out_pitch = fb.pitch;
+      shadow_valid = 0;
+   }
+   else
+   {
+      reuse = prepare_shadow_lines(width, height);
+      shadow = shadow_lines;
+   }
+
+   output = frame;
+   for (i = 0; i < height; i++, input += pitch, output += out_pitch)
+   {
+      if (shadow)
+      {
+         if (reuse && !memcmp(shadow, input, line_bytes))
+         {
+            shadow += width;
+            continue;
+         }
+         memcpy(shadow, input, line_bytes);
+         shadow += width;
+      }
+
+      if (depth == 16)
+         convert_line_palette((uint16_t *)output, input, width);
+      else
+         convert_line_555((uint32_t *)output, input, width);
+   }
+
+   if (shadow_lines && frame == videoBuffer)
+      shadow_valid = 1;
+
+   video_cb(frame, width, height, out_pitch);
+}
+
 int osd_create_display(const struct osd_create_params *params, UINT32 *rgb_components)
 {
    memcpy(&videoConfig, params, sizeof(videoConfig));    
 
+   frameskip_counter = 0;
+   skip_this_frame = 0;
+   auto_frameskip_level = 0;
+   auto_frameskip_adjust = 0;
+   auto_frameskip_time = 0;
+
+   palette_565_entries = 0;
+   free_shadow_lines();
+
    if(Machine->color_depth == 16)
    {
       retroColorMode = RETRO_PIXEL_FORMAT_RGB565;
@@ -71,34 +374,9 @@ int osd_create_display(const struct osd_create_params *params, UINT32 *rgb_compo
 
 void osd_close_display(void)
 {
+   free_shadow_lines();
 }
 
-static const int frameskip_table[12][12] = { { 0,0,0,0,0,0,0,0,0,0,0,0 },
-	                                                                    { 0,0,0,0,0,0,0,0,0,0,0,1 },
-	                                                                    { 0,0,0,0,0,1,0,0,0,0,0,1 },
-	                                                                    { 0,0,0,1,0,0,0,1,0,0,0,1 },
-	                                                                    { 0,0,1,0,0,1,0,0,1,0,0,1 },
-	                                                                    { 0,1,0,0,1,0,1,0,0,1,0,1 },
-	                                                                    { 0,1,0,1,0,1,0,1,0,1,0,1 },
-	                                                                    { 0,1,0,1,1,0,1,0,1,1,0,1 },
-	                                                                    { 0,1,1,0,1,1,0,1,1,0,1,1 },
-	                                                                    { 0,1,1,1,0,1,1,1,0,1,1,1 },
-	                                                                    { 0,1,1,1,1,1,0,1,1,1,1,1 },
-	                                                                    { 0,1,1,1,1,1,1,1,1,1,1,1 } };
-static unsigned frameskip_counter = 0;
-
-int osd_skip_this_frame(void)
-{
-   int ret;
-   if (frameskip_counter >= 11)
-      frameskip_counter = 0;
-
-   ret = frameskip_table[options.frameskip][frameskip_counter];
-
-   frameskip_counter++;
-
-   return ret;
-}
 
 void osd_update_video_and_audio(struct mame_display *display)
 {
@@ -109,17 +387,20 @@ void osd_update_video_and_audio(struct mame_display *display)
    width = videoConfig.width;
    height = videoConfig.height;
 
+   /* palette changes are picked up even on skipped frames */
+   if (display->game_palette && display->game_bitmap->depth == 16 &&
+         (display->changed_flags & GAME_PALETTE_CHANGED || display->game_palette_entries != palette_565_entries))
+      update_palette_565(display);
+
    if(display->changed_flags & 0xF)
    {
-      int i, j;
-
       /* Update UI area*/
       if (display->changed_flags & GAME_VISIBLE_AREA_CHANGED)
       {
          set_ui_visarea(display->game_visible_area.min_x, display->game_visible_area.min_y, display->game_visible_area.max_x, display->game_visible_area.max_y);
       }
 
-      if (video_cb && display->changed_flags & GAME_BITMAP_CHANGED && (osd_skip_this_frame() == 0))
+      if (video_cb && display->changed_flags & GAME_BITMAP_CHANGED)
       {
          /* Cache some values used in the below macros*/
          const uint32_t x = display->game_visible_area.min_x;
@@ -127,46 +408,15 @@ void osd_update_video_and_audio(struct mame_display *display)
          const uint32_t pitch = display->game_bitmap->rowpixels;
 
          /* Copy pixels*/
-         if(display->game_bitmap->depth == 16)
-         {
-            uint16_t* output = (uint16_t*)videoBuffer;
-            const uint16_t* input = &((uint16_t*)display->game_bitmap->base)[y * pitch + x];
-
-            for(i = 0; i < height; i ++)
-            {
-               for (j = 0; j < width; j ++)
-               {
-                  const uint32_t color = display->game_palette[*input++];
-                  *output++ = (((color >> 19) & 0x1f) << 11) | (((color >> 11) & 0x1f) << 6) |
-                     ((color >> 3) & 0x1f);
-               }
-               input += pitch - width;
-            }
-
-            video_cb(videoBuffer, width, height, width * 2);
-         }
-         else if(display->game_bitmap->depth == 32)
+         if(display->game_bitmap->depth == 32)
          {
             const uint32_t* const input = &((const uint32_t*)display->game_bitmap->base)[y * pitch + x];
             video_cb(input, width, height, pitch * 4);
          }
-         else if(display->game_bitmap->depth == 15)
+         else if(display->game_bitmap->depth == 16 || display->game_bitmap->depth == 15)
          {
-            uint32_t* output = (uint32_t*)videoBuffer;
             const uint16_t* input = &((const uint16_t*)display->game_bitmap->base)[y * pitch + x];
-
-            for(i = 0; i < height; i ++)
-            {
-               for(j = 0; j < width; j ++)
-               {
-                  const uint32_t color = *input ++;
-                  *output++ = (((color >> 10) & 0x1f) << 19) | (((color >> 5) & 0x1f) << 11) |
-                     (((color) & 0x1f) << 3);
-               }
-               input += pitch - width;
-            }
-
-            video_cb(videoBuffer, width, height, width * 4);
+            convert_frame(display, input, pitch, width, height);
          }
       }
       else
@@ -114,6 +114,14 @@ struct ExtMemory
     UINT8 *			data;
 };
 
+/* ----- RAM zones registered into the state save system ----- */
+struct memory_zone
+{
+	int				cpunum;
+	offs_t			start, end;		/* in the CPU's address space */
+	void *			base;			/* host pointer to start, in host-endian data bus words */
+};
+
 
 
 /***************************************************************************
@@ -812,6 +820,7 @@ void		memory_set_unmap_value(data32_t value);
 /* ----- dynamic bank handlers ----- */
 void		memory_set_bankhandler_r(int bank, offs_t offset, mem_read_handler handler);
 void		memory_set_bankhandler_w(int bank, offs_t offset, mem_write_handler handler);
+void		memory_refresh_bank(int bank);
 
 /* ----- opcode base control ---- */
 opbase_handler memory_set_opbase_handler(int cpunum, opbase_handler function);
@@ -823,6 +832,9 @@ extern offs_t encrypted_opcode_start[],encrypted_opcode_end[];
 
 /* ----- return a base pointer to memory ---- */
 void *		memory_find_base(int cpunum, offs_t offset);
+int			memory_get_zone_count(void);
+const struct memory_zone *memory_get_zone(int index);
+const struct memory_zone *memory_find_zone(int cpunum, offs_t start, offs_t end);
 void *		memory_get_read_ptr(int cpunum, offs_t offset);
 void *		memory_get_write_ptr(int cpunum, offs_t offset);
 
@@ -858,6 +870,7 @@ extern offs_t			OP_MEM_MAX;			/* opcode memory maximum */
 extern UINT8 *			cpu_bankbase[];		/* array of bank bases */
 extern UINT8 *			readmem_lookup;		/* pointer to the readmem lookup table */
 extern offs_t			mem_amask;			/* memory address mask */
+extern UINT32			memory_writes;		/* memory and port writes so far */
 extern struct ExtMemory	ext_memory[];		/* externally-allocated memory */
 
 
@@ -936,6 +949,7 @@ do {																					\
 	if (bank >= STATIC_BANK1 && bank <= STATIC_BANKMAX)									\
 	{																					\
 		cpu_bankbase[bank] = (UINT8 *)(base);											\
+		memory_refresh_bank(bank);														\
 		if (opcode_entry == bank && cpu_getactivecpu() >= 0)							\
 		{																				\
 			opcode_entry = 0xff;														\
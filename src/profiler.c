@@ -1,3 +1,468 @@
+/***************************************************************************
+
+	profiler.c
+
+	Section profiler behind profiler_mark(), usable in release builds.
+
+	Time is read with osd_profiling_ticks() and charged to the innermost
+	open section (exclusive time) as well as to each section on the stack
+	(inclusive time). Every nested section is also charged to its parent,
+	so the dump shows where a section's time went. The whole frame runs
+	inside PROFILER_EXTRA, which therefore collects anything not otherwise
+	marked.
+
+	At the end of every frame the per-section totals go into a log2
+	histogram and a ring of the most recent frames. The histograms are kept
+	in ticks and converted to microseconds at dump time, using the tick
+	rate measured against osd_cycles() while the profiler was running;
+	percentiles are reported as the upper edge of their bucket.
+
+	Event counters bumped with profiler_count() are totalled per frame
+	alongside the sections; the dump reports their average and worst
+	frame.
+
+	Sections are only timed on the thread running the frame. Marks made
+	by the threaded video renderer are ignored; the frame thread's wait
+	for it is what gets charged.
+
+***************************************************************************/
+
 #include "driver.h"
 #include "osd_cpu.h"
+#include "fileio.h"
+
+#define PROFILER_STACK_DEPTH	16
+#define PROFILER_HISTORY		60		/* frames in the rolling window */
+#define PROFILER_BUCKETS		48		/* log2 histogram of ticks per frame */
+
+/* the whole frame is tracked as an extra section after the real ones */
+#define PROFILER_FRAME			PROFILER_TOTAL
+
+struct profile_section
+{
+	UINT64 exclusive;						/* ticks with this section innermost */
+	UINT64 inclusive;						/* ticks with this section anywhere on the stack */
+	UINT64 child[PROFILER_TOTAL];			/* inclusive ticks of directly nested sections */
+	UINT64 calls;
+	UINT64 this_frame;						/* exclusive ticks in the current frame */
+	UINT64 max_frame;
+	UINT32 histogram[PROFILER_BUCKETS];		/* frames by exclusive ticks */
+	UINT64 history[PROFILER_HISTORY];		/* exclusive ticks of the last frames */
+};
+
+struct profile_counter
+{
+	UINT64 total;
+	UINT64 max_frame;
+};
+
+struct profile_entry
+{
+	int type;
+	cycles_t start;		/* restarted whenever a nested section ends */
+	cycles_t enter;		/* time the section was entered */
+};
+
+static const char *const section_names[PROFILER_TOTAL + 1] =
+{
+	"CPU1", "CPU2", "CPU3", "CPU4", "CPU5", "CPU6", "CPU7", "CPU8",
+	"Memory read", "Memory write", "Video update", "drawgfx", "copybitmap",
+	"Tilemap draw", "Tilemap draw roz", "Tilemap update", "Artwork", "Blit",
+	"Sound", "Mixer", "Timer callback", "Hiscore", "Input", "Extra",
+	"User1", "User2", "User3", "User4", "Profiler", "Idle",
+	"Frame"
+};
+
+static const char *const counter_names[PROFILER_COUNT_TOTAL] =
+{
+	"Context switches", "Context copies"
+};
+
+int profiler_active;
+unsigned profiler_counts[PROFILER_COUNT_TOTAL];
+
+static struct profile_section sections[PROFILER_TOTAL + 1];
+static struct profile_counter counters[PROFILER_COUNT_TOTAL];
+static struct profile_entry FILO[PROFILER_STACK_DEPTH];
+static int FILO_length;
+static int depth[PROFILER_TOTAL];
+static int overflow;
+
+static int output_mode;
+static unsigned frames;
+static unsigned history_pos;
+static cycles_t frame_start;
+
+/* calibration of the tick counter against osd_cycles() */
+static cycles_t calib_ticks, calib_usec;
+static cycles_t start_ticks, start_usec;
+
+/* set on the thread that calls profiler_frame_begin */
+#if defined(HAVE_THREADS) && defined(__GNUC__)
+static __thread int frame_thread;
+#define ON_FRAME_THREAD()		(frame_thread)
+#else
+#define ON_FRAME_THREAD()		(1)
+#endif
+
+
+/*-------------------------------------------------
+	profiler_start - begin collecting data
+-------------------------------------------------*/
+
+void profiler_start(void)
+{
+	if (profiler_active)
+		return;
+
+	FILO_length = 0;
+	memset(depth, 0, sizeof(depth));
+	output_mode = options.profiler;
+	start_usec = osd_cycles();
+	start_ticks = osd_profiling_ticks();
+	profiler_active = 1;
+}
+
+
+/*-------------------------------------------------
+	profiler_stop - stop collecting data; what
+	was gathered so far is kept for the dump
+-------------------------------------------------*/
+
+void profiler_stop(void)
+{
+	if (!profiler_active)
+		return;
+
+	profiler_active = 0;
+	calib_ticks += osd_profiling_ticks() - start_ticks;
+	calib_usec += osd_cycles() - start_usec;
+}
+
+
+/*-------------------------------------------------
+	profiler__mark - open or close a section
+-------------------------------------------------*/
+
+void profiler__mark(int type)
+{
+	cycles_t curr_ticks;
+	struct profile_entry *top;
+
+	if (!ON_FRAME_THREAD())
+		return;
+
+	curr_ticks = osd_profiling_ticks();
+	if (type != PROFILER_END)
+	{
+		if (FILO_length >= PROFILER_STACK_DEPTH)
+		{
+			if (!overflow++)
+				log_cb(RETRO_LOG_WARN, LOGPRE "Profiler error: FILO buffer overflow\n");
+			return;
+		}
+
+		/* charge the time so far to the section we are nested in */
+		if (FILO_length > 0)
+		{
+			top = &FILO[FILO_length - 1];
+			sections[top->type].this_frame += curr_ticks - top->start;
+		}
+
+		top = &FILO[FILO_length++];
+		top->type = type;
+		top->start = top->enter = curr_ticks;
+		sections[type].calls++;
+		depth[type]++;
+	}
+	else
+	{
+		if (FILO_length <= 0)
+		{
+			if (!overflow++)
+				log_cb(RETRO_LOG_WARN, LOGPRE "Profiler error: FILO buffer underflow\n");
+			return;
+		}
+
+		top = &FILO[--FILO_length];
+		sections[top->type].this_frame += curr_ticks - top->start;
+
+		/* recursive entries only count once towards inclusive time */
+		if (--depth[top->type] == 0)
+			sections[top->type].inclusive += curr_ticks - top->enter;
+
+		if (FILO_length > 0)
+		{
+			struct profile_entry *parent = &FILO[FILO_length - 1];
+			if (parent->type != top->type)
+				sections[parent->type].child[top->type] += curr_ticks - top->enter;
+
+			/* reset start time for nested calls */
+			parent->start = curr_ticks;
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+	profiler_frame_begin - called before each
+	emulated frame; applies the core option
+-------------------------------------------------*/
+
+void profiler_frame_begin(void)
+{
+	if (options.profiler != PROFILER_OUTPUT_NONE)
+	{
+		profiler_start();
+		output_mode = options.profiler;
+	}
+	else
+		profiler_stop();
+
+	if (!profiler_active)
+		return;
+
+#if defined(HAVE_THREADS) && defined(__GNUC__)
+	frame_thread = 1;
+#endif
+	frame_start = osd_profiling_ticks();
+	profiler__mark(PROFILER_EXTRA);
+}
+
+
+/*-------------------------------------------------
+	profiler_frame_end - close the frame and
+	fold its totals into the statistics
+-------------------------------------------------*/
+
+static int bucket_of(UINT64 ticks)
+{
+	int bucket = 0;
+
+	while (ticks && bucket < PROFILER_BUCKETS - 1)
+	{
+		ticks >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void profiler_frame_end(void)
+{
+	int type;
+
+	if (!profiler_active)
+		return;
+
+	profiler__mark(PROFILER_END);
+	if (FILO_length != 0)
+	{
+		if (!overflow++)
+			log_cb(RETRO_LOG_WARN, LOGPRE "Profiler error: %d section(s) still open at end of frame\n", FILO_length);
+		FILO_length = 0;
+		memset(depth, 0, sizeof(depth));
+	}
+
+	sections[PROFILER_FRAME].this_frame = osd_profiling_ticks() - frame_start;
+	sections[PROFILER_FRAME].inclusive += sections[PROFILER_FRAME].this_frame;
+	sections[PROFILER_FRAME].calls++;
+
+	for (type = 0; type <= PROFILER_TOTAL; type++)
+	{
+		struct profile_section *section = &sections[type];
+		UINT64 ticks = section->this_frame;
+
+		section->exclusive += ticks;
+		if (ticks > section->max_frame)
+			section->max_frame = ticks;
+		section->histogram[bucket_of(ticks)]++;
+		section->history[history_pos] = ticks;
+		section->this_frame = 0;
+	}
+
+	for (type = 0; type < PROFILER_COUNT_TOTAL; type++)
+	{
+		counters[type].total += profiler_counts[type];
+		if (profiler_counts[type] > counters[type].max_frame)
+			counters[type].max_frame = profiler_counts[type];
+		profiler_counts[type] = 0;
+	}
+
+	history_pos = (history_pos + 1) % PROFILER_HISTORY;
+	frames++;
+}
+
+
+/*-------------------------------------------------
+	profiler_dump - report to the log or write
+	profile/<game>.json, then reset
+-------------------------------------------------*/
+
+static double ticks_per_usec(void)
+{
+	cycles_t ticks = calib_ticks, usec = calib_usec;
+
+	if (profiler_active)
+	{
+		ticks += osd_profiling_ticks() - start_ticks;
+		usec += osd_cycles() - start_usec;
+	}
+	if (ticks <= 0 || usec <= 0)
+		return 1.0;
+	return (double)ticks / (double)usec;
+}
+
+static double percentile_ticks(const struct profile_section *section, unsigned percent)
+{
+	UINT64 wanted = ((UINT64)frames * percent + 99) / 100;
+	UINT64 seen = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < PROFILER_BUCKETS; bucket++)
+	{
+		seen += section->histogram[bucket];
+		if (seen >= wanted)
+			break;
+	}
+	if (bucket == 0)
+		return 0;
+	if (((UINT64)1 << bucket) > section->max_frame)
+		return (double)section->max_frame;
+	return (double)((UINT64)1 << bucket);
+}
+
+static double recent_ticks(const struct profile_section *section)
+{
+	unsigned count = (frames < PROFILER_HISTORY) ? frames : PROFILER_HISTORY;
+	UINT64 total = 0;
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		total += section->history[i];
+	return count ? (double)total / count : 0;
+}
+
+static void dump_log(double scale)
+{
+	const struct profile_section *frame = &sections[PROFILER_FRAME];
+	double frame_us = frame->exclusive * scale / frames;
+	int type, child;
+
+	log_cb(RETRO_LOG_INFO, LOGPRE "Profiler: %s, %u frames, %.1f us/frame (p50 %.0f, p99 %.0f, max %.0f), %.1f ticks/us\n",
+			Machine->gamedrv->name, frames, frame_us,
+			percentile_ticks(frame, 50) * scale, percentile_ticks(frame, 99) * scale, frame->max_frame * scale,
+			1.0 / scale);
+	for (type = 0; type < PROFILER_COUNT_TOTAL; type++)
+		log_cb(RETRO_LOG_INFO, LOGPRE "%-18s %10.1f/frame, max %.0f\n",
+				counter_names[type], (double)counters[type].total / frames, (double)counters[type].max_frame);
+	log_cb(RETRO_LOG_INFO, LOGPRE "%-18s %6s %10s %10s %9s %9s %9s %10s %10s\n",
+			"section", "excl%", "excl us/f", "incl us/f", "p50 us", "p99 us", "max us", "recent us", "calls/f");
+
+	for (type = 0; type < PROFILER_TOTAL; type++)
+	{
+		const struct profile_section *section = &sections[type];
+
+		if (!section->calls)
+			continue;
+
+		log_cb(RETRO_LOG_INFO, LOGPRE "%-18s %5.1f%% %10.1f %10.1f %9.0f %9.0f %9.0f %10.1f %10.1f\n",
+				section_names[type],
+				frame->exclusive ? 100.0 * section->exclusive / frame->exclusive : 0,
+				section->exclusive * scale / frames, section->inclusive * scale / frames,
+				percentile_ticks(section, 50) * scale, percentile_ticks(section, 99) * scale,
+				section->max_frame * scale, recent_ticks(section) * scale,
+				(double)section->calls / frames);
+
+		for (child = 0; child < PROFILER_TOTAL; child++)
+			if (section->child[child])
+				log_cb(RETRO_LOG_INFO, LOGPRE "  +- %-14s %17.1f\n",
+						section_names[child], section->child[child] * scale / frames);
+	}
+}
+
+static void dump_json(double scale)
+{
+	char filename[64];
+	FILE *file;
+	int type, child, bucket;
+	int first_section = 1;
+
+	snprintf(filename, sizeof(filename), "%s.json", Machine->gamedrv->name);
+	file = osd_fopen(FILETYPE_PROFILE, 0, filename, "w");
+	if (!file)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Profiler: unable to write %s\n", filename);
+		return;
+	}
+
+	fprintf(file, "{\n  \"driver\": \"%s\",\n  \"frames\": %u,\n  \"ticks_per_us\": %.3f,\n",
+			Machine->gamedrv->name, frames, 1.0 / scale);
+
+	fprintf(file, "  \"counters\": {");
+	for (type = 0; type < PROFILER_COUNT_TOTAL; type++)
+		fprintf(file, "%s \"%s\": { \"per_frame\": %.2f, \"max\": %.0f }", type ? "," : "",
+				counter_names[type], (double)counters[type].total / frames, (double)counters[type].max_frame);
+	fprintf(file, " },\n");
+
+	fprintf(file, "  \"histogram_upper_us\": [");
+	for (bucket = 0; bucket < PROFILER_BUCKETS; bucket++)
+		fprintf(file, "%s%.3f", bucket ? ", " : "", bucket ? (double)((UINT64)1 << bucket) * scale : 0);
+	fprintf(file, "],\n  \"sections\": [\n");
+
+	for (type = 0; type <= PROFILER_TOTAL; type++)
+	{
+		const struct profile_section *section = &sections[type];
+		int first = 1;
+
+		if (!section->calls)
+			continue;
+
+		fprintf(file, "%s    { \"name\": \"%s\", \"calls\": %.0f, \"exclusive_us\": %.1f, \"inclusive_us\": %.1f,\n",
+				first_section ? "" : ",\n", section_names[type], (double)section->calls,
+				section->exclusive * scale, section->inclusive * scale);
+		fprintf(file, "      \"frame_us\": { \"avg\": %.2f, \"recent\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f },\n",
+				section->exclusive * scale / frames, recent_ticks(section) * scale,
+				percentile_ticks(section, 50) * scale, percentile_ticks(section, 90) * scale,
+				percentile_ticks(section, 99) * scale, section->max_frame * scale);
+
+		fprintf(file, "      \"histogram\": [");
+		for (bucket = 0; bucket < PROFILER_BUCKETS; bucket++)
+			fprintf(file, "%s%u", bucket ? ", " : "", section->histogram[bucket]);
+
+		fprintf(file, "],\n      \"children_us\": {");
+		for (child = 0; child < PROFILER_TOTAL; child++)
+			if (section->child[child])
+			{
+				fprintf(file, "%s \"%s\": %.1f", first ? "" : ",", section_names[child], section->child[child] * scale);
+				first = 0;
+			}
+		fprintf(file, " } }");
+		first_section = 0;
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+	log_cb(RETRO_LOG_INFO, LOGPRE "Profiler: wrote %s\n", filename);
+}
+
+void profiler_dump(void)
+{
+	double scale;
+
+	if (frames && Machine && Machine->gamedrv)
+	{
+		scale = 1.0 / ticks_per_usec();
+		if (output_mode == PROFILER_OUTPUT_JSON)
+			dump_json(scale);
+		else
+			dump_log(scale);
+	}
 
+	profiler_stop();
+	memset(sections, 0, sizeof(sections));
+	memset(counters, 0, sizeof(counters));
+	memset(profiler_counts, 0, sizeof(profiler_counts));
+	calib_ticks = calib_usec = 0;
+	frames = history_pos = 0;
+	overflow = 0;
+}
@@ -42,6 +42,13 @@ enum {
 };
 
 
+/* event counters, reported per frame next to the sections */
+enum {
+	PROFILER_COUNT_CONTEXT_SWITCH = 0,	/* active CPU changed */
+	PROFILER_COUNT_CONTEXT_COPY,		/* register file copied into or out of a core */
+	PROFILER_COUNT_TOTAL
+};
+
 /*
 To start profiling a certain section, e.g. video:
 profiler_mark(PROFILER_VIDEO);
@@ -49,20 +56,27 @@ profiler_mark(PROFILER_VIDEO);
 to end profiling the current section:
 profiler_mark(PROFILER_END);
 
-the profiler handles a FILO list so calls may be nested.
+the profiler handles a FILO list so calls may be nested. Only the thread
+running the frame is profiled; marks from worker threads are ignored.
+
+The profiler is compiled into release builds too. While it is not running,
+profiler_mark() costs a single test of profiler_active; it is started and
+stopped at frame boundaries according to the "Profiler" core option.
 */
 
-#ifdef MAME_DEBUG
-#define profiler_mark(type) profiler__mark(type)
-#else
-#define profiler_mark(type)
-#endif
+extern int profiler_active;
+extern unsigned profiler_counts[PROFILER_COUNT_TOTAL];
+
+#define profiler_mark(type)		do { if (profiler_active) profiler__mark(type); } while (0)
+#define profiler_count(counter)	do { if (profiler_active) profiler_counts[counter]++; } while (0)
 
 void profiler__mark(int type);
 
-/* functions called by usrintf.c */
+/* functions called by the libretro frontend glue */
 void profiler_start(void);
 void profiler_stop(void);
-void profiler_show(struct mame_bitmap *bitmap);
+void profiler_frame_begin(void);
+void profiler_frame_end(void);
+void profiler_dump(void);
 
 #endif	/* PROFILER_H */
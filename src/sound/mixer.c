@@ -13,6 +13,12 @@
 #include <limits.h>
 #include <assert.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 /***************************************************************************/
 /* Options */
 
@@ -100,8 +106,8 @@ static unsigned accum_base;
 static int left_accum[ACCUMULATOR_SAMPLES];
 static int right_accum[ACCUMULATOR_SAMPLES];
 
-/* 16-bit mix buffers */
-static INT16 mix_buffer[ACCUMULATOR_SAMPLES*2]; /* *2 for stereo */
+/* 16-bit mix buffer, always interleaved stereo */
+static INT16 mix_buffer[ACCUMULATOR_SAMPLES*2];
 
 /* global sample tracking */
 static unsigned samples_this_frame;
@@ -670,7 +676,8 @@ int mixer_sh_start(void)
 	memset(left_accum, 0, sizeof(left_accum));
 	memset(right_accum, 0, sizeof(right_accum));
 
-	samples_this_frame = osd_start_audio_stream(is_stereo);
+	/* mono games are duplicated into both channels by mixer_sh_update */
+	samples_this_frame = osd_start_audio_stream(1);
 
 	mixer_sound_enabled = 1;
 
@@ -727,6 +734,55 @@ void mixer_update_channel(struct mixer_channel_data *channel, int total_sample_c
 	}
 }
 
+/***************************************************************************
+	mixer_clip_run
+***************************************************************************/
+
+/* Clip count accumulated samples starting at pos into interleaved 16-bit
+   stereo, zeroing the accumulators behind us. Mono games only use the left
+   accumulator, which then feeds both channels. */
+static void mixer_clip_run(INT16 *mix, unsigned pos, unsigned count)
+{
+	const int *left = &left_accum[pos];
+	const int *right = is_stereo ? &right_accum[pos] : left;
+	unsigned i = 0;
+
+#if defined(MIXER_USE_CLIPPING) && defined(__SSE2__)
+	/* packs saturates to the same range MAME_CLAMP_SAMPLE clips to */
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i l = _mm_packs_epi32(_mm_loadu_si128((const __m128i *)&left[i]), _mm_loadu_si128((const __m128i *)&left[i + 4]));
+		const __m128i r = is_stereo ? _mm_packs_epi32(_mm_loadu_si128((const __m128i *)&right[i]), _mm_loadu_si128((const __m128i *)&right[i + 4])) : l;
+		_mm_storeu_si128((__m128i *)&mix[i * 2], _mm_unpacklo_epi16(l, r));
+		_mm_storeu_si128((__m128i *)&mix[i * 2 + 8], _mm_unpackhi_epi16(l, r));
+	}
+#elif defined(MIXER_USE_CLIPPING) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+	for (; i + 8 <= count; i += 8)
+	{
+		int16x8x2_t lr;
+		lr.val[0] = vcombine_s16(vqmovn_s32(vld1q_s32(&left[i])), vqmovn_s32(vld1q_s32(&left[i + 4])));
+		lr.val[1] = is_stereo ? vcombine_s16(vqmovn_s32(vld1q_s32(&right[i])), vqmovn_s32(vld1q_s32(&right[i + 4]))) : lr.val[0];
+		vst2q_s16(&mix[i * 2], lr);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		int sample = left[i];
+		MAME_CLAMP_SAMPLE(sample);
+		mix[i * 2] = sample;
+
+		sample = right[i];
+		MAME_CLAMP_SAMPLE(sample);
+		mix[i * 2 + 1] = sample;
+	}
+
+	memset(&left_accum[pos], 0, count * sizeof(left_accum[0]));
+	if (is_stereo)
+		memset(&right_accum[pos], 0, count * sizeof(right_accum[0]));
+}
+
+
 /***************************************************************************
 	mixer_sh_update
 ***************************************************************************/
@@ -736,7 +792,7 @@ void mixer_sh_update(void)
 	struct mixer_channel_data* channel;
 	unsigned accum_pos = accum_base;
 	INT16 *mix;
-	int sample;
+	unsigned done;
 	int i;
 
 	profiler_mark(PROFILER_MIXER);
@@ -753,50 +809,18 @@ void mixer_sh_update(void)
 			channel->samples_available -= samples_this_frame;
 	}
 
-	/* copy the mono 32-bit data to a 16-bit buffer, clipping along the way */
-	if (!is_stereo)
-	{
-		mix = mix_buffer;
-		for (i = 0; i < samples_this_frame; i++)
-		{
-			/* fetch and clip the sample */
-			sample = left_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
-
-			/* store and zero out behind us */
-			*mix++ = sample;
-			left_accum[accum_pos] = 0;
-
-			/* advance to the next sample */
-			accum_pos = (accum_pos + 1) & ACCUMULATOR_MASK;
-		}
-	}
-
-	/* copy the stereo 32-bit data to a 16-bit buffer, clipping along the way */
-	else
+	/* clip the 32-bit data into the stereo 16-bit buffer, in at most two runs around the wrap */
+	for (done = 0, mix = mix_buffer; done < samples_this_frame; )
 	{
-		mix = mix_buffer;
-		for (i = 0; i < samples_this_frame; i++)
-		{
-			/* fetch and clip the left sample */
-			sample = left_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
-
-			/* store and zero out behind us */
-			*mix++ = sample;
-			left_accum[accum_pos] = 0;
+		unsigned run = samples_this_frame - done;
+		if (run > ACCUMULATOR_SAMPLES - accum_pos)
+			run = ACCUMULATOR_SAMPLES - accum_pos;
 
-			/* fetch and clip the right sample */
-			sample = right_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
+		mixer_clip_run(mix, accum_pos, run);
 
-			/* store and zero out behind us */
-			*mix++ = sample;
-			right_accum[accum_pos] = 0;
-
-			/* advance to the next sample */
-			accum_pos = (accum_pos + 1) & ACCUMULATOR_MASK;
-		}
+		mix += run * 2;
+		done += run;
+		accum_pos = (accum_pos + run) & ACCUMULATOR_MASK;
 	}
 
 	/* play the result */
@@ -89,6 +89,26 @@ static int ss_current_tag;
 
 static unsigned char *ss_dump_array;
 static unsigned int ss_dump_size;
+static int ss_need_convert;
+
+/* The registry frozen into a flat array of records, grouped by tag, so that
+   saving and loading a tag is a straight copy loop over its records. The
+   layout is built the first time it is needed and thrown away whenever a new
+   entry is registered. */
+typedef struct ss_record {
+	void *data;
+	unsigned offset;
+	unsigned bytes;
+	unsigned count;
+	int type;
+} ss_record;
+
+static ss_record *ss_records;
+static int *ss_tag_first;		/* first record of each tag, ss_tag_count + 1 entries */
+static int ss_tag_count;
+static unsigned int ss_layout_size;	/* 0 when the state cannot be saved */
+static UINT32 ss_layout_signature;
+static int ss_layout_valid;
 
 
 static UINT32 ss_get_signature(void)
@@ -141,6 +161,17 @@ static UINT32 ss_get_signature(void)
 	return signature;
 }
 
+static void ss_free_layout(void)
+{
+	free(ss_records);
+	free(ss_tag_first);
+	ss_records = 0;
+	ss_tag_first = 0;
+	ss_tag_count = 0;
+	ss_layout_size = 0;
+	ss_layout_valid = 0;
+}
+
 void state_save_reset(void)
 {
 	ss_func *f;
@@ -181,6 +212,7 @@ void state_save_reset(void)
 	ss_current_tag = 0;
 	ss_dump_array = 0;
 	ss_dump_size = 0;
+	ss_free_layout();
 }
 
 static ss_module *ss_get_module(const char *name)
@@ -233,6 +265,7 @@ static ss_entry *ss_register_entry(const char *module, int instance, const char
 	(*ep)->size   = size;
 	(*ep)->offset = 0;
 	(*ep)->tag	  = ss_current_tag;
+	ss_layout_valid = 0;
 	return *ep;
 }
 
@@ -379,69 +412,84 @@ static void ss_c8(unsigned char *data, unsigned size)
 	}
 }
 
-/* __LIBRETRO__: Serialize helper*/
-size_t state_get_dump_size(void)
+static void ss_build_layout(void)
 {
 	ss_module *m;
-  
-  if(Machine->gamedrv->flags & GAME_DOESNT_SERIALIZE)
-  {
-    log_cb(RETRO_LOG_ERROR, LOGPRE "Driver flagged GAME_DOESNT_SERIALIZE. Setting state_get_dump_size() to 0.\n");
-    return 0;
-  }
-  
-	TRACE(logerror("Beginning save\n"));
-	ss_dump_size = 0x18;
+	unsigned int offset = 0x18;
+	int count = 0, max_tag = 0, missing = 0;
+	int tag, pos;
+
+	ss_free_layout();
+	ss_layout_valid = 1;
+
+	if(Machine->gamedrv->flags & GAME_DOESNT_SERIALIZE) {
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Driver flagged GAME_DOESNT_SERIALIZE. Setting state_get_dump_size() to 0.\n");
+		return;
+	}
+
+	/* Pass 1 : assign the offsets, in registry order as the file format requires */
 	for(m = ss_registry; m; m=m->next) {
 		int i;
 		for(i=0; i<MAX_INSTANCES; i++) {
 			ss_entry *e;
 			for(e = m->instances[i]; e; e=e->next) {
-			    if(!e->data)
-			    {
-			        return 0;
-			    }
-				e->offset = ss_dump_size;
-				ss_dump_size += ss_size[e->type]*e->size;
+				e->offset = offset;
+				offset += ss_size[e->type]*e->size;
+				if(!e->data)
+					missing = 1;
+				if(e->tag > max_tag)
+					max_tag = e->tag;
+				count++;
+				TRACE(logerror("    %d %s.%d.%s: %x..%x\n", e->tag, m->name, i, e->name, e->offset, offset-1));
 			}
 		}
 	}
 
-    return ss_dump_size;
-}
+	if(missing) {
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Save state entry registered without data. Setting state_get_dump_size() to 0.\n");
+		return;
+	}
 
-void state_save_save_begin(void *array)
-{
-	ss_module *m;
-	TRACE(logerror("Beginning save\n"));
-	ss_dump_size = 0x18;
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next) {
-				e->offset = ss_dump_size;
-				ss_dump_size += ss_size[e->type]*e->size;
+	ss_records = malloc((count ? count : 1) * sizeof(ss_record));
+	ss_tag_first = malloc((max_tag + 2) * sizeof(int));
+	if(!ss_records || !ss_tag_first) {
+		logerror("malloc failed in ss_build_layout\n");
+		ss_free_layout();
+		ss_layout_valid = 1;
+		return;
+	}
+
+	/* Pass 2 : group the records by tag, keeping the file order within a tag */
+	pos = 0;
+	for(tag = 0; tag <= max_tag; tag++) {
+		ss_tag_first[tag] = pos;
+		for(m = ss_registry; m; m=m->next) {
+			int i;
+			for(i=0; i<MAX_INSTANCES; i++) {
+				ss_entry *e;
+				for(e = m->instances[i]; e; e=e->next)
+					if(e->tag == tag) {
+						ss_record *r = &ss_records[pos++];
+						r->data   = e->data;
+						r->offset = e->offset;
+						r->bytes  = ss_size[e->type]*e->size;
+						r->count  = e->size;
+						r->type   = e->type;
+					}
 			}
 		}
 	}
+	ss_tag_first[max_tag + 1] = pos;
+	ss_tag_count = max_tag + 1;
 
-	TRACE(logerror("   total size %u\n", ss_dump_size));
-	ss_dump_array = array;
-	if (ss_dump_array == NULL)
-	{
-		logerror ("malloc failed in state_save_save_begin\n");
-	}
+	ss_layout_signature = ss_get_signature();
+	ss_layout_size = offset;
+	TRACE(logerror("   %d records, %d tags, total size %u\n", count, ss_tag_count, ss_layout_size));
 }
 
-int state_save_save_continue(void)
+static void ss_call_funcs(ss_func *f)
 {
-	ss_module *m;
-	ss_func * f;
 	int count = 0;
-	TRACE(logerror("Saving tag %d\n", ss_current_tag));
-	TRACE(logerror("  calling pre-save functions\n"));
-	f = ss_prefunc_reg;
 	while(f) {
 		if(f->tag == ss_current_tag) {
 			count++;
@@ -450,44 +498,67 @@ int state_save_save_continue(void)
 		f = f->next;
 	}
 	TRACE(logerror("    %d functions called\n", count));
+}
+
+/* __LIBRETRO__: Serialize helper*/
+size_t state_get_dump_size(void)
+{
+	if(!ss_layout_valid)
+		ss_build_layout();
+	return ss_layout_size;
+}
+
+void state_save_save_begin(void *array)
+{
+	TRACE(logerror("Beginning save\n"));
+	if(!ss_layout_valid)
+		ss_build_layout();
+
+	TRACE(logerror("   total size %u\n", ss_layout_size));
+	ss_dump_array = array;
+	ss_dump_size = ss_layout_size;
+}
+
+int state_save_save_continue(void)
+{
+	const ss_record *r, *end;
+
+	TRACE(logerror("Saving tag %d\n", ss_current_tag));
+	TRACE(logerror("  calling pre-save functions\n"));
+	ss_call_funcs(ss_prefunc_reg);
+
+	if(!ss_dump_array || !ss_dump_size) {
+		ss_dump_array = 0;
+		ss_dump_size = 0;
+		return 1;
+	}
+	if(ss_current_tag < 0 || ss_current_tag >= ss_tag_count)
+		return 0;
+
 	TRACE(logerror("  copying data\n"));
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next)
-				if(e->tag == ss_current_tag) {
-				    if(!e->data) {
-				    	ss_dump_array = 0;
-                    	ss_dump_size = 0;
-                    	return 1;
-				    }
-					if(e->type == SS_INT) {
-						int v = *(int *)(e->data);
-						ss_dump_array[e->offset]   = v ;
-						ss_dump_array[e->offset+1] = v >> 8;
-						ss_dump_array[e->offset+2] = v >> 16;
-						ss_dump_array[e->offset+3] = v >> 24;
-						TRACE(logerror("    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+3));
-					} else {
-						memcpy(ss_dump_array + e->offset, e->data, ss_size[e->type]*e->size);
-						TRACE(logerror("    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+ss_size[e->type]*e->size-1));
-					}
-				}
-		}
+	r = ss_records + ss_tag_first[ss_current_tag];
+	end = ss_records + ss_tag_first[ss_current_tag + 1];
+	for(; r != end; r++) {
+		if(r->type == SS_INT) {
+			int v = *(int *)(r->data);
+			ss_dump_array[r->offset]   = v ;
+			ss_dump_array[r->offset+1] = v >> 8;
+			ss_dump_array[r->offset+2] = v >> 16;
+			ss_dump_array[r->offset+3] = v >> 24;
+		} else
+			memcpy(ss_dump_array + r->offset, r->data, r->bytes);
 	}
-	
+
 	return 0;
 }
 
 void state_save_save_finish(void)
 {
-	UINT32 signature;
+	UINT32 signature = ss_layout_signature;
 	unsigned char flags = 0;
 
 	TRACE(logerror("Finishing save\n"));
 
-	signature = ss_get_signature();
 	if(!Machine->sample_rate)
 		flags |= SS_NO_SOUND;
 
@@ -512,17 +583,23 @@ void state_save_save_finish(void)
 
 int state_save_load_begin(void *array, size_t size)
 {
-	ss_module *m;
-	unsigned int offset = 0;
 	UINT32 signature, file_sig;
 
 	TRACE(logerror("Beginning load\n"));
 
-	signature = ss_get_signature();
+	if(!ss_layout_valid)
+		ss_build_layout();
+	signature = ss_layout_signature;
 
 	ss_dump_size = size;
 	ss_dump_array = array;
 
+	if(!ss_layout_size || size < ss_layout_size) {
+		usrintf_showmessage("Error: Save file too small (%u bytes, %u expected)",
+							(unsigned)size, ss_layout_size);
+		goto bad;
+	}
+
 	if(memcmp(ss_dump_array, "MAMESAVE", 8)) {
 		usrintf_showmessage("Error: This is not a mame save file");
 		goto bad;
@@ -556,78 +633,48 @@ int state_save_load_begin(void *array, size_t size)
 			usrintf_showmessage("Warning: Game was saved with sound on, but sound is off.  Result may be interesting.");
 	}
 
-	offset = 0x18;
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next) {
-				e->offset = offset;
-				offset += ss_size[e->type]*e->size;
-			}
-		}
-	}
+#ifdef MSB_FIRST
+	ss_need_convert = (ss_dump_array[9] & SS_MSB_FIRST) == 0;
+#else
+	ss_need_convert = (ss_dump_array[9] & SS_MSB_FIRST) != 0;
+#endif
 	return 0;
 
  bad:
+	ss_dump_array = 0;
+	ss_dump_size = 0;
 	return 1;
 }
 
 int state_save_load_continue(void)
 {
-	ss_module *m;
-	ss_func * f;
-	int count = 0;
-	int need_convert;
-
-#ifdef MSB_FIRST
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) == 0;
-#else
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) != 0;
-#endif
+	const ss_record *r, *end;
 
 	TRACE(logerror("Loading tag %d\n", ss_current_tag));
-	TRACE(logerror("  copying data\n"));
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next)
-				if(e->tag == ss_current_tag) {
-					if(!e->data) {
-				    	ss_dump_array = 0;
-                    	ss_dump_size = 0;
-                    	return 1;
-				    }
-
-					if(e->type == SS_INT) {
-						int v;
-						v = ss_dump_array[e->offset]
-							| (ss_dump_array[e->offset+1] << 8)
-							| (ss_dump_array[e->offset+2] << 16)
-							| (ss_dump_array[e->offset+3] << 24);
-						TRACE(logerror("    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+3));
-						*(int *)(e->data) = v;
-					} else {
-						memcpy(e->data, ss_dump_array + e->offset, ss_size[e->type]*e->size);
-						if (need_convert && ss_conv[e->type])
-							ss_conv[e->type](e->data, e->size);
-						TRACE(logerror("    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+ss_size[e->type]*e->size-1));
-					}
-				}
+	if(!ss_dump_array)
+		return 1;
+
+	if(ss_current_tag >= 0 && ss_current_tag < ss_tag_count) {
+		TRACE(logerror("  copying data\n"));
+		r = ss_records + ss_tag_first[ss_current_tag];
+		end = ss_records + ss_tag_first[ss_current_tag + 1];
+		for(; r != end; r++) {
+			if(r->type == SS_INT) {
+				*(int *)(r->data) = ss_dump_array[r->offset]
+					| (ss_dump_array[r->offset+1] << 8)
+					| (ss_dump_array[r->offset+2] << 16)
+					| (ss_dump_array[r->offset+3] << 24);
+			} else {
+				memcpy(r->data, ss_dump_array + r->offset, r->bytes);
+				if (ss_need_convert && ss_conv[r->type])
+					ss_conv[r->type](r->data, r->count);
+			}
 		}
 	}
+
 	TRACE(logerror("  calling post-load functions\n"));
-	f = ss_postfunc_reg;
-	while(f) {
-		if(f->tag == ss_current_tag) {
-			count++;
-			(f->func)();
-		}
-		f = f->next;
-	}
-	TRACE(logerror("    %d functions called\n", count));
-	
+	ss_call_funcs(ss_postfunc_reg);
+
 	return 0;
 }
 
@@ -638,6 +685,19 @@ void state_save_load_finish(void)
 	ss_dump_size = 0;
 }
 
+int state_save_get_entry_count(void)
+{
+	if(!ss_layout_valid)
+		ss_build_layout();
+	return ss_layout_size ? ss_tag_first[ss_tag_count] : 0;
+}
+
+void state_save_get_entry_range(int index, unsigned *offset, unsigned *size)
+{
+	*offset = ss_records[index].offset;
+	*size = ss_records[index].bytes;
+}
+
 void state_save_dump_registry(void)
 {
 #ifdef VERBOSE
@@ -43,6 +43,10 @@ int state_save_load_continue(void);
 void state_save_save_finish(void);
 void state_save_load_finish(void);
 
+/* Frozen layout access, used by the rewind history */
+int  state_save_get_entry_count(void);
+void state_save_get_entry_range(int index, unsigned *offset, unsigned *size);
+
 /* Display function */
 void state_save_dump_registry(void);
 
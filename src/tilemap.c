@@ -21,6 +21,12 @@
 #include "tilemap.h"
 #include "state.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define SWAP(X,Y) { UINT32 temp=X; X=Y; Y=temp; }
 #define MAX_TILESIZE 64
 
@@ -80,6 +86,7 @@ struct tilemap
 	UINT8 *tile_dirty_map;
 	UINT8 all_tiles_dirty;
 	UINT8 all_tiles_clean;
+	UINT32 dirty_marks;	/* tiles newly marked dirty since the last draw */
 
 	/* cached color data */
 	struct mame_bitmap *pixmap;
@@ -100,7 +107,7 @@ UINT32					priority_bitmap_pitch_row;
 
 static struct tilemap *	first_tilemap; /* resource tracking */
 static UINT32			screen_width, screen_height;
-struct tile_info		tile_info;
+TILE_INFO_LOCAL struct tile_info	tile_info;
 
 static UINT32 g_mask32[32];
 
@@ -132,6 +139,8 @@ static void install_draw_handlers( struct tilemap *tilemap );
 static void tilemap_reset(void);
 
 static void update_tile_info( struct tilemap *tilemap, UINT32 cached_indx, UINT32 cached_col, UINT32 cached_row );
+static void refresh_tile( struct tilemap *tilemap, UINT32 cached_indx, UINT32 cached_col, UINT32 cached_row );
+static void refresh_dirty_tiles( struct tilemap *tilemap );
 
 /***********************************************************************************/
 
@@ -685,6 +694,387 @@ static void npbt32( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int
 
 /***********************************************************************************/
 
+/*
+	SIMD versions of the scanline blitters, eight pixels at a time.  The pen
+	lookups of the 32bpp ones stay scalar; the transparency test, the merge, the
+	priority update and the alpha blend work on whole vectors, and groups of
+	eight transparent pixels are skipped.  The rest of a line goes to the
+	scalar blitter, and so does a line whose mask or value does not fit a byte.
+*/
+
+#if defined(__SSE2__)
+#define TILEMAP_SIMD
+
+/* eight pixels, 0xff in the low half where the pixel is drawn */
+typedef __m128i simd_mask;
+
+static INLINE simd_mask simd_test( const UINT8 *pMask, int mask, int value )
+{
+	__m128i m = _mm_and_si128( _mm_loadl_epi64( (const __m128i *)pMask ), _mm_set1_epi8( (char)mask ) );
+	return _mm_cmpeq_epi8( m, _mm_set1_epi8( (char)value ) );
+}
+
+static INLINE simd_mask simd_opaque( void )
+{
+	return _mm_set1_epi8( -1 );
+}
+
+static INLINE int simd_none( simd_mask m )
+{
+	return (_mm_movemask_epi8( m ) & 0xff) == 0;
+}
+
+static INLINE void simd_pri( UINT8 *pri, simd_mask m, UINT32 pcode )
+{
+	__m128i p = _mm_loadl_epi64( (const __m128i *)pri );
+	_mm_storel_epi64( (__m128i *)pri, _mm_or_si128( p, _mm_and_si128( m, _mm_set1_epi8( (char)pcode ) ) ) );
+}
+
+static INLINE __m128i simd_select( __m128i m, __m128i s, __m128i d )
+{
+	return _mm_or_si128( _mm_and_si128( m, s ), _mm_andnot_si128( m, d ) );
+}
+
+/* dest = source + pal where the mask is set */
+static INLINE void simd_merge16( UINT16 *dest, const UINT16 *source, simd_mask m, int pal )
+{
+	__m128i s = _mm_add_epi16( _mm_loadu_si128( (const __m128i *)source ), _mm_set1_epi16( (short)pal ) );
+	__m128i d = _mm_loadu_si128( (const __m128i *)dest );
+	_mm_storeu_si128( (__m128i *)dest, simd_select( _mm_unpacklo_epi8( m, m ), s, d ) );
+}
+
+static INLINE void simd_merge32( UINT32 *dest, const UINT32 *pix, simd_mask m )
+{
+	__m128i w = _mm_unpacklo_epi8( m, m );
+	__m128i d0 = _mm_loadu_si128( (const __m128i *)dest );
+	__m128i d1 = _mm_loadu_si128( (const __m128i *)(dest+4) );
+	_mm_storeu_si128( (__m128i *)dest, simd_select( _mm_unpacklo_epi16( w, w ), _mm_loadu_si128( (const __m128i *)pix ), d0 ) );
+	_mm_storeu_si128( (__m128i *)(dest+4), simd_select( _mm_unpackhi_epi16( w, w ), _mm_loadu_si128( (const __m128i *)(pix+4) ), d1 ) );
+}
+
+/* alpha_blend32() on four pixels */
+static INLINE __m128i simd_blendvec32( __m128i d, __m128i s, __m128i fs, __m128i fd )
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), fs ), 8 ),
+			_mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), fd ), 8 ) );
+	__m128i hi = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), fs ), 8 ),
+			_mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), fd ), 8 ) );
+	return _mm_and_si128( _mm_packus_epi16( lo, hi ), _mm_set1_epi32( 0x00ffffff ) );
+}
+
+static INLINE void simd_blend32( UINT32 *dest, const UINT32 *pix, simd_mask m )
+{
+	__m128i fs = _mm_set1_epi16( (alpha_cache.alphas - alpha_cache.alpha[0]) >> 8 );
+	__m128i fd = _mm_set1_epi16( (alpha_cache.alphad - alpha_cache.alpha[0]) >> 8 );
+	__m128i w = _mm_unpacklo_epi8( m, m );
+	__m128i d0 = _mm_loadu_si128( (const __m128i *)dest );
+	__m128i d1 = _mm_loadu_si128( (const __m128i *)(dest+4) );
+	__m128i r0 = simd_blendvec32( d0, _mm_loadu_si128( (const __m128i *)pix ), fs, fd );
+	__m128i r1 = simd_blendvec32( d1, _mm_loadu_si128( (const __m128i *)(pix+4) ), fs, fd );
+	_mm_storeu_si128( (__m128i *)dest, simd_select( _mm_unpacklo_epi16( w, w ), r0, d0 ) );
+	_mm_storeu_si128( (__m128i *)(dest+4), simd_select( _mm_unpackhi_epi16( w, w ), r1, d1 ) );
+}
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TILEMAP_SIMD
+
+/* eight pixels, 0xff where the pixel is drawn */
+typedef uint8x8_t simd_mask;
+
+static INLINE simd_mask simd_test( const UINT8 *pMask, int mask, int value )
+{
+	return vceq_u8( vand_u8( vld1_u8( pMask ), vdup_n_u8( (UINT8)mask ) ), vdup_n_u8( (UINT8)value ) );
+}
+
+static INLINE simd_mask simd_opaque( void )
+{
+	return vdup_n_u8( 0xff );
+}
+
+static INLINE int simd_none( simd_mask m )
+{
+	return vget_lane_u64( vreinterpret_u64_u8( m ), 0 ) == 0;
+}
+
+static INLINE void simd_pri( UINT8 *pri, simd_mask m, UINT32 pcode )
+{
+	vst1_u8( pri, vorr_u8( vld1_u8( pri ), vand_u8( m, vdup_n_u8( (UINT8)pcode ) ) ) );
+}
+
+static INLINE uint16x8_t simd_widen16( simd_mask m )
+{
+	return vreinterpretq_u16_s16( vmovl_s8( vreinterpret_s8_u8( m ) ) );
+}
+
+static INLINE uint32x4_t simd_widen32( uint16x4_t w )
+{
+	return vreinterpretq_u32_s32( vmovl_s16( vreinterpret_s16_u16( w ) ) );
+}
+
+/* dest = source + pal where the mask is set */
+static INLINE void simd_merge16( UINT16 *dest, const UINT16 *source, simd_mask m, int pal )
+{
+	uint16x8_t s = vaddq_u16( vld1q_u16( source ), vdupq_n_u16( (UINT16)pal ) );
+	vst1q_u16( dest, vbslq_u16( simd_widen16( m ), s, vld1q_u16( dest ) ) );
+}
+
+static INLINE void simd_merge32( UINT32 *dest, const UINT32 *pix, simd_mask m )
+{
+	uint16x8_t w = simd_widen16( m );
+	vst1q_u32( dest, vbslq_u32( simd_widen32( vget_low_u16( w ) ), vld1q_u32( pix ), vld1q_u32( dest ) ) );
+	vst1q_u32( dest+4, vbslq_u32( simd_widen32( vget_high_u16( w ) ), vld1q_u32( pix+4 ), vld1q_u32( dest+4 ) ) );
+}
+
+/* alpha_blend32() on four pixels */
+static INLINE uint32x4_t simd_blendvec32( uint32x4_t d, uint32x4_t s, uint16x8_t fs, uint16x8_t fd )
+{
+	uint8x16_t sb = vreinterpretq_u8_u32( s ), db = vreinterpretq_u8_u32( d );
+	uint16x8_t lo = vaddq_u16( vshrq_n_u16( vmulq_u16( vmovl_u8( vget_low_u8( sb ) ), fs ), 8 ),
+			vshrq_n_u16( vmulq_u16( vmovl_u8( vget_low_u8( db ) ), fd ), 8 ) );
+	uint16x8_t hi = vaddq_u16( vshrq_n_u16( vmulq_u16( vmovl_u8( vget_high_u8( sb ) ), fs ), 8 ),
+			vshrq_n_u16( vmulq_u16( vmovl_u8( vget_high_u8( db ) ), fd ), 8 ) );
+	return vandq_u32( vreinterpretq_u32_u8( vcombine_u8( vmovn_u16( lo ), vmovn_u16( hi ) ) ), vdupq_n_u32( 0x00ffffff ) );
+}
+
+static INLINE void simd_blend32( UINT32 *dest, const UINT32 *pix, simd_mask m )
+{
+	uint16x8_t fs = vdupq_n_u16( (alpha_cache.alphas - alpha_cache.alpha[0]) >> 8 );
+	uint16x8_t fd = vdupq_n_u16( (alpha_cache.alphad - alpha_cache.alpha[0]) >> 8 );
+	uint16x8_t w = simd_widen16( m );
+	uint32x4_t d0 = vld1q_u32( dest ), d1 = vld1q_u32( dest+4 );
+	uint32x4_t r0 = simd_blendvec32( d0, vld1q_u32( pix ), fs, fd );
+	uint32x4_t r1 = simd_blendvec32( d1, vld1q_u32( pix+4 ), fs, fd );
+	vst1q_u32( dest, vbslq_u32( simd_widen32( vget_low_u16( w ) ), r0, d0 ) );
+	vst1q_u32( dest+4, vbslq_u32( simd_widen32( vget_high_u16( w ) ), r1, d1 ) );
+}
+#endif
+
+#ifdef TILEMAP_SIMD
+#define SIMD_BYTE_TEST(mask,value) ((((mask)|(value)) & ~0xff)==0)
+
+static void pdo16_simd( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i;
+	for( i=0; i+8<=count; i+=8 )
+	{
+		simd_merge16( &dest[i], &source[i], simd_opaque(), 0 );
+		simd_pri( &pri[i], simd_opaque(), pcode );
+	}
+	pdo16( dest+i, source+i, count-i, pri+i, pcode );
+}
+
+static void pdo16pal_simd( UINT16 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int pal = pcode >> 16;
+	int i;
+	for( i=0; i+8<=count; i+=8 )
+	{
+		simd_merge16( &dest[i], &source[i], simd_opaque(), pal );
+		simd_pri( &pri[i], simd_opaque(), pcode );
+	}
+	pdo16pal( dest+i, source+i, count-i, pri+i, pcode );
+}
+
+static void pdo32_simd( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	for( i=0; i+8<=count; i+=8 )
+	{
+		for( j=i; j<i+8; j++ )
+			dest[j] = clut[source[j]];
+		simd_pri( &pri[i], simd_opaque(), pcode );
+	}
+	pdo32( dest+i, source+i, count-i, pri+i, pcode );
+}
+
+static void pbo32_simd( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	for( i=0; i+8<=count; i+=8 )
+	{
+		for( j=0; j<8; j++ )
+			pix[j] = clut[source[i+j]];
+		simd_blend32( &dest[i], pix, simd_opaque() );
+		simd_pri( &pri[i], simd_opaque(), pcode );
+	}
+	pbo32( dest+i, source+i, count-i, pri+i, pcode );
+}
+
+static void npbo32_simd( UINT32 *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	for( i=0; i+8<=count; i+=8 )
+	{
+		for( j=0; j<8; j++ )
+			pix[j] = clut[source[i+j]];
+		simd_blend32( &dest[i], pix, simd_opaque() );
+	}
+	npbo32( dest+i, source+i, count-i, pri+i, pcode );
+}
+
+static void pdt16_simd( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0;
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			simd_merge16( &dest[i], &source[i], m, 0 );
+			simd_pri( &pri[i], m, pcode );
+		}
+	pdt16( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void pdt16pal_simd( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int pal = pcode >> 16;
+	int i = 0;
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			simd_merge16( &dest[i], &source[i], m, pal );
+			simd_pri( &pri[i], m, pcode );
+		}
+	pdt16pal( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void pdt16np_simd( UINT16 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0;
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			simd_merge16( &dest[i], &source[i], m, 0 );
+		}
+	pdt16np( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void pdt32_simd( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			for( j=0; j<8; j++ )
+				pix[j] = clut[source[i+j]];
+			simd_merge32( &dest[i], pix, m );
+			simd_pri( &pri[i], m, pcode );
+		}
+	pdt32( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void npdt32_simd( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			for( j=0; j<8; j++ )
+				pix[j] = clut[source[i+j]];
+			simd_merge32( &dest[i], pix, m );
+		}
+	npdt32( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void pbt32_simd( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			for( j=0; j<8; j++ )
+				pix[j] = clut[source[i+j]];
+			simd_blend32( &dest[i], pix, m );
+			simd_pri( &pri[i], m, pcode );
+		}
+	pbt32( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+
+static void npbt32_simd( UINT32 *dest, const UINT16 *source, const UINT8 *pMask, int mask, int value, int count, UINT8 *pri, UINT32 pcode )
+{
+	int i = 0, j;
+	pen_t *clut = &Machine->remapped_colortable[pcode >> 16];
+	UINT32 pix[8];
+	if( SIMD_BYTE_TEST(mask,value) )
+		for( ; i+8<=count; i+=8 )
+		{
+			simd_mask m = simd_test( &pMask[i], mask, value );
+			if( simd_none( m ) ) continue;
+			for( j=0; j<8; j++ )
+				pix[j] = clut[source[i+j]];
+			simd_blend32( &dest[i], pix, m );
+		}
+	npbt32( dest+i, source+i, pMask+i, mask, value, count-i, pri+i, pcode );
+}
+#endif /* TILEMAP_SIMD */
+
+/***********************************************************************************/
+
+/* the scanline blitters tilemap_draw picks from; scanline_select() fills it in */
+static struct
+{
+	blitopaque_t pdo16, pdo16pal, pdo32, pbo32, npbo32;
+	blitmask_t pdt16, pdt16pal, pdt16np, pdt32, npdt32, pbt32, npbt32;
+} scanline;
+
+/* pick the scanline blitters, the SIMD ones if the build has them; the
+   tilemaptest tool checks that they match the scalar ones bit for bit */
+static void scanline_select( void )
+{
+	scanline.pdo16    = (blitopaque_t)pdo16;
+	scanline.pdo16pal = (blitopaque_t)pdo16pal;
+	scanline.pdo32    = (blitopaque_t)pdo32;
+	scanline.pbo32    = (blitopaque_t)pbo32;
+	scanline.npbo32   = (blitopaque_t)npbo32;
+	scanline.pdt16    = (blitmask_t)pdt16;
+	scanline.pdt16pal = (blitmask_t)pdt16pal;
+	scanline.pdt16np  = (blitmask_t)pdt16np;
+	scanline.pdt32    = (blitmask_t)pdt32;
+	scanline.npdt32   = (blitmask_t)npdt32;
+	scanline.pbt32    = (blitmask_t)pbt32;
+	scanline.npbt32   = (blitmask_t)npbt32;
+
+#ifdef TILEMAP_SIMD
+	scanline.pdo16    = (blitopaque_t)pdo16_simd;
+	scanline.pdo16pal = (blitopaque_t)pdo16pal_simd;
+	scanline.pdo32    = (blitopaque_t)pdo32_simd;
+	scanline.pbo32    = (blitopaque_t)pbo32_simd;
+	scanline.npbo32   = (blitopaque_t)npbo32_simd;
+	scanline.pdt16    = (blitmask_t)pdt16_simd;
+	scanline.pdt16pal = (blitmask_t)pdt16pal_simd;
+	scanline.pdt16np  = (blitmask_t)pdt16np_simd;
+	scanline.pdt32    = (blitmask_t)pdt32_simd;
+	scanline.npdt32   = (blitmask_t)npdt32_simd;
+	scanline.pbt32    = (blitmask_t)pbt32_simd;
+	scanline.npbt32   = (blitmask_t)npbt32_simd;
+#endif
+}
+
+/***********************************************************************************/
+
 #define PAL_INIT const pen_t *pPalData = tile_info.pal_data
 #define PAL_GET(pen) pPalData[pen]
 #define TRANSP(f) f ## _ind
@@ -1576,6 +1966,117 @@ static INLINE tilemap_draw_func pick_draw_func( struct mame_bitmap *dest )
 }
 
 
+/***********************************************************************************/
+
+/*
+	Threaded refresh of the pixmap.  After a palette bank switch or
+	tilemap_mark_all_tiles_dirty, every tile of a layer is redrawn through its
+	tile_get_info callback and a HandleTransparency* routine on the next draw.
+	When enough tiles are dirty, and the driver declares its callbacks safe
+	to run concurrently with VIDEO_REENTRANT_TILE_INFO, the dirty tiles are
+	drawn up front by the workers instead, each taking every n-th row of
+	tiles.  Fewer dirty tiles are still drawn one by one as they scroll into
+	view.
+*/
+
+#ifdef TILEMAP_THREADS
+#define REFRESH_MAX_THREADS		8
+#define REFRESH_MIN_TILES		512
+
+static struct osd_thread *refresh_thread[REFRESH_MAX_THREADS];
+static int refresh_threads;		/* workers, not counting the thread drawing */
+
+struct refresh_slice
+{
+	struct tilemap *tilemap;
+	UINT32 first_row, row_step;
+};
+
+static void refresh_slice_run( void *param )
+{
+	struct refresh_slice *slice = param;
+	struct tilemap *tilemap = slice->tilemap;
+	UINT32 row, col, cached_indx;
+
+	memset( &tile_info, 0x00, sizeof(tile_info) ); /* this thread's defaults */
+	for( row=slice->first_row; row<tilemap->num_cached_rows; row+=slice->row_step )
+	{
+		cached_indx = row*tilemap->num_cached_cols;
+		for( col=0; col<tilemap->num_cached_cols; col++, cached_indx++ )
+		{
+			if( tilemap->transparency_data[cached_indx] == TILE_FLAG_DIRTY )
+			{
+				refresh_tile( tilemap, cached_indx, col, row );
+			}
+		}
+	}
+}
+
+static void refresh_start( void )
+{
+	int threads;
+
+	refresh_threads = 0;
+	if( !options.threaded_tilemaps )
+		return;
+	if( !(Machine->drv->video_attributes & VIDEO_REENTRANT_TILE_INFO) )
+	{
+		log_cb(RETRO_LOG_INFO, LOGPRE "Threaded tilemaps: not supported by this driver\n");
+		return;
+	}
+
+	threads = osd_num_processors();
+	if( threads > REFRESH_MAX_THREADS )
+		threads = REFRESH_MAX_THREADS;
+	while( refresh_threads < threads-1 )
+	{
+		refresh_thread[refresh_threads] = osd_thread_create();
+		if( !refresh_thread[refresh_threads] )
+			break;
+		refresh_threads++;
+	}
+	log_cb(RETRO_LOG_INFO, LOGPRE "Threaded tilemaps: %d worker threads\n", refresh_threads);
+}
+
+static void refresh_stop( void )
+{
+	while( refresh_threads )
+		osd_thread_destroy( refresh_thread[--refresh_threads] );
+}
+
+static void refresh_dirty_tiles( struct tilemap *tilemap )
+{
+	struct refresh_slice slice[REFRESH_MAX_THREADS];
+	int slices = refresh_threads+1;
+	int i;
+
+	if( refresh_threads==0 || tilemap->dirty_marks < REFRESH_MIN_TILES )
+	{
+		tilemap->dirty_marks = 0;
+		return;
+	}
+	tilemap->dirty_marks = 0;
+
+profiler_mark(PROFILER_TILEMAP_UPDATE);
+	for( i=0; i<slices; i++ )
+	{
+		slice[i].tilemap = tilemap;
+		slice[i].first_row = i;
+		slice[i].row_step = slices;
+	}
+	for( i=1; i<slices; i++ )
+		osd_thread_start( refresh_thread[i-1], refresh_slice_run, &slice[i] );
+	refresh_slice_run( &slice[0] );
+	for( i=1; i<slices; i++ )
+		osd_thread_wait( refresh_thread[i-1] );
+profiler_mark(PROFILER_END);
+}
+#else
+static void refresh_start( void ) { }
+static void refresh_stop( void ) { }
+static void refresh_dirty_tiles( struct tilemap *tilemap ) { tilemap->dirty_marks = 0; }
+#endif
+
 /***********************************************************************************/
 
 static void tilemap_reset(void)
@@ -1590,6 +2091,8 @@ int tilemap_init( void )
 	first_tilemap	= NULL;
 
 	state_save_register_func_postload(tilemap_reset);
+	scanline_select();
+	refresh_start();
 	priority_bitmap = bitmap_alloc_depth( screen_width, screen_height, -8 );
 	if( priority_bitmap )
 	{
@@ -1610,6 +2113,7 @@ void tilemap_close( void )
 		tilemap_dispose( first_tilemap );
 		first_tilemap = next;
 	}
+	refresh_stop();
 	bitmap_free( priority_bitmap );
 }
 
@@ -1693,6 +2197,7 @@ struct tilemap *tilemap_create(
 			install_draw_handlers( tilemap );
 			mappings_update( tilemap );
 			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, num_tiles );
+			tilemap->dirty_marks = num_tiles;
 			tilemap->next = first_tilemap;
 			first_tilemap = tilemap;
 			if( PenToPixel_Init( tilemap ) == 0 )
@@ -1809,6 +2314,8 @@ void tilemap_mark_tile_dirty( struct tilemap *tilemap, int memory_offset )
 		int cached_indx = tilemap->memory_offset_to_cached_indx[memory_offset];
 		if( cached_indx>=0 )
 		{
+			if( tilemap->transparency_data[cached_indx] != TILE_FLAG_DIRTY )
+				tilemap->dirty_marks++;
 			tilemap->transparency_data[cached_indx] = TILE_FLAG_DIRTY;
 			tilemap->all_tiles_clean = 0;
 		}
@@ -1830,20 +2337,27 @@ void tilemap_mark_all_tiles_dirty( struct tilemap *tilemap )
 	{
 		tilemap->all_tiles_dirty = 1;
 		tilemap->all_tiles_clean = 0;
+		tilemap->dirty_marks = tilemap->num_tiles;
 	}
 }
 
 /***********************************************************************************/
 
 static void update_tile_info( struct tilemap *tilemap, UINT32 cached_indx, UINT32 col, UINT32 row )
+{
+profiler_mark(PROFILER_TILEMAP_UPDATE);
+	refresh_tile( tilemap, cached_indx, col, row );
+profiler_mark(PROFILER_END);
+}
+
+/* draw one tile into the pixmap; may run on a worker, see refresh_dirty_tiles */
+static void refresh_tile( struct tilemap *tilemap, UINT32 cached_indx, UINT32 col, UINT32 row )
 {
 	UINT32 x0;
 	UINT32 y0;
 	UINT32 memory_offset;
 	UINT32 flags;
 
-profiler_mark(PROFILER_TILEMAP_UPDATE);
-
 	memory_offset = tilemap->cached_indx_to_memory_offset[cached_indx];
 	tilemap->tile_get_info( memory_offset );
 	flags = tile_info.flags;
@@ -1852,8 +2366,6 @@ profiler_mark(PROFILER_TILEMAP_UPDATE);
 	y0 = tilemap->cached_tile_height*row;
 
 	tilemap->transparency_data[cached_indx] = tilemap->draw_tile(tilemap,x0,y0,flags );
-
-profiler_mark(PROFILER_END);
 }
 
 struct mame_bitmap *tilemap_get_pixmap( struct tilemap * tilemap )
@@ -1871,6 +2383,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, tilemap->num_tiles );
 			tilemap->all_tiles_dirty = 0;
 		}
+		refresh_dirty_tiles( tilemap );
 
 		memset( &tile_info, 0x00, sizeof(tile_info) ); /* initialize defaults */
 
@@ -2088,6 +2601,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, tilemap->num_tiles );
 			tilemap->all_tiles_dirty = 0;
 		}
+		refresh_dirty_tiles( tilemap );
 
 		/* priority_bitmap_pitch_row is tilemap-specific */
 		priority_bitmap_pitch_row = priority_bitmap_pitch_line*tilemap->cached_tile_height;
@@ -2108,13 +2622,13 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 				{
 					if( flags&TILEMAP_ALPHA )
 					{
-						blit.draw_masked = (blitmask_t)pbt32;
-						blit.draw_opaque = (blitopaque_t)pbo32;
+						blit.draw_masked = scanline.pbt32;
+						blit.draw_opaque = scanline.pbo32;
 					}
 					else
 					{
-						blit.draw_masked = (blitmask_t)pdt32;
-						blit.draw_opaque = (blitopaque_t)pdo32;
+						blit.draw_masked = scanline.pdt32;
+						blit.draw_opaque = scanline.pdo32;
 					}
 				}
 				else
@@ -2122,12 +2636,12 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 					/** AAT APR2003: added 32-bit no-priority counterpart*/
 					if( flags&TILEMAP_ALPHA )
 					{
-						blit.draw_masked = (blitmask_t)npbt32;
-						blit.draw_opaque = (blitopaque_t)npbo32;
+						blit.draw_masked = scanline.npbt32;
+						blit.draw_opaque = scanline.npbo32;
 					}
 					else
 					{
-						blit.draw_masked = (blitmask_t)npdt32;
+						blit.draw_masked = scanline.npdt32;
 						blit.draw_opaque = (blitopaque_t)npdo32;
 					}
 				}
@@ -2150,17 +2664,17 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 			case 16:
 				if (tilemap->palette_offset)
 				{
-					blit.draw_masked = (blitmask_t)pdt16pal;
-					blit.draw_opaque = (blitopaque_t)pdo16pal;
+					blit.draw_masked = scanline.pdt16pal;
+					blit.draw_opaque = scanline.pdo16pal;
 				}
 				else if (priority)
 				{
-					blit.draw_masked = (blitmask_t)pdt16;
-					blit.draw_opaque = (blitopaque_t)pdo16;
+					blit.draw_masked = scanline.pdt16;
+					blit.draw_opaque = scanline.pdo16;
 				}
 				else
 				{
-					blit.draw_masked = (blitmask_t)pdt16np;
+					blit.draw_masked = scanline.pdt16np;
 					blit.draw_opaque = (blitopaque_t)pdo16np;
 				}
 				blit.screen_bitmap_pitch_line /= 2;
@@ -2474,7 +2988,7 @@ void tilemap_nb_draw( struct mame_bitmap *dest, UINT32 number, UINT32 scrollx, U
 	switch( dest->depth )
 	{
 	case 32:
-		blit.draw_opaque = (blitopaque_t)pdo32;
+		blit.draw_opaque = scanline.pdo32;
 		blit.screen_bitmap_pitch_line /= 4;
 		break;
 
@@ -2484,7 +2998,7 @@ void tilemap_nb_draw( struct mame_bitmap *dest, UINT32 number, UINT32 scrollx, U
 		break;
 
 	case 16:
-		blit.draw_opaque = (blitopaque_t)pdo16pal;
+		blit.draw_opaque = scanline.pdo16pal;
 		blit.screen_bitmap_pitch_line /= 2;
 		break;
 
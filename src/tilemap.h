@@ -39,7 +39,16 @@ struct tilemap; /* appease compiler */
 	available in alpha mode, ignore_transparency isn't.
 */
 
-extern struct tile_info
+/* tile_info is per thread when tiles may be refreshed on several threads */
+/* at once (see VIDEO_REENTRANT_TILE_INFO) */
+#if defined(HAVE_THREADS) && defined(__GNUC__)
+#define TILEMAP_THREADS
+#define TILE_INFO_LOCAL __thread __attribute__((tls_model("initial-exec")))
+#else
+#define TILE_INFO_LOCAL
+#endif
+
+extern TILE_INFO_LOCAL struct tile_info
 {
 	/*
 		you must set tile_info.pen_data, tile_info.pal_data and tile_info.pen_usage
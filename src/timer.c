@@ -28,6 +28,18 @@
 	  burn cycles, because the cores might need to adjust internal
 	  counters or timers.
 
+  Changes for mame2003-plus:
+	- times are kept as 64-bit integer picoseconds (mame_ticks) counted
+	  from an epoch that is moved forward every hour, so long sessions
+	  neither lose precision nor overflow; the double based API is
+	  converted at the boundary
+	- the active timers live in a binary heap ordered by expiration time
+	  and then by insertion order, replacing the sorted linked list; as
+	  times are absolute, advancing the global time no longer touches
+	  every timer
+	- optional statistics count how often each timer callback fires,
+	  collected once per frame by the scheduler statistics in cpuexec.c
+
 ***************************************************************************/
 
 #include "cpuintrf.h"
@@ -37,6 +49,17 @@
 
 #define MAX_TIMERS 256
 
+/* the epoch is moved forward by this much once the global time passes it */
+#define TICKS_PER_EPOCH ((mame_ticks)3600 * TICKS_PER_SEC)
+
+/* doubles at or beyond this many seconds are treated as TIME_NEVER */
+#define MAX_TIMER_SECONDS 9.0e6
+
+/* set to 1 to trace every timer through log_cb; compiled out otherwise */
+#define VERBOSE 0
+
+#define LOG(x)	do { if (VERBOSE) log_cb x; } while (0)
+
 
 
 /*-------------------------------------------------
@@ -45,16 +68,18 @@
 
 struct _mame_timer
 {
-	struct _mame_timer *next;
-	struct _mame_timer *prev;
+	struct _mame_timer *next;		/* free list link */
 	void (*callback)(int);
 	int callback_param;
 	int tag;
+	int heap_index;					/* position in the queue, -1 if not queued */
+	UINT32 sequence;				/* insertion order, breaks ties in the queue */
 	UINT8 enabled;
 	UINT8 temporary;
-	double period;
-	double start;
-	double expire;
+	mame_ticks period;
+	mame_ticks start;
+	mame_ticks expire;
+	mame_ticks when;				/* queue key: expire, or TICKS_NEVER if disabled */
 };
 
 
@@ -67,40 +92,81 @@ struct _mame_timer
 double cycles_to_sec[MAX_CPU];
 double sec_to_cycles[MAX_CPU];
 
-/* list of active timers */
+/* queue of active timers */
 static mame_timer timers[MAX_TIMERS];
-static mame_timer *timer_head;
+static mame_timer *timer_heap[MAX_TIMERS];
+static int timer_heap_count;
+static UINT32 timer_sequence;
 static mame_timer *timer_free_head;
 static mame_timer *timer_free_tail;
 
 /* other internal states */
-static double global_offset;
+static mame_ticks global_time;		/* start of the current timeslice, since the epoch */
+static double epoch_seconds;
 static mame_timer *callback_timer;
 static int callback_timer_modified;
-static double callback_timer_expire_time;
+static mame_ticks callback_timer_expire_time;
+
+/* statistics: distinct callbacks seen, the last slot collects the rest */
+static int stats_enabled;
+static int stats_callbacks;
+static void (*stats_callback[TIMER_STATS_CALLBACKS])(int);
+static UINT32 stats_fired[TIMER_STATS_CALLBACKS];
+
+
+
+/*-------------------------------------------------
+	time conversion helpers
+-------------------------------------------------*/
+
+static INLINE mame_ticks double_to_ticks(double time)
+{
+	if (time >= MAX_TIMER_SECONDS)
+		return TICKS_NEVER;
+	if (time <= -MAX_TIMER_SECONDS)
+		return -TICKS_NEVER;
+	return (mame_ticks)(time * (double)TICKS_PER_SEC + ((time < 0) ? -0.5 : 0.5));
+}
+
+static INLINE double ticks_to_double(mame_ticks ticks)
+{
+	if (ticks == TICKS_NEVER)
+		return TIME_NEVER;
+	return TICKS_TO_DOUBLE(ticks);
+}
+
+static INLINE mame_ticks ticks_add(mame_ticks time, mame_ticks delta)
+{
+	/* TICKS_NEVER is sticky */
+	if (time == TICKS_NEVER || delta == TICKS_NEVER)
+		return TICKS_NEVER;
+	if (delta > 0 && time > TICKS_NEVER - delta)
+		return TICKS_NEVER;
+	return time + delta;
+}
 
 
 
 /*-------------------------------------------------
-	get_relative_time - return the current time
-	relative to the global_offset
+	get_current_time - return the current time
+	since the epoch
 -------------------------------------------------*/
 
-static INLINE double get_relative_time(void)
+static INLINE mame_ticks get_current_time(void)
 {
 	int activecpu;
 
 	/* if we're executing as a particular CPU, use its local time as a base */
 	activecpu = cpu_getactivecpu();
 	if (activecpu >= 0)
-		return cpunum_get_localtime(activecpu);
-	
+		return global_time + cpunum_get_localtime(activecpu);
+
 	/* if we're currently in a callback, use the timer's expiration time as a base */
 	if (callback_timer)
 		return callback_timer_expire_time;
-	
-	/* otherwise, return 0 */
-	return 0;
+
+	/* otherwise, return the start of the timeslice */
+	return global_time;
 }
 
 
@@ -127,91 +193,110 @@ static INLINE mame_timer *timer_new(void)
 
 
 /*-------------------------------------------------
-	timer_list_insert - insert a new timer into
-	the list at the appropriate location
+	timer queue - a binary min-heap on (when,
+	sequence); entries with equal expiration
+	times fire in the order they were queued
 -------------------------------------------------*/
 
-static INLINE void timer_list_insert(mame_timer *timer)
+static INLINE int timer_before(const mame_timer *a, const mame_timer *b)
 {
-	double expire = timer->enabled ? timer->expire : TIME_NEVER;
-	mame_timer *t, *lt = NULL;
+	if (a->when != b->when)
+		return a->when < b->when;
+	return (INT32)(a->sequence - b->sequence) < 0;
+}
 
-	/* sanity checks for the debug build */
-	#ifdef MAME_DEBUG
-	{
-		int tnum = 0;
+static INLINE void timer_heap_set(int index, mame_timer *timer)
+{
+	timer_heap[index] = timer;
+	timer->heap_index = index;
+}
 
-		/* loop over the timer list */
-		for (t = timer_head; t; t = t->next, tnum++)
-		{
-			if (t == timer)
-				log_cb(RETRO_LOG_ERROR, LOGPRE "This timer is already inserted in the list!\n");
-			if (tnum == MAX_TIMERS-1)
-				log_cb(RETRO_LOG_ERROR, LOGPRE "Timer list is full!\n");
-		}
-	}
-	#endif
+static void timer_heap_up(int index)
+{
+	mame_timer *timer = timer_heap[index];
 
-	/* loop over the timer list */
-	for (t = timer_head; t; lt = t, t = t->next)
+	while (index > 0)
 	{
-		/* if the current list entry expires after us, we should be inserted before it */
-		/* note that due to floating point rounding, we need to allow a bit of slop here */
-		/* because two equal entries -- within rounding precision -- need to sort in */
-		/* the order they were inserted into the list */
-		if ((t->expire - expire) > TIME_IN_NSEC(1))
-		{
-			/* link the new guy in before the current list entry */
-			timer->prev = t->prev;
-			timer->next = t;
+		int parent = (index - 1) / 2;
+		if (!timer_before(timer, timer_heap[parent]))
+			break;
+		timer_heap_set(index, timer_heap[parent]);
+		index = parent;
+	}
+	timer_heap_set(index, timer);
+}
 
-			if (t->prev)
-				t->prev->next = timer;
-			else
-				timer_head = timer;
-			t->prev = timer;
-			return;
-		}
+static void timer_heap_down(int index)
+{
+	mame_timer *timer = timer_heap[index];
+
+	for (;;)
+	{
+		int child = index * 2 + 1;
+		if (child >= timer_heap_count)
+			break;
+		if (child + 1 < timer_heap_count && timer_before(timer_heap[child + 1], timer_heap[child]))
+			child++;
+		if (!timer_before(timer_heap[child], timer))
+			break;
+		timer_heap_set(index, timer_heap[child]);
+		index = child;
 	}
+	timer_heap_set(index, timer);
+}
 
-	/* need to insert after the last one */
-	if (lt)
-		lt->next = timer;
-	else
-		timer_head = timer;
-	timer->prev = lt;
-	timer->next = NULL;
+
+
+/*-------------------------------------------------
+	timer_list_insert - insert a new timer into
+	the queue at the appropriate location
+-------------------------------------------------*/
+
+static INLINE void timer_list_insert(mame_timer *timer)
+{
+	/* sanity checks for the debug build */
+	#ifdef MAME_DEBUG
+	if (timer->heap_index >= 0)
+		log_cb(RETRO_LOG_ERROR, LOGPRE "This timer is already inserted in the list!\n");
+	if (timer_heap_count >= MAX_TIMERS)
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Timer list is full!\n");
+	#endif
+
+	timer->when = timer->enabled ? timer->expire : TICKS_NEVER;
+	timer->sequence = timer_sequence++;
+	timer_heap_set(timer_heap_count++, timer);
+	timer_heap_up(timer->heap_index);
 }
 
 
 
 /*-------------------------------------------------
 	timer_list_remove - remove a timer from the
-	linked list
+	queue
 -------------------------------------------------*/
 
 static INLINE void timer_list_remove(mame_timer *timer)
 {
+	int index = timer->heap_index;
+	mame_timer *last;
+
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
-	{
-		mame_timer *t;
-		int tnum = 0;
-
-		/* loop over the timer list */
-		for (t = timer_head; t && t != timer; t = t->next, tnum++) ;
-		if (t == NULL)
-			printf ("timer not found in list");
-	}
+	if (index < 0 || index >= timer_heap_count || timer_heap[index] != timer)
+		printf ("timer not found in list");
 	#endif
 
-	/* remove it from the list */
-	if (timer->prev)
-		timer->prev->next = timer->next;
-	else
-		timer_head = timer->next;
-	if (timer->next)
-		timer->next->prev = timer->prev;
+	/* move the last entry into the hole and restore the heap order */
+	timer->heap_index = -1;
+	last = timer_heap[--timer_heap_count];
+	if (last != timer)
+	{
+		timer_heap_set(index, last);
+		if (index > 0 && timer_before(last, timer_heap[(index - 1) / 2]))
+			timer_heap_up(index);
+		else
+			timer_heap_down(index);
+	}
 }
 
 
@@ -225,22 +310,24 @@ void timer_init(void)
 	int i;
 
 	/* we need to wait until the first call to timer_cyclestorun before using real CPU times */
-	global_offset = 0.0;
+	global_time = 0;
+	epoch_seconds = 0.0;
 	callback_timer = NULL;
 	callback_timer_modified = 0;
 
 	/* reset the timers */
 	memset(timers, 0, sizeof(timers));
 
-	/* initialize the lists */
-	timer_head = NULL;
+	/* initialize the queue and the free list */
+	timer_heap_count = 0;
+	timer_sequence = 0;
 	timer_free_head = &timers[0];
-	for (i = 0; i < MAX_TIMERS-1; i++)
+	for (i = 0; i < MAX_TIMERS; i++)
 	{
 		timers[i].tag = -1;
-		timers[i].next = &timers[i+1];
+		timers[i].heap_index = -1;
+		timers[i].next = (i < MAX_TIMERS-1) ? &timers[i+1] : NULL;
 	}
-	timers[MAX_TIMERS-1].next = NULL;
 	timer_free_tail = &timers[MAX_TIMERS-1];
 }
 
@@ -254,31 +341,124 @@ void timer_init(void)
 void timer_free(void)
 {
 	int tag = get_resource_tag();
-	mame_timer *timer, *next;
+	int i;
+
+	/* scan the pool; removing never moves timers within it */
+	for (i = 0; i < MAX_TIMERS; i++)
+		if (timers[i].heap_index >= 0 && timers[i].tag == tag)
+			timer_remove(&timers[i]);
+}
+
+
+
+/*-------------------------------------------------
+	timer_time_until_next_timer - return the
+	amount of time until the next timer fires
+-------------------------------------------------*/
+
+mame_ticks timer_time_until_next_timer(void)
+{
+	mame_ticks expire = timer_heap[0]->when;
+	return (expire == TICKS_NEVER) ? TICKS_NEVER : expire - get_current_time();
+}
+
 
-	/* scan the list */
-	for (timer = timer_head; timer != NULL; timer = next)
+
+/*-------------------------------------------------
+	timer_rebase - move the epoch forward; every
+	timer moves by the same amount so the queue
+	order is unaffected
+-------------------------------------------------*/
+
+static void timer_rebase(void)
+{
+	int i;
+
+	global_time -= TICKS_PER_EPOCH;
+	epoch_seconds += (double)(TICKS_PER_EPOCH / TICKS_PER_SEC);
+
+	for (i = 0; i < MAX_TIMERS; i++)
 	{
-		/* prefetch the next timer in case we remove this one */
-		next = timer->next;
+		mame_timer *timer = &timers[i];
+
+		if (timer->heap_index < 0)
+			continue;
+		timer->start -= TICKS_PER_EPOCH;
+		if (timer->expire != TICKS_NEVER)
+			timer->expire -= TICKS_PER_EPOCH;
+		if (timer->when != TICKS_NEVER)
+			timer->when -= TICKS_PER_EPOCH;
+	}
+}
+
+
 
-		/* if this tag matches, remove it */
-		if (timer->tag == tag)
-			timer_remove(timer);
+/*-------------------------------------------------
+	timer_stats_count - count one firing of the
+	given callback
+-------------------------------------------------*/
+
+static void timer_stats_count(void (*callback)(int))
+{
+	int slot;
+
+	for (slot = 0; slot < stats_callbacks; slot++)
+		if (stats_callback[slot] == callback)
+			break;
+
+	if (slot == stats_callbacks)
+	{
+		if (stats_callbacks < TIMER_STATS_CALLBACKS - 1)
+			stats_callback[stats_callbacks++] = callback;
+		else
+			slot = TIMER_STATS_CALLBACKS - 1;
 	}
+	stats_fired[slot]++;
 }
 
 
 
 /*-------------------------------------------------
-	timer_time_until_next_timer - return the
-	amount of time until the next timer fires
+	timer_stats_enable - turn the callback counts
+	on or off; either way they start from scratch
+-------------------------------------------------*/
+
+void timer_stats_enable(int enable)
+{
+	stats_enabled = enable;
+	stats_callbacks = 0;
+	memset(stats_callback, 0, sizeof(stats_callback));
+	memset(stats_fired, 0, sizeof(stats_fired));
+}
+
+
+
+/*-------------------------------------------------
+	timer_stats_collect - hand over the counts
+	since the last call, one per callback slot,
+	and clear them
 -------------------------------------------------*/
 
-double timer_time_until_next_timer(void)
+void timer_stats_collect(UINT32 *fired)
 {
-	double time = get_relative_time();
-	return timer_head->expire - time;
+	memcpy(fired, stats_fired, sizeof(stats_fired));
+	memset(stats_fired, 0, sizeof(stats_fired));
+}
+
+
+
+/*-------------------------------------------------
+	timer_stats_callback - return the callback
+	counted in a slot; NULL for an unused slot
+	and for the last one, which collects the
+	callbacks that did not get a slot of their own
+-------------------------------------------------*/
+
+void (*timer_stats_callback(int slot))(int)
+{
+	if (slot < 0 || slot >= stats_callbacks)
+		return NULL;
+	return stats_callback[slot];
 }
 
 
@@ -288,29 +468,23 @@ double timer_time_until_next_timer(void)
 	time; this is also where we fire the timers
 -------------------------------------------------*/
 
-void timer_adjust_global_time(double delta)
+void timer_adjust_global_time(mame_ticks delta)
 {
 	mame_timer *timer;
 
-	/* add the delta to the global offset */
-	global_offset += delta;
+	/* advance the global time */
+	global_time += delta;
 
-	/* scan the list and adjust the times */
-	for (timer = timer_head; timer != NULL; timer = timer->next)
-	{
-		timer->start -= delta;
-		timer->expire -= delta;
-	}
-
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "timer_adjust_global_time: delta=%.9f head->expire=%.9f\n", delta, timer_head->expire);
+	LOG((RETRO_LOG_DEBUG, LOGPRE "timer_adjust_global_time: delta=%.9f head->expire=%.9f\n", ticks_to_double(delta), ticks_to_double(timer_heap[0]->when - global_time)));
 
 	/* now process any timers that are overdue */
-	while (timer_head->expire < TIME_IN_NSEC(1))
+	while (timer_heap[0]->when <= global_time)
 	{
-		int was_enabled = timer_head->enabled;
+		int was_enabled;
 
 		/* if this is a one-shot timer, disable it now */
-		timer = timer_head;
+		timer = timer_heap[0];
+		was_enabled = timer->enabled;
 		if (timer->period == 0)
 			timer->enabled = 0;
 
@@ -322,7 +496,9 @@ void timer_adjust_global_time(double delta)
 		/* call the callback */
 		if (was_enabled && timer->callback)
 		{
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "Timer %08X fired (expire=%.9f)\n", (UINT32)timer, timer->expire);
+			LOG((RETRO_LOG_DEBUG, LOGPRE "Timer %p fired (expire=%.9f)\n", (void *)timer, ticks_to_double(timer->expire - global_time)));
+			if (stats_enabled)
+				timer_stats_count(timer->callback);
 			profiler_mark(PROFILER_TIMER_CALLBACK);
 			(*timer->callback)(timer->callback_param);
 			profiler_mark(PROFILER_END);
@@ -342,13 +518,17 @@ void timer_adjust_global_time(double delta)
 			else
 			{
 				timer->start = timer->expire;
-				timer->expire += timer->period;
+				timer->expire = ticks_add(timer->expire, timer->period);
 
 				timer_list_remove(timer);
 				timer_list_insert(timer);
 			}
 		}
 	}
+
+	/* keep the integer times well away from overflow */
+	if (global_time >= TICKS_PER_EPOCH)
+		timer_rebase();
 }
 
 
@@ -360,7 +540,7 @@ void timer_adjust_global_time(double delta)
 
 mame_timer *timer_alloc(void (*callback)(int))
 {
-	double time = get_relative_time();
+	mame_ticks time = get_current_time();
 	mame_timer *timer = timer_new();
 
 	/* fail if we can't allocate a new entry */
@@ -377,7 +557,7 @@ mame_timer *timer_alloc(void (*callback)(int))
 
 	/* compute the time of the next firing and insert into the list */
 	timer->start = time;
-	timer->expire = TIME_NEVER;
+	timer->expire = TICKS_NEVER;
 	timer_list_insert(timer);
 
 	/* return a handle */
@@ -392,9 +572,9 @@ mame_timer *timer_alloc(void (*callback)(int))
 	fire periodically
 -------------------------------------------------*/
 
-void timer_adjust(mame_timer *which, double duration, int param, double period)
+static void timer_adjust_ticks(mame_timer *which, mame_ticks duration, int param, mame_ticks period)
 {
-	double time = get_relative_time();
+	mame_ticks time = get_current_time();
 
 	/* if this is the callback timer, mark it modified */
 	if (which == callback_timer)
@@ -406,7 +586,7 @@ void timer_adjust(mame_timer *which, double duration, int param, double period)
 
 	/* set the start and expire times */
 	which->start = time;
-	which->expire = time + duration;
+	which->expire = ticks_add(time, duration);
 	which->period = period;
 
 	/* remove and re-insert the timer in its new order */
@@ -414,11 +594,16 @@ void timer_adjust(mame_timer *which, double duration, int param, double period)
 	timer_list_insert(which);
 
 	/* if this was inserted as the head, abort the current timeslice and resync */
-  log_cb(RETRO_LOG_DEBUG, LOGPRE "timer_adjust %08X to expire @ %.9f\n", (UINT32)which, which->expire);
-	if (which == timer_head && cpu_getexecutingcpu() >= 0)
+  LOG((RETRO_LOG_DEBUG, LOGPRE "timer_adjust %p to expire @ %.9f\n", (void *)which, ticks_to_double(which->expire - global_time)));
+	if (which == timer_heap[0] && cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
 
+void timer_adjust(mame_timer *which, double duration, int param, double period)
+{
+	timer_adjust_ticks(which, double_to_ticks(duration), param, double_to_ticks(period));
+}
+
 
 
 /*-------------------------------------------------
@@ -470,7 +655,7 @@ void timer_set(double duration, int param, void (*callback)(int))
 void timer_reset(mame_timer *which, double duration)
 {
 	/* adjust the timer */
-	timer_adjust(which, duration, which->callback_param, which->period);
+	timer_adjust_ticks(which, double_to_ticks(duration), which->callback_param, which->period);
 }
 
 
@@ -533,8 +718,8 @@ int timer_enable(mame_timer *which, int enable)
 
 double timer_timeelapsed(mame_timer *which)
 {
-	double time = get_relative_time();
-	return time - which->start;
+	mame_ticks time = get_current_time();
+	return ticks_to_double(time - which->start);
 }
 
 
@@ -546,8 +731,10 @@ double timer_timeelapsed(mame_timer *which)
 
 double timer_timeleft(mame_timer *which)
 {
-	double time = get_relative_time();
-	return which->expire - time;
+	mame_ticks time = get_current_time();
+	if (which->expire == TICKS_NEVER)
+		return TIME_NEVER;
+	return ticks_to_double(which->expire - time);
 }
 
 
@@ -558,7 +745,7 @@ double timer_timeleft(mame_timer *which)
 
 double timer_get_time(void)
 {
-	return global_offset + get_relative_time();
+	return epoch_seconds + ticks_to_double(get_current_time());
 }
 
 
@@ -570,7 +757,7 @@ double timer_get_time(void)
 
 double timer_starttime(mame_timer *which)
 {
-	return global_offset + which->start;
+	return epoch_seconds + ticks_to_double(which->start);
 }
 
 
@@ -582,5 +769,7 @@ double timer_starttime(mame_timer *which)
 
 double timer_firetime(mame_timer *which)
 {
-	return global_offset + which->expire;
+	if (which->expire == TICKS_NEVER)
+		return TIME_NEVER;
+	return epoch_seconds + ticks_to_double(which->expire);
 }
@@ -29,13 +29,23 @@ extern double sec_to_cycles[];
 
 #define TIME_TO_CYCLES(cpu,t) ((int)((t) * sec_to_cycles[cpu]))
 
+/* internally the scheduler keeps time as 64-bit integer picoseconds */
+typedef INT64 mame_ticks;
+
+#define TICKS_PER_SEC         ((mame_ticks)1000000 * 1000000)
+#define TICKS_NEVER           ((mame_ticks)(((UINT64)0x7fffffff << 32) | 0xffffffff))
+#define TICKS_TO_DOUBLE(t)    ((double)(t) * (1.0 / (double)TICKS_PER_SEC))
+
 typedef struct _mame_timer mame_timer;
 
+/* callbacks told apart by the timer statistics; the last slot collects the rest */
+#define TIMER_STATS_CALLBACKS 16
+
 
 void timer_init(void);
 void timer_free(void);
-double timer_time_until_next_timer(void);
-void timer_adjust_global_time(double delta);
+mame_ticks timer_time_until_next_timer(void);
+void timer_adjust_global_time(mame_ticks delta);
 mame_timer *timer_alloc(void (*callback)(int));
 void timer_adjust(mame_timer *which, double duration, int param, double period);
 void timer_pulse(double period, int param, void (*callback)(int));
@@ -49,6 +59,10 @@ double timer_get_time(void);
 double timer_starttime(mame_timer *which);
 double timer_firetime(mame_timer *which);
 
+void timer_stats_enable(int enable);
+void timer_stats_collect(UINT32 *fired);
+void (*timer_stats_callback(int slot))(int);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,6 +19,14 @@
 static int gfx_bank;
 static int flipscreen;
 static int xoffsethack;
+
+/* what VIDEO_UPDATE( pengo ) draws: a copy of the video RAM and registers, */
+/* taken in video_eof when the frame is drawn on the video thread */
+static data8_t *latched_videoram, *latched_colorram, *latched_dirty;
+static data8_t latched_spriteram[0x10], latched_spriteram_2[0x10];
+static int latched_spriteram_size;
+static int latched_gfx_bank, latched_flipscreen;
+
 static struct tilemap *tilemap;
 data8_t *sprite_bank, *tiles_bankram;
 
@@ -151,12 +159,30 @@ PALETTE_INIT( pengo )
   Start the video hardware emulation.
 
 ***************************************************************************/
+static int pengo_latch_start(void)
+{
+	if (video_start_generic())
+		return 1;
+
+	latched_videoram = auto_malloc(videoram_size);
+	latched_colorram = auto_malloc(videoram_size);
+	latched_dirty = auto_malloc(videoram_size);
+	if (!latched_videoram || !latched_colorram || !latched_dirty)
+		return 1;
+	memset(latched_dirty, 1, videoram_size);
+
+	latched_spriteram_size = spriteram_size;
+	if (latched_spriteram_size > sizeof(latched_spriteram))
+		latched_spriteram_size = sizeof(latched_spriteram);
+	return 0;
+}
+
 VIDEO_START( pengo )
 {
 	gfx_bank = 0;
 	xoffsethack = 0;
 
-    return video_start_generic();
+	return pengo_latch_start();
 }
 
 VIDEO_START( pacman )
@@ -166,7 +192,7 @@ VIDEO_START( pacman )
 	/* one pixel to the left to get a more correct placement */
 	xoffsethack = 1;
 
-	return video_start_generic();
+	return pengo_latch_start();
 }
 
 
@@ -195,6 +221,43 @@ WRITE_HANDLER( pengo_flipscreen_w )
 
 
 
+/***************************************************************************
+
+  Copy the characters written since the last frame, the sprites and the
+  registers for VIDEO_UPDATE( pengo ). With threaded video this runs in
+  video_eof and the frame is drawn while the CPU moves on; otherwise it
+  runs at the start of video_update.
+
+***************************************************************************/
+static void pengo_latch(void)
+{
+	int offs;
+
+	for (offs = 0; offs < videoram_size; offs++)
+	{
+		if (dirtybuffer[offs])
+		{
+			dirtybuffer[offs] = 0;
+			latched_dirty[offs] = 1;
+			latched_videoram[offs] = videoram[offs];
+			latched_colorram[offs] = colorram[offs];
+		}
+	}
+
+	memcpy(latched_spriteram, spriteram, latched_spriteram_size);
+	memcpy(latched_spriteram_2, spriteram_2, latched_spriteram_size);
+	latched_gfx_bank = gfx_bank;
+	latched_flipscreen = flipscreen;
+}
+
+VIDEO_EOF( pengo )
+{
+	if (video_update_threaded())
+		pengo_latch();
+}
+
+
+
 /***************************************************************************
 
   Draw the game screen in the given mame_bitmap.
@@ -209,13 +272,16 @@ VIDEO_UPDATE( pengo )
 	
 	sect_rect(&spriteclip, cliprect);
 
+	if (!video_update_threaded())
+		pengo_latch();
+
 	for (offs = videoram_size - 1; offs > 0; offs--)
 	{
-		if (dirtybuffer[offs])
+		if (latched_dirty[offs])
 		{
 			int mx,my,sx,sy;
 
-			dirtybuffer[offs] = 0;
+			latched_dirty[offs] = 0;
             mx = offs % 32;
 			my = offs / 32;
 
@@ -237,16 +303,16 @@ VIDEO_UPDATE( pengo )
 				sy = my - 2;
 			}
 
-			if (flipscreen)
+			if (latched_flipscreen)
 			{
 				sx = 35 - sx;
 				sy = 27 - sy;
 			}
 
-			drawgfx(tmpbitmap,Machine->gfx[gfx_bank*2],
-					videoram[offs],
-					colorram[offs] & 0x1f,
-					flipscreen,flipscreen,
+			drawgfx(tmpbitmap,Machine->gfx[latched_gfx_bank*2],
+					latched_videoram[offs],
+					latched_colorram[offs] & 0x1f,
+					latched_flipscreen,latched_flipscreen,
 					sx*8,sy*8,
 					&Machine->visible_area,TRANSPARENCY_NONE,0);
         }
@@ -254,30 +320,30 @@ VIDEO_UPDATE( pengo )
 
 	copybitmap(bitmap,tmpbitmap,0,0,0,0,cliprect,TRANSPARENCY_NONE,0);
 
-	if( spriteram_size )
+	if( latched_spriteram_size )
 	{
 		/* Draw the sprites. Note that it is important to draw them exactly in this */
 		/* order, to have the correct priorities. */
-		for (offs = spriteram_size - 2;offs > 2*2;offs -= 2)
+		for (offs = latched_spriteram_size - 2;offs > 2*2;offs -= 2)
 		{
 			int sx,sy;
 
 
-			sx = 272 - spriteram_2[offs + 1];
-			sy = spriteram_2[offs] - 31;
+			sx = 272 - latched_spriteram_2[offs + 1];
+			sy = latched_spriteram_2[offs] - 31;
 
-			drawgfx(bitmap,Machine->gfx[gfx_bank*2+1],
-					spriteram[offs] >> 2,
-					spriteram[offs + 1] & 0x1f,
-					spriteram[offs] & 1,spriteram[offs] & 2,
+			drawgfx(bitmap,Machine->gfx[latched_gfx_bank*2+1],
+					latched_spriteram[offs] >> 2,
+					latched_spriteram[offs + 1] & 0x1f,
+					latched_spriteram[offs] & 1,latched_spriteram[offs] & 2,
 					sx,sy,
 					&spriteclip,TRANSPARENCY_COLOR,0);
 
 			/* also plot the sprite with wraparound (tunnel in Crush Roller) */
-			drawgfx(bitmap,Machine->gfx[gfx_bank*2+1],
-					spriteram[offs] >> 2,
-					spriteram[offs + 1] & 0x1f,
-					spriteram[offs] & 1,spriteram[offs] & 2,
+			drawgfx(bitmap,Machine->gfx[latched_gfx_bank*2+1],
+					latched_spriteram[offs] >> 2,
+					latched_spriteram[offs + 1] & 0x1f,
+					latched_spriteram[offs] & 1,latched_spriteram[offs] & 2,
 					sx - 256,sy,
 					&spriteclip,TRANSPARENCY_COLOR,0);
 		}
@@ -288,21 +354,21 @@ VIDEO_UPDATE( pengo )
 			int sx,sy;
 
 
-			sx = 272 - spriteram_2[offs + 1];
-			sy = spriteram_2[offs] - 31;
+			sx = 272 - latched_spriteram_2[offs + 1];
+			sy = latched_spriteram_2[offs] - 31;
 
-			drawgfx(bitmap,Machine->gfx[gfx_bank*2+1],
-					spriteram[offs] >> 2,
-					spriteram[offs + 1] & 0x1f,
-					spriteram[offs] & 1,spriteram[offs] & 2,
+			drawgfx(bitmap,Machine->gfx[latched_gfx_bank*2+1],
+					latched_spriteram[offs] >> 2,
+					latched_spriteram[offs + 1] & 0x1f,
+					latched_spriteram[offs] & 1,latched_spriteram[offs] & 2,
 					sx,sy + xoffsethack,
 					&spriteclip,TRANSPARENCY_COLOR,0);
 
 			/* also plot the sprite with wraparound (tunnel in Crush Roller) */
-			drawgfx(bitmap,Machine->gfx[gfx_bank*2+1],
-					spriteram[offs] >> 2,
-					spriteram[offs + 1] & 0x1f,
-					spriteram[offs] & 2,spriteram[offs] & 1,
+			drawgfx(bitmap,Machine->gfx[latched_gfx_bank*2+1],
+					latched_spriteram[offs] >> 2,
+					latched_spriteram[offs + 1] & 0x1f,
+					latched_spriteram[offs] & 2,latched_spriteram[offs] & 1,
 					sx - 256,sy + xoffsethack,
 					&spriteclip,TRANSPARENCY_COLOR,0);
 		}
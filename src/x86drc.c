@@ -8,9 +8,21 @@
 **
 **#################################################################################################*/
 
+/* anonymous mappings are outside the XOPEN feature set the core is built with */
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+
 #include "driver.h"
 #include "x86drc.h"
 
+#if (defined(__i386__) || defined(__x86_64__)) && !defined(_WIN32)
+#include <sys/mman.h>
+#define DRC_MMAP			1
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS		MAP_ANON
+#endif
+#endif
+
 #define LOG_DISPATCHES		0
 
 
@@ -21,6 +33,8 @@ const UINT8 scale_lookup[] = { 0,0,1,0,2,0,0,0,3 };
 static UINT16 fp_control[4] = { 0x23f, 0x63f, 0xa3f, 0xe3f };
 
 
+static void *alloc_code_memory(size_t size);
+static void free_code_memory(void *base, size_t size);
 static void append_entry_point(struct drccore *drc);
 static void append_recompile(struct drccore *drc);
 static void append_out_of_cycles(struct drccore *drc);
@@ -42,10 +56,11 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 {
 	int address_bits = config->address_bits;
 	int effective_address_bits = address_bits - config->lsbs_to_ignore;
+	size_t header = (sizeof(struct drccore) + 63) & ~63;
 	struct drccore *drc;
 
-	/* allocate memory */
-	drc = malloc(sizeof(*drc));
+	/* allocate memory; the structure goes in front of the cache so the generated code can address it */
+	drc = alloc_code_memory(header + config->cache_size);
 	if (!drc)
 		return NULL;
 	memset(drc, 0, sizeof(*drc));
@@ -61,10 +76,8 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 	drc->uses_sse     = config->uses_sse;
 	drc->fpcw_curr    = fp_control[0];
 
-	/* allocate cache */
-	drc->cache_base = malloc(config->cache_size);
-	if (!drc->cache_base)
-		return NULL;
+	/* the cache follows */
+	drc->cache_base = (UINT8 *)drc + header;
 	drc->cache_end = drc->cache_base + config->cache_size;
 	drc->cache_danger = drc->cache_end - 65536;
 
@@ -73,7 +86,7 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 	drc->l2bits = effective_address_bits - drc->l1bits;
 	drc->l1shift = config->lsbs_to_ignore + drc->l2bits;
 	drc->l2mask = ((1 << drc->l2bits) - 1) << config->lsbs_to_ignore;
-	drc->l2scale = 4 >> config->lsbs_to_ignore;
+	drc->l2scale = sizeof(void *) >> config->lsbs_to_ignore;
 
 	/* allocate lookup tables */
 	drc->lookup_l1 = malloc(sizeof(*drc->lookup_l1) * (1 << drc->l1bits));
@@ -158,10 +171,6 @@ void drc_exit(struct drccore *drc)
 {
 	int i;
 
-	/* free the cache */
-	if (drc->cache_base)
-		free(drc->cache_base);
-
 	/* free all the l2 tables allocated */
 	for (i = 0; i < (1 << drc->l1bits); i++)
 		if (drc->lookup_l1[i] != drc->lookup_l2_recompile)
@@ -181,8 +190,8 @@ void drc_exit(struct drccore *drc)
 	if (drc->tentative_list)
 		free(drc->tentative_list);
 
-	/* and the drc itself */
-	free(drc);
+	/* and the drc itself, along with the cache */
+	free_code_memory(drc, drc->cache_end - (UINT8 *)drc);
 }
 
 
@@ -193,7 +202,7 @@ void drc_exit(struct drccore *drc)
 void drc_begin_sequence(struct drccore *drc, UINT32 pc)
 {
 	UINT32 l1index = pc >> drc->l1shift;
-	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / 4;
+	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / sizeof(void *);
 
 	/* reset the sequence and tentative counts */
 	drc->sequence_count = 0;
@@ -269,7 +278,7 @@ void drc_register_code_at_cache_top(struct drccore *drc, UINT32 pc)
 void *drc_get_code_at_pc(struct drccore *drc, UINT32 pc)
 {
 	UINT32 l1index = pc >> drc->l1shift;
-	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / 4;
+	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / sizeof(void *);
 	return (drc->lookup_l1[l1index][l2index] != drc->recompile) ? drc->lookup_l1[l1index][l2index] : NULL;
 }
 
@@ -280,6 +289,20 @@ void *drc_get_code_at_pc(struct drccore *drc, UINT32 pc)
 
 void drc_append_verify_code(struct drccore *drc, void *code, UINT8 length)
 {
+#ifdef X86DRC_X64
+	if (!drc_can_address(drc, code))
+	{
+		_mov_r64_imm(REG_R11, code);								/* mov	r11,pc*/
+		if (length >= 4)
+			_cmp_m32r11_imm(*(UINT32 *)code);						/* cmp	[r11],opcode*/
+		else if (length >= 2)
+			_cmp_m16r11_imm(*(UINT16 *)code);						/* cmp	[r11],opcode*/
+		else
+			_cmp_m8r11_imm(*(UINT8 *)code);							/* cmp	[r11],opcode*/
+		_jcc(COND_NE, drc->recompile);								/* jne	recompile*/
+		return;
+	}
+#endif
 	if (length >= 4)
 	{
 		_cmp_m32abs_imm(code, *(UINT32 *)code);						/* cmp	[pc],opcode*/
@@ -386,7 +409,12 @@ void drc_append_dispatcher(struct drccore *drc)
 	_mov_r32_r32(REG_EAX, REG_EDI);									/* mov	eax,edi*/
 	_shr_r32_imm(REG_EAX, drc->l1shift);							/* shr	eax,l1shift*/
 	_mov_r32_r32(REG_EDX, REG_EDI);									/* mov	edx,edi*/
+#ifdef X86DRC_X64
+	_mov_r64_imm(REG_R11, drc->lookup_l1);							/* mov	r11,l1lookup*/
+	_mov_r64_m64bisd(REG_EAX, REG_R11, REG_EAX, 8, 0);				/* mov	rax,[r11 + rax*8]*/
+#else
 	_mov_r32_m32isd(REG_EAX, REG_EAX, 4, drc->lookup_l1);			/* mov	eax,[eax*4 + l1lookup]*/
+#endif
 	_and_r32_imm(REG_EDX, drc->l2mask);								/* and	edx,l2mask*/
 	_jmp_m32bisd(REG_EAX, REG_EDX, drc->l2scale, 0);				/* jmp	[eax+edx*l2scale]*/
 }
@@ -399,6 +427,19 @@ void drc_append_dispatcher(struct drccore *drc)
 void drc_append_fixed_dispatcher(struct drccore *drc, UINT32 newpc)
 {
 	void **base = drc->lookup_l1[newpc >> drc->l1shift];
+#ifdef X86DRC_X64
+	if (base == drc->lookup_l2_recompile)
+	{
+		_mov_r64_imm(REG_EAX, &drc->lookup_l1[newpc >> drc->l1shift]);	/* mov	rax,&l1lookup[newpc >> l1shift]*/
+		_mov_r64_m64bd(REG_EAX, REG_EAX, 0);							/* mov	rax,[rax]*/
+		_jmp_m32bd(REG_EAX, (newpc & drc->l2mask) * drc->l2scale);		/* jmp	[rax+(newpc & l2mask)*l2scale]*/
+	}
+	else
+	{
+		_mov_r64_imm(REG_EAX, (UINT8 *)base + (newpc & drc->l2mask) * drc->l2scale);/* mov	rax,&l2lookup[newpc & l2mask]*/
+		_jmp_m32bd(REG_EAX, 0);											/* jmp	[rax]*/
+	}
+#else
 	if (base == drc->lookup_l2_recompile)
 	{
 		_mov_r32_m32abs(REG_EAX, &drc->lookup_l1[newpc >> drc->l1shift]);/* mov	eax,[(newpc >> l1shift)*4 + l1lookup]*/
@@ -406,6 +447,7 @@ void drc_append_fixed_dispatcher(struct drccore *drc, UINT32 newpc)
 	}
 	else
 		_jmp_m32abs((UINT8 *)base + (newpc & drc->l2mask) * drc->l2scale);	/* jmp	[eax+(newpc & l2mask)*l2scale]*/
+#endif
 }
 
 
@@ -461,6 +503,71 @@ void drc_append_restore_fp_rounding(struct drccore *drc)
 
 
 
+/*------------------------------------------------------------------
+	drc_can_address
+------------------------------------------------------------------*/
+
+int drc_can_address(struct drccore *drc, const void *ptr)
+{
+#ifdef X86DRC_X64
+	INT64 lo = (const UINT8 *)ptr - (const UINT8 *)drc;
+	INT64 hi = (const UINT8 *)ptr - drc->cache_end;
+	return (lo == (INT32)lo && hi == (INT32)hi);
+#else
+	return 1;
+#endif
+}
+
+
+
+#ifdef X86DRC_X64
+/*------------------------------------------------------------------
+	drc_append_call
+
+	Generated code pushes arguments in 4-byte slots as on 32-bit
+	x86; they are loaded into the System V argument registers here,
+	with param (if any) replacing the first one. The stack pointer
+	and ESI/EDI live in callee-saved registers across the call, and
+	a 64-bit result is returned in EDX:EAX as well.
+------------------------------------------------------------------*/
+
+void drc_append_call(struct drccore *drc, void *target, void *param)
+{
+	INT64 delta;
+
+	_mov_r64_r64(REG_R12, REG_ESP);									/* mov	r12,rsp*/
+	_mov_r64_r64(REG_R13, REG_ESI);									/* mov	r13,rsi*/
+	_mov_r64_r64(REG_R14, REG_EDI);									/* mov	r14,rdi*/
+	if (param)
+		_mov_r64_imm(REG_EDI, param);								/* mov	rdi,param*/
+	else
+		_mov_r32_m32bd(REG_EDI, REG_ESP, 0);						/* mov	edi,[rsp]*/
+	_mov_r32_m32bd(REG_ESI, REG_ESP, 4);							/* mov	esi,[rsp+4]*/
+	_mov_r32_m32bd(REG_EDX, REG_ESP, 8);							/* mov	edx,[rsp+8]*/
+	_mov_r32_m32bd(REG_ECX, REG_ESP, 12);							/* mov	ecx,[rsp+12]*/
+	_and_r64_imm8(REG_ESP, -16);									/* and	rsp,-16*/
+
+	delta = (UINT8 *)target - (drc->cache_top + 5);
+	if (delta == (INT32)delta)
+	{
+		OP1(0xe8); OP4(delta);										/* call	target*/
+	}
+	else
+	{
+		_mov_r64_imm(REG_EAX, target);								/* mov	rax,target*/
+		_call_r64(REG_EAX);											/* call	rax*/
+	}
+
+	_mov_r64_r64(REG_ESP, REG_R12);									/* mov	rsp,r12*/
+	_mov_r64_r64(REG_ESI, REG_R13);									/* mov	rsi,r13*/
+	_mov_r64_r64(REG_EDI, REG_R14);									/* mov	rdi,r14*/
+	_mov_r64_r64(REG_EDX, REG_EAX);									/* mov	rdx,rax*/
+	_shr_r64_imm(REG_EDX, 32);										/* shr	rdx,32*/
+}
+#endif
+
+
+
 /*------------------------------------------------------------------
 	drc_dasm
 
@@ -525,13 +632,86 @@ void drc_dasm(FILE *f, unsigned pc, void *begin, void *end)
 **	INTERNAL CODEGEN
 **#################################################################################################*/
 
+/*------------------------------------------------------------------
+	alloc_code_memory
+
+	The cache must be executable. On x86-64 the generated code reaches
+	the core's own data with rel32 calls and RIP-relative disp32
+	operands, which span +/-2GB. The cache is placed within 1GB of
+	fp_control, so that every reference from anywhere in the cache to
+	anywhere in the core's data stays inside that span; free ranges
+	around it are tried in turn.
+------------------------------------------------------------------*/
+
+static void *alloc_code_memory(size_t size)
+{
+#ifdef DRC_MMAP
+	void *base;
+#ifdef X86DRC_X64
+	const UINT64 reach = 0x40000000;
+	UINT64 near = (FPTR)fp_control & ~(UINT64)0xffff;
+	UINT64 dist;
+	int below;
+
+	for (dist = 0; dist + size < reach; dist += 0x1000000)
+		for (below = 0; below < 2; below++)
+		{
+			UINT64 hint = below ? near - dist - size : near + dist;
+			INT64 lo, hi;
+
+			if (below && near < dist + size)
+				continue;
+			base = mmap((void *)(FPTR)hint, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (base == MAP_FAILED)
+				continue;
+
+			lo = (INT64)((FPTR)base - near);
+			hi = lo + (INT64)size;
+			if (lo > -(INT64)reach && hi < (INT64)reach)
+				return base;
+			munmap(base, size);
+		}
+	log_cb(RETRO_LOG_ERROR, LOGPRE "drc_init: unable to allocate the cache near the core\n");
+	return NULL;
+#else
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return (base != MAP_FAILED) ? base : NULL;
+#endif
+#else
+	return malloc(size);
+#endif
+}
+
+
+/*------------------------------------------------------------------
+	free_code_memory
+------------------------------------------------------------------*/
+
+static void free_code_memory(void *base, size_t size)
+{
+#ifdef DRC_MMAP
+	munmap(base, size);
+#else
+	free(base);
+#endif
+}
+
+
 /*------------------------------------------------------------------
 	append_entry_point
 ------------------------------------------------------------------*/
 
 static void append_entry_point(struct drccore *drc)
 {
+#ifdef X86DRC_X64
+	_push_r64(REG_EBX);												/* push	rbx*/
+	_push_r64(REG_EBP);												/* push	rbp*/
+	_push_r64(REG_R12);												/* push	r12*/
+	_push_r64(REG_R13);												/* push	r13*/
+	_push_r64(REG_R14);												/* push	r14*/
+#else
 	_pushad();														/* pushad*/
+#endif
 	if (drc->uses_fp)
 	{
 		_fnstcw_m16abs(&drc->fpcw_save);							/* fstcw [fpcw_save]*/
@@ -562,8 +742,14 @@ static void recompile_code(struct drccore *drc)
 
 static void append_recompile(struct drccore *drc)
 {
+#ifdef X86DRC_X64
+	drc_append_save_volatiles(drc);									/* save volatiles*/
+	drc_append_call(drc, (void *)recompile_code, drc);				/* call	recompile_code*/
+	drc_append_restore_volatiles(drc);								/* restore volatiles*/
+#else
 	_push_imm(drc);													/* push	drc*/
 	drc_append_save_call_restore(drc, (void *)recompile_code, 4);	/* call	recompile_code*/
+#endif
 	drc_append_dispatcher(drc);										/* dispatch*/
 }
 
@@ -580,7 +766,15 @@ static void append_out_of_cycles(struct drccore *drc)
 		_fnclex();													/* fnclex*/
 		_fldcw_m16abs(&drc->fpcw_save);								/* fldcw [fpcw_save]*/
 	}
+#ifdef X86DRC_X64
+	_pop_r64(REG_R14);												/* pop	r14*/
+	_pop_r64(REG_R13);												/* pop	r13*/
+	_pop_r64(REG_R12);												/* pop	r12*/
+	_pop_r64(REG_EBP);												/* pop	rbp*/
+	_pop_r64(REG_EBX);												/* pop	rbx*/
+#else
 	_popad();														/* popad*/
+#endif
 	_ret();															/* ret*/
 }
 
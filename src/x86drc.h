@@ -12,6 +12,16 @@
 #define __DRCCORE_H__
 
 
+/* on x86-64 the same emitters produce 64-bit code: 32-bit operations are
+   unchanged, absolute addresses become RIP-relative (so the cache is placed
+   within 1GB of the core's data, which keeps every rel32/disp32 reference
+   inside +/-2GB), arguments still go in 4-byte stack slots, and _call()
+   moves them into System V argument registers */
+#if defined(__x86_64__) || defined(_M_X64)
+#define X86DRC_X64			1
+#endif
+
+
 /*###################################################################################################
 **	TYPE DEFINITIONS
 **#################################################################################################*/
@@ -138,6 +148,17 @@ extern const UINT8 scale_lookup[];
 #define REG_DH		6
 #define REG_BH		7
 
+#ifdef X86DRC_X64
+#define REG_R8		8
+#define REG_R9		9
+#define REG_R10		10
+#define REG_R11		11				/* scratch for far addresses; never holds state */
+#define REG_R12		12				/* the registers below are used by the _call() glue */
+#define REG_R13		13
+#define REG_R14		14
+#define REG_R15		15
+#endif
+
 #define REG_XMM0	0
 #define REG_XMM1	1
 #define REG_XMM2	2
@@ -197,6 +218,11 @@ extern const UINT8 scale_lookup[];
 #define OP1(x)		do { *drc->cache_top++ = (UINT8)(x); } while (0)
 #define OP2(x)		do { *(UINT16 *)drc->cache_top = (UINT16)(x); drc->cache_top += 2; } while (0)
 #define OP4(x)		do { *(UINT32 *)drc->cache_top = (UINT32)(x); drc->cache_top += 4; } while (0)
+#define OP8(x)		do { *(UINT64 *)drc->cache_top = (UINT64)(x); drc->cache_top += 8; } while (0)
+
+/* REX prefix for 64-bit operand size and/or registers r8-r15 */
+#define OP_REX(w, reg, indx, base) \
+do { OP1(0x40 | ((w) << 3) | (((reg) >> 1) & 4) | (((indx) >> 2) & 2) | (((base) >> 3) & 1)); } while (0)
 
 
 
@@ -208,9 +234,17 @@ extern const UINT8 scale_lookup[];
 #define MODRM_REG(reg, rm) 		\
 do { OP1(0xc0 | (((reg) & 7) << 3) | ((rm) & 7)); } while (0)
 
-/* op  reg,[addr]*/
-#define MODRM_MABS(reg, addr)	\
+/* op  reg,[addr]; immsize is the number of immediate bytes following the address */
+#ifdef X86DRC_X64
+#define MODRM_MABS_IMM(reg, addr, immsize)	\
+do { OP1(0x05 | (((reg) & 7) << 3)); OP4((UINT8 *)(addr) - (drc->cache_top + 4 + (immsize))); } while (0)
+#else
+#define MODRM_MABS_IMM(reg, addr, immsize)	\
 do { OP1(0x05 | (((reg) & 7) << 3)); OP4(addr); } while (0)
+#endif
+
+#define MODRM_MABS(reg, addr)	\
+do { MODRM_MABS_IMM(reg, addr, 0); } while (0)
 
 /* op  reg,[base+disp]*/
 #define MODRM_MBD(reg, base, disp) \
@@ -283,6 +317,11 @@ do {														\
 #define _pushad() \
 do { OP1(0x60); } while (0)
 
+#define _popad() \
+do { OP1(0x61); } while (0)
+
+#ifndef X86DRC_X64
+
 #define _push_r32(reg) \
 do { OP1(0x50+(reg)); } while (0)
 
@@ -292,15 +331,38 @@ do { OP1(0x68); OP4(imm); } while (0)
 #define _push_m32abs(addr) \
 do { OP1(0xff); MODRM_MABS(6, addr); } while (0)
 
-#define _popad() \
-do { OP1(0x61); } while (0)
-
 #define _pop_r32(reg) \
 do { OP1(0x58+(reg)); } while (0)
 
 #define _pop_m32abs(addr) \
 do { OP1(0x8f); MODRM_MABS(0, addr); } while (0)
 
+#else
+
+/* 4-byte stack slots, built with lea so the flags are preserved like push/pop */
+#define _lea_rsp_imm(imm) \
+do { OP1(0x48); OP1(0x8d); OP1(0x64); OP1(0x24); OP1(imm); } while (0)
+
+#define _push_r32(reg) \
+do { _lea_rsp_imm(-4); OP1(0x89); MODRM_MBD(reg, REG_ESP, 0); } while (0)
+
+#define _push_imm(imm) \
+do { _lea_rsp_imm(-4); OP1(0xc7); MODRM_MBD(0, REG_ESP, 0); OP4(imm); } while (0)
+
+#define _push_m32abs(addr) \
+do { OP_REX(0, REG_R11, 0, 0); OP1(0x8b); MODRM_MABS(REG_R11, addr); _push_r64_low(REG_R11); } while (0)
+
+#define _push_r64_low(reg) \
+do { _lea_rsp_imm(-4); OP_REX(0, reg, 0, 0); OP1(0x89); MODRM_MBD(reg, REG_ESP, 0); } while (0)
+
+#define _pop_r32(reg) \
+do { OP1(0x8b); MODRM_MBD(reg, REG_ESP, 0); _lea_rsp_imm(4); } while (0)
+
+#define _pop_m32abs(addr) \
+do { OP_REX(0, REG_R11, 0, 0); OP1(0x8b); MODRM_MBD(REG_R11, REG_ESP, 0); OP_REX(0, REG_R11, 0, 0); OP1(0x89); MODRM_MABS(REG_R11, addr); _lea_rsp_imm(4); } while (0)
+
+#endif
+
 #define _ret() \
 do { OP1(0xc3); } while (0)
 
@@ -380,7 +442,7 @@ do { OP1(0x8b); MODRM_MBISD(dreg, base, indx, scale, disp); } while (0)
 
 
 #define _mov_m8abs_imm(addr, imm) \
-do { OP1(0xc6); MODRM_MABS(0, addr); OP1(imm); } while (0)
+do { OP1(0xc6); MODRM_MABS_IMM(0, addr, 1); OP1(imm); } while (0)
 
 #define _mov_m8abs_r8(addr, sreg) \
 do { OP1(0x88); MODRM_MABS(sreg, addr); } while (0)
@@ -397,7 +459,7 @@ do { OP1(0x88); MODRM_MBISD(sreg, base, indx, scale, disp); } while (0)
 
 
 #define _mov_m16abs_imm(addr, imm) \
-do { OP1(0x66); OP1(0xc7); MODRM_MABS(0, addr); OP2(imm); } while (0)
+do { OP1(0x66); OP1(0xc7); MODRM_MABS_IMM(0, addr, 2); OP2(imm); } while (0)
 
 #define _mov_m16abs_r16(addr, sreg) \
 do { OP1(0x66); OP1(0x89); MODRM_MABS(sreg, addr); } while (0)
@@ -409,7 +471,7 @@ do { OP1(0x66); OP1(0x89); MODRM_MBD(sreg, base, disp); } while (0)
 
 
 #define _mov_m32abs_imm(addr, imm) \
-do { OP1(0xc7); MODRM_MABS(0, addr); OP4(imm); } while (0)
+do { OP1(0xc7); MODRM_MABS_IMM(0, addr, 4); OP4(imm); } while (0)
 
 #define _mov_m32bisd_imm(base, indx, scale, addr, imm) \
 do { OP1(0xc7); MODRM_MBISD(0, base, indx, scale, addr); OP4(imm); } while (0)
@@ -587,8 +649,18 @@ do { OP1(0x33); MODRM_MABS(dreg, addr); } while (0)
 
 
 
+#ifdef X86DRC_X64
+/* arithmetic on ESP always adjusts the full 64-bit stack pointer */
+#define REX_W_IF_ESP(reg) \
+do { if ((reg) == REG_ESP) OP1(0x48); } while (0)
+#else
+#define REX_W_IF_ESP(reg) \
+do { } while (0)
+#endif
+
 #define _arith_r32_imm_common(reg, dreg, imm)		\
 do {												\
+	REX_W_IF_ESP(dreg);								\
 	if ((INT8)(imm) == (INT32)(imm))				\
 	{												\
 		OP1(0x83); MODRM_REG(reg, dreg); OP1(imm);	\
@@ -636,11 +708,11 @@ do { OP1(0x23); MODRM_REG(dreg, sreg); } while (0)
 do {												\
 	if ((INT8)(imm) == (INT32)(imm))				\
 	{												\
-		OP1(0x83); MODRM_MABS(reg, addr); OP1(imm);	\
+		OP1(0x83); MODRM_MABS_IMM(reg, addr, 1); OP1(imm);	\
 	}												\
 	else											\
 	{												\
-		OP1(0x81); MODRM_MABS(reg, addr); OP4(imm);	\
+		OP1(0x81); MODRM_MABS_IMM(reg, addr, 4); OP4(imm);	\
 	}												\
 } while (0)
 
@@ -669,7 +741,7 @@ do { _arith_m32abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m32abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m32abs_imm(addr, imm) \
-do { OP1(0xf7); MODRM_MABS(0, addr); OP4(imm); } while (0)
+do { OP1(0xf7); MODRM_MABS_IMM(0, addr, 4); OP4(imm); } while (0)
 
 
 
@@ -690,8 +762,24 @@ do { _arith_m32bd_imm_common(0, base, disp, imm); } while (0)
 
 
 
+#ifndef X86DRC_X64
 #define _and_r32_m32bd(dreg, base, disp) \
 do { OP1(0x23); MODRM_MBD(dreg, base, disp); } while (0)
+#else
+#define _and_r32_m32bd(dreg, base, disp) \
+do {														\
+	if (DISP_IS_FAR(disp))									\
+	{														\
+		_mov_r64_imm(REG_R11, disp);						\
+		OP_REX(0, dreg, base, REG_R11);						\
+		OP1(0x23); MODRM_MBISD(dreg, REG_R11 & 7, base, 1, 0);	\
+	}														\
+	else													\
+	{														\
+		OP1(0x23); MODRM_MBD(dreg, base, (FPTR)(disp));		\
+	}														\
+} while (0)
+#endif
 
 
 
@@ -743,11 +831,11 @@ do {												\
 	OP1(0x66);										\
 	if ((INT8)(imm) == (INT16)(imm))				\
 	{												\
-		OP1(0x83); MODRM_MABS(reg, addr); OP1(imm);	\
+		OP1(0x83); MODRM_MABS_IMM(reg, addr, 1); OP1(imm);	\
 	}												\
 	else											\
 	{												\
-		OP1(0x81); MODRM_MABS(reg, addr); OP2(imm);	\
+		OP1(0x81); MODRM_MABS_IMM(reg, addr, 2); OP2(imm);	\
 	}												\
 } while (0)
 
@@ -773,12 +861,12 @@ do { _arith_m16abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m16abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m16abs_imm(addr, imm) \
-do { OP1(0xf7); MODRM_MABS(0, addr); OP2(imm); } while (0)
+do { OP1(0xf7); MODRM_MABS_IMM(0, addr, 2); OP2(imm); } while (0)
 
 
 
 #define _arith_m8abs_imm_common(reg, addr, imm)		\
-do { OP1(0x80); MODRM_MABS(reg, addr); OP1(imm); } while (0)
+do { OP1(0x80); MODRM_MABS_IMM(reg, addr, 1); OP1(imm); } while (0)
 
 #define _add_m8abs_imm(addr, imm) \
 do { _arith_m8abs_imm_common(0, addr, imm); } while (0)
@@ -802,7 +890,7 @@ do { _arith_m8abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m8abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m8abs_imm(addr, imm) \
-do { OP1(0xf6); MODRM_MABS(0, addr); OP1(imm); } while (0)
+do { OP1(0xf6); MODRM_MABS_IMM(0, addr, 1); OP1(imm); } while (0)
 
 #define _and_m16bd_r16(base, disp, sreg) \
 do { OP1(0x66); OP1(0x21); MODRM_MBD(sreg, base, disp); } while (0)
@@ -863,8 +951,13 @@ do { OP1(0xdf); OP1(0xe0); } while (0)
 #define _fldcw_m16abs(addr) \
 do { OP1(0xd9); MODRM_MABS(5, addr); } while (0)
 
+#ifndef X86DRC_X64
 #define _fldcw_m16isd(indx, scale, addr) \
 do { OP1(0xd9); MODRM_MBISD(5, NO_BASE, indx, scale, addr); } while (0)
+#else
+#define _fldcw_m16isd(indx, scale, addr) \
+do { _mov_r64_imm(REG_R11, addr); OP_REX(0, 0, indx, REG_R11); OP1(0xd9); MODRM_MBISD(5, REG_R11 & 7, indx, scale, 0); } while (0)
+#endif
 
 #define _fnstcw_m16abs(addr) \
 do { OP1(0xd9); MODRM_MABS(7, addr); } while (0)
@@ -974,12 +1067,17 @@ do { OP1(0xeb); OP1(0x00); (link)->target = drc->cache_top; (link)->size = 1; }
 do { OP1(0xe9); OP4(0x00); (link)->target = drc->cache_top; (link)->size = 4; } while (0)
 
 #define _jmp(target) \
-do { OP1(0xe9); OP4((UINT32)(target) - ((UINT32)drc->cache_top + 4)); } while (0)
+do { OP1(0xe9); OP4((UINT8 *)(target) - (drc->cache_top + 4)); } while (0)
 
 
 
+#ifndef X86DRC_X64
+#define _call(target) \
+do { OP1(0xe8); OP4((UINT8 *)(target) - (drc->cache_top + 4)); } while (0)
+#else
 #define _call(target) \
-do { if (drc->uses_fp) OP1(0xe8); OP4((UINT32)(target) - ((UINT32)drc->cache_top + 4)); } while (0)
+do { drc_append_call(drc, (void *)(target), NULL); } while (0)
+#endif
 
 
 
@@ -1110,6 +1208,55 @@ do { OP1(0x66); OP1(0x0f); OP1(0xef); MODRM_REG(r1, r2); } while (0)
 
 
 
+/*###################################################################################################
+**	X86-64 OPCODE EMITTERS
+**#################################################################################################*/
+
+#ifdef X86DRC_X64
+
+/* a displacement holding a host address may not fit in 32 bits */
+#define DISP_IS_FAR(disp)	((INT64)(FPTR)(disp) != (INT32)(FPTR)(disp))
+
+#define _push_r64(reg) \
+do { if ((reg) >= 8) OP_REX(0, 0, 0, reg); OP1(0x50 + ((reg) & 7)); } while (0)
+
+#define _pop_r64(reg) \
+do { if ((reg) >= 8) OP_REX(0, 0, 0, reg); OP1(0x58 + ((reg) & 7)); } while (0)
+
+#define _mov_r64_imm(dreg, imm) \
+do { OP_REX(1, 0, 0, dreg); OP1(0xb8 + ((dreg) & 7)); OP8((FPTR)(imm)); } while (0)
+
+#define _mov_r64_r64(dreg, sreg) \
+do { OP_REX(1, sreg, 0, dreg); OP1(0x89); MODRM_REG(sreg, dreg); } while (0)
+
+#define _mov_r64_m64bd(dreg, base, disp) \
+do { OP_REX(1, dreg, 0, base); OP1(0x8b); MODRM_MBD(dreg, (base) & 7, disp); } while (0)
+
+#define _mov_r64_m64bisd(dreg, base, indx, scale, disp) \
+do { OP_REX(1, dreg, indx, base); OP1(0x8b); MODRM_MBISD(dreg, (base) & 7, indx, scale, disp); } while (0)
+
+#define _and_r64_imm8(dreg, imm) \
+do { OP_REX(1, 0, 0, dreg); OP1(0x83); MODRM_REG(4, dreg); OP1(imm); } while (0)
+
+#define _shr_r64_imm(dreg, imm) \
+do { OP_REX(1, 0, 0, dreg); OP1(0xc1); MODRM_REG(5, dreg); OP1(imm); } while (0)
+
+#define _call_r64(reg) \
+do { if ((reg) >= 8) OP_REX(0, 0, 0, reg); OP1(0xff); MODRM_REG(2, reg); } while (0)
+
+#define _cmp_m32r11_imm(imm) \
+do { OP_REX(0, 0, 0, REG_R11); OP1(0x81); OP1(0x3b); OP4(imm); } while (0)
+
+#define _cmp_m16r11_imm(imm) \
+do { OP1(0x66); OP_REX(0, 0, 0, REG_R11); OP1(0x81); OP1(0x3b); OP2(imm); } while (0)
+
+#define _cmp_m8r11_imm(imm) \
+do { OP_REX(0, 0, 0, REG_R11); OP1(0x80); OP1(0x3b); OP1(imm); } while (0)
+
+#endif
+
+
+
 /*###################################################################################################
 **	FUNCTION PROTOTYPES
 **#################################################################################################*/
@@ -1139,6 +1286,12 @@ void drc_append_verify_code(struct drccore *drc, void *code, UINT8 length);
 void drc_append_set_fp_rounding(struct drccore *drc, UINT8 regindex);
 void drc_append_set_temp_fp_rounding(struct drccore *drc, UINT8 rounding);
 void drc_append_restore_fp_rounding(struct drccore *drc);
+#ifdef X86DRC_X64
+void drc_append_call(struct drccore *drc, void *target, void *param);
+#endif
+
+/* true if generated code can address a host pointer directly */
+int drc_can_address(struct drccore *drc, const void *ptr);
 
 /* disassembling drc code */
 void drc_dasm(FILE *f, unsigned pc, void *begin, void *end);
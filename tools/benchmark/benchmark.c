@@ -0,0 +1,615 @@
+/*********************************************************************
+
+	benchmark.c
+
+	Headless per-driver benchmark harness for the mame2003-plus core.
+
+	The harness is linked directly against the core objects (see the
+	"benchmark" target in the Makefile) and drives it through the
+	regular libretro entry points with stub video, audio and input
+	callbacks. Each driver is run for a fixed number of frames as fast
+	as possible and the results are written as CSV or JSON:
+
+		mame2003_plus_benchmark -r roms/ -n 3000 pacman
+		mame2003_plus_benchmark -r roms/ -l tools/benchmark/drivers.txt -f json
+
+	Every driver runs in its own child process so that one crashing
+	romset does not abort a sweep, and so that the reported peak RSS
+	belongs to that driver alone.
+
+	Core options given with -o apply to every driver, so the core's own
+	instrumentation can be switched on for a sweep; for example
+	"-o mame2003-plus_sched_stats=enabled" leaves the per-frame scheduler
+	statistics of each driver in profile/<driver>_sched.csv under the
+	save directory.
+
+*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <libretro.h>
+
+#define BENCH_MAX_DRIVERS      1024
+#define BENCH_MAX_OPTIONS      64
+#define BENCH_MAX_NAME         64
+#define BENCH_MAX_PATH         1024
+#define BENCH_DEFAULT_FRAMES   3000
+#define BENCH_DEFAULT_WARMUP   60
+#define BENCH_STATE_ROUNDS     100
+
+
+/***************************************************************************
+
+	Result record passed from the child back to the parent
+
+***************************************************************************/
+
+enum
+{
+	BENCH_OK = 0,
+	BENCH_LOAD_FAILED,
+	BENCH_CRASHED
+};
+
+struct bench_result
+{
+	char   driver[BENCH_MAX_NAME];
+	int    status;
+	int    frames;
+	double load_ms;
+	double run_seconds;
+	double fps;
+	double target_fps;
+	double frame_ms_p50;
+	double frame_ms_p90;
+	double frame_ms_p99;
+	double frame_ms_max;
+	long   video_frames;
+	long   audio_samples;
+	long   peak_rss_kb;
+	long   state_size;
+	double state_save_us;
+	double state_load_us;
+};
+
+
+/***************************************************************************
+
+	Harness state
+
+***************************************************************************/
+
+struct bench_option
+{
+	char key[BENCH_MAX_NAME];
+	char value[BENCH_MAX_NAME];
+};
+
+static const char *rom_dir = ".";
+static const char *save_dir;
+static int frame_count = BENCH_DEFAULT_FRAMES;
+static int warmup_count = BENCH_DEFAULT_WARMUP;
+static int verbose;
+static int json_output;
+
+static struct bench_option defaults[BENCH_MAX_OPTIONS];
+static int default_count;
+static struct bench_option overrides[BENCH_MAX_OPTIONS];
+static int override_count;
+
+static long video_frames;
+static long audio_samples;
+
+
+/***************************************************************************
+
+	Timing helpers
+
+***************************************************************************/
+
+static double bench_now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static int bench_compare_double(const void *a, const void *b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+	return (da < db) ? -1 : (da > db) ? 1 : 0;
+}
+
+static double bench_percentile(const double *sorted, int count, double pct)
+{
+	int index;
+
+	if (count <= 0)
+		return 0.0;
+	index = (int)(pct * (double)(count - 1) / 100.0 + 0.5);
+	if (index >= count)
+		index = count - 1;
+	return sorted[index];
+}
+
+
+/***************************************************************************
+
+	Core option handling
+
+	The core registers its options with SET_VARIABLES; we remember the
+	first value of each one as its default so GET_VARIABLE behaves the
+	way a real frontend would, then apply any -o key=value overrides.
+
+***************************************************************************/
+
+static void bench_copy(char *dst, const char *src, size_t len)
+{
+	strncpy(dst, src, BENCH_MAX_NAME - 1);
+	dst[(len < BENCH_MAX_NAME - 1) ? len : BENCH_MAX_NAME - 1] = 0;
+}
+
+static void bench_register_variables(const struct retro_variable *vars)
+{
+	default_count = 0;
+	for ( ; vars->key && default_count < BENCH_MAX_OPTIONS; vars++)
+	{
+		const char *value = strstr(vars->value, "; ");
+		const char *end;
+
+		if (!value)
+			continue;
+		value += 2;
+		end = strchr(value, '|');
+
+		bench_copy(defaults[default_count].key, vars->key, strlen(vars->key));
+		bench_copy(defaults[default_count].value, value, end ? (size_t)(end - value) : strlen(value));
+		default_count++;
+	}
+}
+
+static const char *bench_find_option(const char *key)
+{
+	int i;
+
+	for (i = 0; i < override_count; i++)
+		if (!strcmp(overrides[i].key, key))
+			return overrides[i].value;
+	for (i = 0; i < default_count; i++)
+		if (!strcmp(defaults[i].key, key))
+			return defaults[i].value;
+	return NULL;
+}
+
+static int bench_add_override(const char *keyvalue)
+{
+	const char *eq = strchr(keyvalue, '=');
+	int i;
+
+	if (!eq)
+		return 0;
+
+	/* replace an existing override of the same key */
+	for (i = 0; i < override_count; i++)
+		if (strlen(overrides[i].key) == (size_t)(eq - keyvalue) && !strncmp(overrides[i].key, keyvalue, eq - keyvalue))
+			break;
+	if (i == BENCH_MAX_OPTIONS)
+		return 0;
+
+	bench_copy(overrides[i].key, keyvalue, eq - keyvalue);
+	bench_copy(overrides[i].value, eq + 1, strlen(eq + 1));
+	if (i == override_count)
+		override_count++;
+	return 1;
+}
+
+
+/***************************************************************************
+
+	libretro frontend callbacks
+
+***************************************************************************/
+
+static void bench_log(enum retro_log_level level, const char *fmt, ...)
+{
+	va_list args;
+
+	if (level < RETRO_LOG_WARN && verbose < 2)
+		return;
+	if (level < RETRO_LOG_ERROR && verbose < 1)
+		return;
+
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+static bool bench_environment(unsigned cmd, void *data)
+{
+	switch (cmd)
+	{
+		case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+			((struct retro_log_callback *)data)->log = bench_log;
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+		case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+			*(const char **)data = save_dir ? save_dir : rom_dir;
+			return true;
+
+		case RETRO_ENVIRONMENT_SET_VARIABLES:
+			bench_register_variables((const struct retro_variable *)data);
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_VARIABLE:
+		{
+			struct retro_variable *var = (struct retro_variable *)data;
+			var->value = bench_find_option(var->key);
+			return var->value != NULL;
+		}
+
+		case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+			*(bool *)data = false;
+			return true;
+
+		case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+		case RETRO_ENVIRONMENT_SET_ROTATION:
+		case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+		case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+		case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+			return true;
+	}
+
+	return false;
+}
+
+static void bench_video_refresh(const void *data, unsigned width, unsigned height, size_t pitch)
+{
+	if (data)
+		video_frames++;
+}
+
+static size_t bench_audio_batch(const int16_t *data, size_t frames)
+{
+	audio_samples += frames;
+	return frames;
+}
+
+static void bench_input_poll(void)
+{
+}
+
+static int16_t bench_input_state(unsigned port, unsigned device, unsigned idx, unsigned id)
+{
+	return 0;
+}
+
+
+/***************************************************************************
+
+	Benchmark a single driver (runs in the child process)
+
+***************************************************************************/
+
+static void bench_run_driver(const char *driver, struct bench_result *result)
+{
+	char path[BENCH_MAX_PATH];
+	struct retro_game_info info;
+	struct retro_system_av_info av_info;
+	struct rusage usage;
+	double *frame_ms;
+	double start, run_start;
+	int frame;
+
+	memset(result, 0, sizeof(*result));
+	bench_copy(result->driver, driver, strlen(driver));
+	result->status = BENCH_LOAD_FAILED;
+
+	snprintf(path, sizeof(path), "%s/%s.zip", rom_dir, driver);
+	memset(&info, 0, sizeof(info));
+	info.path = path;
+
+	frame_ms = calloc(frame_count, sizeof(*frame_ms));
+	if (!frame_ms)
+		return;
+
+	retro_set_environment(bench_environment);
+	retro_set_video_refresh(bench_video_refresh);
+	retro_set_audio_sample_batch(bench_audio_batch);
+	retro_set_input_poll(bench_input_poll);
+	retro_set_input_state(bench_input_state);
+	retro_init();
+
+	start = bench_now_ms();
+	if (!retro_load_game(&info))
+	{
+		free(frame_ms);
+		return;
+	}
+	result->load_ms = bench_now_ms() - start;
+
+	retro_get_system_av_info(&av_info);
+	result->target_fps = av_info.timing.fps;
+
+	/* warm up: let the driver get past its boot sequence before measuring */
+	for (frame = 0; frame < warmup_count; frame++)
+		retro_run();
+
+	video_frames = audio_samples = 0;
+	run_start = bench_now_ms();
+	for (frame = 0; frame < frame_count; frame++)
+	{
+		double frame_start = bench_now_ms();
+		retro_run();
+		frame_ms[frame] = bench_now_ms() - frame_start;
+	}
+	result->run_seconds = (bench_now_ms() - run_start) / 1000.0;
+
+	/* savestate round trips, as run-ahead and netplay do every frame */
+	result->state_size = retro_serialize_size();
+	if (result->state_size > 0)
+	{
+		void *state = malloc(result->state_size);
+		double save_ms = 0, load_ms = 0;
+		int round;
+
+		for (round = 0; state && round < BENCH_STATE_ROUNDS; round++)
+		{
+			double t0 = bench_now_ms(), t1;
+			if (!retro_serialize(state, result->state_size))
+				break;
+			t1 = bench_now_ms();
+			if (!retro_unserialize(state, result->state_size))
+				break;
+			save_ms += t1 - t0;
+			load_ms += bench_now_ms() - t1;
+		}
+		if (round == BENCH_STATE_ROUNDS)
+		{
+			result->state_save_us = save_ms * 1000.0 / BENCH_STATE_ROUNDS;
+			result->state_load_us = load_ms * 1000.0 / BENCH_STATE_ROUNDS;
+		}
+		free(state);
+	}
+
+	retro_unload_game();
+	retro_deinit();
+
+	qsort(frame_ms, frame_count, sizeof(*frame_ms), bench_compare_double);
+	result->status = BENCH_OK;
+	result->frames = frame_count;
+	result->fps = (result->run_seconds > 0) ? frame_count / result->run_seconds : 0;
+	result->frame_ms_p50 = bench_percentile(frame_ms, frame_count, 50);
+	result->frame_ms_p90 = bench_percentile(frame_ms, frame_count, 90);
+	result->frame_ms_p99 = bench_percentile(frame_ms, frame_count, 99);
+	result->frame_ms_max = frame_ms[frame_count - 1];
+	result->video_frames = video_frames;
+	result->audio_samples = audio_samples;
+
+	/* ru_maxrss is reported in kilobytes on Linux */
+	getrusage(RUSAGE_SELF, &usage);
+	result->peak_rss_kb = usage.ru_maxrss;
+
+	free(frame_ms);
+}
+
+
+/***************************************************************************
+
+	Fork a child for one driver and collect its result
+
+***************************************************************************/
+
+static void bench_driver(const char *driver, struct bench_result *result)
+{
+	int fds[2];
+	pid_t pid;
+	int status;
+
+	memset(result, 0, sizeof(*result));
+	bench_copy(result->driver, driver, strlen(driver));
+	result->status = BENCH_CRASHED;
+
+	if (pipe(fds) != 0)
+		return;
+
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return;
+	}
+
+	if (pid == 0)
+	{
+		struct bench_result child_result;
+		close(fds[0]);
+		bench_run_driver(driver, &child_result);
+		if (write(fds[1], &child_result, sizeof(child_result)) != sizeof(child_result))
+			_exit(1);
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	if (read(fds[0], result, sizeof(*result)) != sizeof(*result))
+	{
+		memset(result, 0, sizeof(*result));
+		bench_copy(result->driver, driver, strlen(driver));
+		result->status = BENCH_CRASHED;
+	}
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+}
+
+
+/***************************************************************************
+
+	Output
+
+***************************************************************************/
+
+static const char *bench_status_name(int status)
+{
+	switch (status)
+	{
+		case BENCH_OK:          return "ok";
+		case BENCH_LOAD_FAILED: return "load_failed";
+		default:                return "crashed";
+	}
+}
+
+static void bench_print_header(void)
+{
+	if (json_output)
+		printf("[\n");
+	else
+		printf("driver,status,frames,load_ms,seconds,fps,target_fps,speed_pct,frame_ms_p50,frame_ms_p90,frame_ms_p99,frame_ms_max,video_frames,audio_samples,peak_rss_kb,state_size,state_save_us,state_load_us\n");
+}
+
+static void bench_print_result(const struct bench_result *r, int index)
+{
+	double speed = (r->target_fps > 0) ? 100.0 * r->fps / r->target_fps : 0;
+
+	if (json_output)
+		printf("%s  { \"driver\": \"%s\", \"status\": \"%s\", \"frames\": %d, \"load_ms\": %.3f, \"seconds\": %.6f, "
+		       "\"fps\": %.3f, \"target_fps\": %.3f, \"speed_pct\": %.2f, \"frame_ms\": { \"p50\": %.4f, \"p90\": %.4f, "
+		       "\"p99\": %.4f, \"max\": %.4f }, \"video_frames\": %ld, \"audio_samples\": %ld, \"peak_rss_kb\": %ld, "
+		       "\"state\": { \"size\": %ld, \"save_us\": %.3f, \"load_us\": %.3f } }",
+		       index ? ",\n" : "", r->driver, bench_status_name(r->status), r->frames, r->load_ms, r->run_seconds,
+		       r->fps, r->target_fps, speed, r->frame_ms_p50, r->frame_ms_p90, r->frame_ms_p99, r->frame_ms_max,
+		       r->video_frames, r->audio_samples, r->peak_rss_kb, r->state_size, r->state_save_us, r->state_load_us);
+	else
+		printf("%s,%s,%d,%.3f,%.6f,%.3f,%.3f,%.2f,%.4f,%.4f,%.4f,%.4f,%ld,%ld,%ld,%ld,%.3f,%.3f\n",
+		       r->driver, bench_status_name(r->status), r->frames, r->load_ms, r->run_seconds,
+		       r->fps, r->target_fps, speed, r->frame_ms_p50, r->frame_ms_p90, r->frame_ms_p99, r->frame_ms_max,
+		       r->video_frames, r->audio_samples, r->peak_rss_kb, r->state_size, r->state_save_us, r->state_load_us);
+	fflush(stdout);
+}
+
+static void bench_print_footer(void)
+{
+	if (json_output)
+		printf("\n]\n");
+}
+
+
+/***************************************************************************
+
+	Command line
+
+***************************************************************************/
+
+static int bench_read_list(const char *filename, char drivers[][BENCH_MAX_NAME], int count)
+{
+	char line[256];
+	FILE *file = fopen(filename, "r");
+
+	if (!file)
+	{
+		fprintf(stderr, "cannot open driver list %s\n", filename);
+		return -1;
+	}
+
+	while (count < BENCH_MAX_DRIVERS && fgets(line, sizeof(line), file))
+	{
+		char *name = line + strspn(line, " \t");
+		size_t len = strcspn(name, " \t\r\n#");
+
+		/* skip blank lines and comments */
+		if (len == 0)
+			continue;
+		bench_copy(drivers[count++], name, len);
+	}
+
+	fclose(file);
+	return count;
+}
+
+static void bench_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [options] [driver ...]\n"
+		"  -r <dir>        directory holding the romsets (default: .)\n"
+		"  -s <dir>        system/save directory (default: the rom directory)\n"
+		"  -l <file>       file with one driver name per line ('#' starts a comment)\n"
+		"  -n <frames>     frames to measure per driver (default: %d)\n"
+		"  -w <frames>     warm-up frames excluded from the statistics (default: %d)\n"
+		"  -f csv|json     output format (default: csv)\n"
+		"  -o key=value    override a core option, may be repeated\n"
+		"  -v              log core warnings, -v -v logs everything\n",
+		argv0, BENCH_DEFAULT_FRAMES, BENCH_DEFAULT_WARMUP);
+}
+
+int main(int argc, char **argv)
+{
+	static char drivers[BENCH_MAX_DRIVERS][BENCH_MAX_NAME];
+	int driver_count = 0;
+	int failures = 0;
+	int opt, i;
+
+	/* no one is there to dismiss the startup screens */
+	bench_add_override("mame2003-plus_skip_disclaimer=enabled");
+	bench_add_override("mame2003-plus_skip_warnings=enabled");
+
+	while ((opt = getopt(argc, argv, "r:s:l:n:w:f:o:vh")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': rom_dir = optarg; break;
+			case 's': save_dir = optarg; break;
+			case 'n': frame_count = atoi(optarg); break;
+			case 'w': warmup_count = atoi(optarg); break;
+			case 'v': verbose++; break;
+			case 'f': json_output = !strcmp(optarg, "json"); break;
+			case 'l':
+				driver_count = bench_read_list(optarg, drivers, driver_count);
+				if (driver_count < 0)
+					return 1;
+				break;
+			case 'o':
+				if (!bench_add_override(optarg))
+				{
+					fprintf(stderr, "bad option override %s\n", optarg);
+					return 1;
+				}
+				break;
+			default:
+				bench_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	for (i = optind; i < argc && driver_count < BENCH_MAX_DRIVERS; i++)
+		bench_copy(drivers[driver_count++], argv[i], strlen(argv[i]));
+
+	if (driver_count == 0 || frame_count <= 0 || warmup_count < 0)
+	{
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	bench_print_header();
+	for (i = 0; i < driver_count; i++)
+	{
+		struct bench_result result;
+		bench_driver(drivers[i], &result);
+		bench_print_result(&result, i);
+		if (result.status != BENCH_OK)
+			failures++;
+	}
+	bench_print_footer();
+
+	return failures ? 2 : 0;
+}
@@ -0,0 +1,263 @@
+/*********************************************************************
+
+	blitbench.c
+
+	Micro-benchmark and bit-exactness check of the SIMD rectangle
+	blitters that drawgfx() uses in src/drawgfx.c.
+
+	The program is linked against the core objects (see the "blitbench"
+	target in the Makefile) and sets up just enough of Machine for
+	drawgfx(): a palette, a color table and a sheet of 8bpp elements.
+	For each of the modes that have SIMD versions it draws the same run
+	of sprites twice into 16 and 32bpp bitmaps:
+
+		scalar  with drawgfx_simd_init(0), through the blockmove_*
+		        functions
+		simd    with drawgfx_simd_init(1)
+
+	and prints the best time per sprite of three runs.  The sprites are
+	clipped at the bitmap edges and some of them are flipped, so the
+	flipx fallback and the skip and flipy handling are covered as well.
+	The two bitmaps are compared and any difference is reported:
+
+		mame2003_plus_blitbench [-n sprites] [-w width]
+
+	It exits with 1 if there was a difference.
+
+*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "driver.h"
+
+#define BLIT_ELEMENTS        64
+#define BLIT_COLORS          4			/* color codes, 256 pens each */
+#define BLIT_DEST_WIDTH      384
+#define BLIT_DEST_HEIGHT     256
+#define BLIT_DEFAULT_SPRITES 200000
+#define BLIT_DEFAULT_WIDTH   32
+#define BLIT_RUNS            3
+
+static UINT8 *sheet;
+static pen_t pens16[BLIT_COLORS * 256], pens32[BLIT_COLORS * 256];
+static UINT16 colortable[BLIT_COLORS * 256];
+static struct InternalMachineDriver drv;
+static struct GfxElement gfx;
+
+struct blit_sprite
+{
+	int code, color;
+	int flipx, flipy;
+	int x, y;
+};
+
+struct blit_mode
+{
+	const char *name;
+	int mode;
+	int transp;
+	int raw;		/* no color table, so that drawgfx picks the _RAW mode at 16bpp */
+};
+
+static const struct blit_mode modes[] =
+{
+	{ "pen",       TRANSPARENCY_PEN,       0,                     0 },
+	{ "pen raw",   TRANSPARENCY_PEN,       0,                     1 },
+	{ "pens",      TRANSPARENCY_PENS,      (1 << 0) | (1 << 7),   0 },
+	{ "pens raw",  TRANSPARENCY_PENS,      (1 << 0) | (1 << 7),   1 },
+	{ "color",     TRANSPARENCY_COLOR,     0,                     0 },
+	{ "alpha",     TRANSPARENCY_ALPHA,     0,                     0 }
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/***************************************************************************
+
+	Test data
+
+***************************************************************************/
+
+static int setup(int width)
+{
+	int i, x;
+
+	/* elements with transparent runs, so that skipping whole groups pays off */
+	sheet = malloc(BLIT_ELEMENTS * width * width);
+	if (!sheet)
+		return 1;
+	for (i = 0; i < BLIT_ELEMENTS * width * width; i += 8)
+	{
+		int run = rand() % 3;
+		for (x = 0; x < 8 && i + x < BLIT_ELEMENTS * width * width; x++)
+		{
+			int data = rand() & 0xff;
+			if (run == 0 || (run == 1 && (rand() & 1)))
+				data = 0;
+			if (data >= 32 && (rand() & 1))
+				data &= 0x1f;	/* keep plenty of pens for TRANSPARENCY_PENS */
+			sheet[i + x] = data;
+		}
+	}
+
+	gfx.width = gfx.height = width;
+	gfx.total_elements = BLIT_ELEMENTS;
+	gfx.color_granularity = 256;
+	gfx.total_colors = BLIT_COLORS;
+	gfx.gfxdata = sheet;
+	gfx.line_modulo = width;
+	gfx.char_modulo = width * width;
+
+	for (i = 0; i < BLIT_COLORS * 256; i++)
+	{
+		pens16[i] = rand() & 0x7fff;
+		pens32[i] = rand() & 0xffffff;
+		colortable[i] = 1 + rand() % 0x3f;
+	}
+	for (i = 0; i < BLIT_COLORS; i++)
+		colortable[i * 256] = colortable[i * 256 + 7] = 0;	/* TRANSPARENCY_COLOR drops pen 0 and one more */
+
+	drv.total_colors = BLIT_COLORS * 256;
+	Machine->drv = &drv;
+	Machine->game_colortable = colortable;
+
+	alpha_active = 1;
+	alpha_init();
+	alpha_set_level(0x60);
+	return 0;
+}
+
+static void fill_dest(struct mame_bitmap *bitmap)
+{
+	int x, y;
+	srand(1);
+	for (y = 0; y < bitmap->height; y++)
+		for (x = 0; x < bitmap->width; x++)
+		{
+			if (bitmap->depth == 16)
+				((UINT16 *)bitmap->line[y])[x] = rand() & 0x7fff;
+			else
+				((UINT32 *)bitmap->line[y])[x] = rand() & 0xffffff;
+		}
+}
+
+static int compare_dest(struct mame_bitmap *a, struct mame_bitmap *b)
+{
+	int y;
+	for (y = 0; y < a->height; y++)
+		if (memcmp(a->line[y], b->line[y], a->width * a->depth / 8))
+			return 1;
+	return 0;
+}
+
+
+/***************************************************************************
+
+	Main
+
+***************************************************************************/
+
+int main(int argc, char **argv)
+{
+	int count = BLIT_DEFAULT_SPRITES;
+	int width = BLIT_DEFAULT_WIDTH;
+	struct blit_sprite *sprites;
+	struct mame_bitmap *dest[2];
+	struct rectangle clip;
+	int failures = 0, simd;
+	int i, depth, way, run;
+	unsigned m;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			count = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			width = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [-n sprites] [-w width]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (count < 1 || width < 1 || width > 128)
+	{
+		fprintf(stderr, "sprites must be positive and the width at most 128\n");
+		return 1;
+	}
+
+	sprites = malloc(count * sizeof(*sprites));
+	if (!sprites || setup(width))
+		return 1;
+	for (i = 0; i < count; i++)
+	{
+		sprites[i].code = rand() % BLIT_ELEMENTS;
+		sprites[i].color = rand() % BLIT_COLORS;
+		sprites[i].flipx = (rand() % 8) == 0;
+		sprites[i].flipy = (rand() % 8) == 0;
+		sprites[i].x = rand() % (BLIT_DEST_WIDTH + width) - width / 2;
+		sprites[i].y = rand() % (BLIT_DEST_HEIGHT + width) - width / 2;
+	}
+	clip.min_x = 0;
+	clip.max_x = BLIT_DEST_WIDTH - 1;
+	clip.min_y = 0;
+	clip.max_y = BLIT_DEST_HEIGHT - 1;
+
+	simd = drawgfx_simd_init(1);
+	printf("SIMD blitters: %s\n", simd ? "enabled" : "not in this build or on this CPU, simd runs the scalar code");
+	printf("%d sprites of %dx%d, ns per sprite\n\n", count, width, width);
+	printf("%-10s %5s %9s %9s %8s\n", "mode", "depth", "scalar", "simd", "speedup");
+
+	for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+		for (depth = 16; depth <= 32; depth += 16)
+		{
+			double t[2];
+
+			Machine->remapped_colortable = (depth == 16) ? pens16 : pens32;
+			gfx.colortable = Machine->remapped_colortable;
+			drv.color_table_len = modes[m].raw ? 0 : BLIT_COLORS * 256;
+
+			for (way = 0; way < 2; way++)
+			{
+				dest[way] = bitmap_alloc_depth(BLIT_DEST_WIDTH, BLIT_DEST_HEIGHT, depth);
+				if (!dest[way])
+					return 1;
+				drawgfx_simd_init(way);
+				for (run = 0; run < BLIT_RUNS; run++)
+				{
+					double start, elapsed;
+
+					fill_dest(dest[way]);
+					start = now();
+					for (i = 0; i < count; i++)
+						drawgfx(dest[way], &gfx, sprites[i].code, sprites[i].color, sprites[i].flipx, sprites[i].flipy,
+								sprites[i].x, sprites[i].y, &clip, modes[m].mode, modes[m].transp);
+					elapsed = (now() - start) * 1e9 / count;
+					if (run == 0 || elapsed < t[way])
+						t[way] = elapsed;
+				}
+			}
+
+			printf("%-10s %5d %9.1f %9.1f %7.2fx", modes[m].name, depth, t[0], t[1], t[0] / t[1]);
+			if (compare_dest(dest[0], dest[1]))
+			{
+				printf("  MISMATCH");
+				failures++;
+			}
+			printf("\n");
+
+			for (way = 0; way < 2; way++)
+				bitmap_free(dest[way]);
+		}
+
+	free(sprites);
+	free(sheet);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,264 @@
+/*********************************************************************
+
+	tilemaptest.c
+
+	Bit-exactness check of the SIMD tilemap scanline blitters in
+	src/tilemap.c against the scalar ones they replace.
+
+	tilemap.c is included directly, for its static blitters, and the
+	program is linked against the other core objects (see the
+	"tilemaptest" target in the Makefile) for the palette and alpha
+	tables.  Every SIMD blitter is run next to its scalar version on
+	the same generated lines, and the destination and priority buffers
+	are compared.  The lines cover:
+
+		lengths      0 to 70 pixels, so both the vector groups and
+		             the scalar tail are taken
+		mask data    groups of eight that are all drawn, all skipped
+		             or mixed
+		mask/value   several byte pairs, and one wider than a byte
+		             that must go to the scalar code
+		pcode        several palette bases and priority codes
+		alpha        several levels for the blending blitters
+
+		mame2003_plus_tilemaptest [-s seeds]
+
+	It prints each failing case and exits with 1 if there was one.
+
+*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tilemap.c"
+
+#define TEST_MAX_COUNT       70
+#define TEST_DEFAULT_SEEDS   200
+#define TEST_CLUT_SIZE       0x400
+#define TEST_SOURCE_MASK     0x1ff		/* source pens, kept inside the clut with any base below */
+
+struct test_opaque
+{
+	const char *name;
+	blitopaque_t scalar, simd;
+	int blend;
+};
+
+struct test_masked
+{
+	const char *name;
+	blitmask_t scalar, simd;
+	int blend;
+};
+
+static const int mask_values[][2] =
+{
+	{ 0x1f, 0x10 },
+	{ 0xff, 0x00 },
+	{ 0xff, 0x80 },
+	{ 0x0f, 0x0f },
+	{ 0x01, 0x00 },
+	{ 0x30, 0x20 },
+	{ 0x1ff, 0x100 }
+};
+
+static const UINT32 pcodes[] =
+{
+	(0x000 << 16) | 0x00,
+	(0x100 << 16) | 0x25,
+	(0x1f0 << 16) | 0x80,
+	(0x0f0 << 16) | 0xff
+};
+
+static const int alpha_levels[] = { 0x00, 0x01, 0x60, 0x80, 0xfe, 0xff };
+
+static pen_t clut[TEST_CLUT_SIZE];
+static UINT32 seed;
+
+static int test_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+
+/***************************************************************************
+
+	Test data
+
+***************************************************************************/
+
+struct test_line
+{
+	UINT32 dest[2][TEST_MAX_COUNT + 8];
+	UINT8 pri[2][TEST_MAX_COUNT + 8];
+	UINT16 source[TEST_MAX_COUNT + 8];
+	UINT8 pMask[TEST_MAX_COUNT + 8];
+};
+
+/* a mask byte that passes the (byte & mask) == value test, or one that fails it */
+static UINT8 mask_byte(int mask, int value, int drawn)
+{
+	UINT8 data = (value & 0xff) | (test_rand() & ~mask & 0xff);
+	if (!drawn)
+		data ^= (mask & 0xff) & -(mask & 0xff);	/* flip the lowest bit the mask tests */
+	return data;
+}
+
+static void fill_line(struct test_line *line, int mask, int value)
+{
+	int i, run = 0;
+
+	for (i = 0; i < TEST_MAX_COUNT + 8; i++)
+	{
+		if ((i & 7) == 0)
+			run = test_rand() % 3;
+		line->dest[0][i] = line->dest[1][i] = ((test_rand() << 9) ^ test_rand()) & 0xffffff;
+		line->pri[0][i] = line->pri[1][i] = test_rand();
+		line->source[i] = test_rand() & TEST_SOURCE_MASK;
+		line->pMask[i] = mask_byte(mask, value, (run == 0) || (run == 2 && (test_rand() & 1)));
+	}
+}
+
+static int compare_line(const struct test_line *line)
+{
+	return memcmp(line->dest[0], line->dest[1], sizeof(line->dest[0])) == 0
+		&& memcmp(line->pri[0], line->pri[1], sizeof(line->pri[0])) == 0;
+}
+
+
+/***************************************************************************
+
+	Tests
+
+***************************************************************************/
+
+#ifdef TILEMAP_SIMD
+static const struct test_opaque opaque_tests[] =
+{
+	{ "pdo16",    (blitopaque_t)pdo16,    (blitopaque_t)pdo16_simd,    0 },
+	{ "pdo16pal", (blitopaque_t)pdo16pal, (blitopaque_t)pdo16pal_simd, 0 },
+	{ "pdo32",    (blitopaque_t)pdo32,    (blitopaque_t)pdo32_simd,    0 },
+	{ "pbo32",    (blitopaque_t)pbo32,    (blitopaque_t)pbo32_simd,    1 },
+	{ "npbo32",   (blitopaque_t)npbo32,   (blitopaque_t)npbo32_simd,   1 }
+};
+
+static const struct test_masked masked_tests[] =
+{
+	{ "pdt16",    (blitmask_t)pdt16,      (blitmask_t)pdt16_simd,      0 },
+	{ "pdt16pal", (blitmask_t)pdt16pal,   (blitmask_t)pdt16pal_simd,   0 },
+	{ "pdt16np",  (blitmask_t)pdt16np,    (blitmask_t)pdt16np_simd,    0 },
+	{ "pdt32",    (blitmask_t)pdt32,      (blitmask_t)pdt32_simd,      0 },
+	{ "npdt32",   (blitmask_t)npdt32,     (blitmask_t)npdt32_simd,     0 },
+	{ "pbt32",    (blitmask_t)pbt32,      (blitmask_t)pbt32_simd,      1 },
+	{ "npbt32",   (blitmask_t)npbt32,     (blitmask_t)npbt32_simd,     1 }
+};
+
+static int run_tests(int seeds)
+{
+	struct test_line line;
+	int failures = 0, cases = 0;
+	unsigned t, mv, pc, al, levels;
+	int s, count;
+
+	for (t = 0; t < ARRAY_LENGTH(opaque_tests); t++)
+	{
+		const struct test_opaque *test = &opaque_tests[t];
+		levels = test->blend ? ARRAY_LENGTH(alpha_levels) : 1;
+
+		for (al = 0; al < levels; al++)
+			for (pc = 0; pc < ARRAY_LENGTH(pcodes); pc++)
+				for (s = 0; s < seeds; s++)
+				{
+					seed = s + 1;
+					alpha_set_level(alpha_levels[al]);
+					count = s % (TEST_MAX_COUNT + 1);
+					fill_line(&line, 0xff, 0x00);
+					test->scalar(line.dest[0], line.source, count, line.pri[0], pcodes[pc]);
+					test->simd(line.dest[1], line.source, count, line.pri[1], pcodes[pc]);
+					cases++;
+					if (!compare_line(&line))
+					{
+						if (failures++ < 20)
+							printf("%-9s MISMATCH count %d pcode %08X alpha %02X seed %d\n",
+									test->name, count, pcodes[pc], alpha_levels[al], s + 1);
+					}
+				}
+	}
+
+	for (t = 0; t < ARRAY_LENGTH(masked_tests); t++)
+	{
+		const struct test_masked *test = &masked_tests[t];
+		levels = test->blend ? ARRAY_LENGTH(alpha_levels) : 1;
+
+		for (al = 0; al < levels; al++)
+			for (mv = 0; mv < ARRAY_LENGTH(mask_values); mv++)
+				for (pc = 0; pc < ARRAY_LENGTH(pcodes); pc++)
+					for (s = 0; s < seeds; s++)
+					{
+						int mask = mask_values[mv][0], value = mask_values[mv][1];
+
+						seed = s + 1;
+						alpha_set_level(alpha_levels[al]);
+						count = s % (TEST_MAX_COUNT + 1);
+						fill_line(&line, mask, value);
+						test->scalar(line.dest[0], line.source, line.pMask, mask, value, count, line.pri[0], pcodes[pc]);
+						test->simd(line.dest[1], line.source, line.pMask, mask, value, count, line.pri[1], pcodes[pc]);
+						cases++;
+						if (!compare_line(&line))
+						{
+							if (failures++ < 20)
+								printf("%-9s MISMATCH count %d mask %02X value %02X pcode %08X alpha %02X seed %d\n",
+										test->name, count, mask, value, pcodes[pc], alpha_levels[al], s + 1);
+						}
+					}
+	}
+
+	printf("%d cases, %d mismatches\n", cases, failures);
+	return failures;
+}
+#endif
+
+
+/***************************************************************************
+
+	Main
+
+***************************************************************************/
+
+int main(int argc, char **argv)
+{
+	int seeds = TEST_DEFAULT_SEEDS;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			seeds = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [-s seeds]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (seeds < 1)
+	{
+		fprintf(stderr, "the number of seeds must be positive\n");
+		return 1;
+	}
+
+	/* the 32bpp blitters look their pens up in Machine->remapped_colortable */
+	seed = 1;
+	for (i = 0; i < TEST_CLUT_SIZE; i++)
+		clut[i] = ((test_rand() << 9) ^ test_rand()) & 0xffffff;
+	Machine->remapped_colortable = clut;
+	alpha_init();
+
+#ifdef TILEMAP_SIMD
+	printf("SIMD tilemap blitters: enabled\n");
+	return run_tests(seeds) ? 1 : 0;
+#else
+	printf("SIMD tilemap blitters: not in this build, nothing to check\n");
+	return 0;
+#endif
+}